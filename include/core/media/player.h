@@ -24,6 +24,7 @@
 #include <core/property.h>
 
 #include <chrono>
+#include <future>
 #include <memory>
 
 namespace core
@@ -174,6 +175,23 @@ class Player : public std::enable_shared_from_this<Player>
     /** Signals all errors and warnings (typically from GStreamer and below) */
     virtual const core::Signal<Error>& error() const = 0;
 
+    // New virtual functions go below, the vtable layout is part of the ABI.
+
+    // Asynchronous variants of open_uri, next, previous, play, pause, stop and
+    // seek_to, the returned future becomes ready once the call completed.
+    // Calls are issued without waiting for replies to earlier ones, e.g. open,
+    // seek and play can be sent back to back and are still executed in order.
+    // Synchronous calls are not ordered behind outstanding asynchronous ones.
+    // Failures are reported through the future.
+    virtual std::future<bool> open_uri_async(const Track::UriType& uri);
+    virtual std::future<bool> open_uri_async(const Track::UriType& uri, const HeadersType&);
+    virtual std::future<void> next_async();
+    virtual std::future<void> previous_async();
+    virtual std::future<void> play_async();
+    virtual std::future<void> pause_async();
+    virtual std::future<void> stop_async();
+    virtual std::future<void> seek_to_async(const std::chrono::microseconds& offset);
+
   protected:
     Player();
 
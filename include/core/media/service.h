@@ -20,6 +20,7 @@
 
 #include <core/media/player.h>
 
+#include <future>
 #include <memory>
 
 namespace core
@@ -47,6 +48,14 @@ class Service : public std::enable_shared_from_this<Service>
     virtual std::shared_ptr<Player> resume_session(Player::PlayerKey) = 0;
     virtual void pause_other_sessions(Player::PlayerKey) = 0;
 
+    // New virtual functions go below, the vtable layout is part of the ABI.
+
+    // Asynchronous variants of create_session and pause_other_sessions, the
+    // request is sent right away and the returned future becomes ready once
+    // the service replied.
+    virtual std::future<std::shared_ptr<Player>> create_session_async(const Player::Configuration&);
+    virtual std::future<void> pause_other_sessions_async(Player::PlayerKey);
+
   protected:
     Service() = default;
 };
@@ -26,6 +26,7 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <vector>
 
 namespace core
 {
@@ -64,6 +65,11 @@ class TrackList : public std::enable_shared_from_this<TrackList>
     virtual const core::Signal<Track::Id>& on_track_removed() const = 0;
     virtual const core::Signal<Track::Id>& on_track_changed() const = 0;
 
+    // New virtual functions go below, the vtable layout is part of the ABI.
+
+    // Adds all uris in order in front of position. The default adds them one by one.
+    virtual void add_tracks_with_uri_at(const std::vector<Track::UriType>& uris, const Track::Id& position);
+
 protected:
     TrackList();
 };
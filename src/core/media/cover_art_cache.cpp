@@ -0,0 +1,412 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "cover_art_cache.h"
+
+#include "logger.h"
+#include "metrics.h"
+#include "scheduling.h"
+#include "trace.h"
+
+#include "gstreamer/init.h"
+#include "gstreamer/thumbnailer.h"
+
+#include <boost/filesystem.hpp>
+
+#include <glib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace media = core::ubuntu::media;
+namespace metrics = core::ubuntu::media::metrics;
+
+namespace
+{
+std::string default_directory()
+{
+    if (auto dir = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_COVER_ART_CACHE_DIR"))
+        return dir;
+
+    if (auto xdg = ::getenv("XDG_CACHE_HOME"))
+        return std::string{xdg} + "/media-hub/art";
+
+    auto home = ::getenv("HOME");
+    return std::string{home ? home : "/tmp"} + "/.cache/media-hub/art";
+}
+
+unsigned int default_size()
+{
+    auto size = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_COVER_ART_SIZE");
+    return size ? std::max(16, std::atoi(size)) : 256;
+}
+
+// Bounds the encoded images waiting for the worker, further ones are
+// dropped and looked at again the next time they are asked for.
+constexpr std::size_t max_queued_jobs{64};
+constexpr std::size_t max_queued_bytes{32 * 1024 * 1024};
+
+std::string album_key(const std::string& album, const std::string& artist)
+{
+    return album.empty() ? std::string{} : "album:" + album + "\n" + artist;
+}
+}
+
+std::string media::detail::content_address(const std::string& data)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : data)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+
+    std::stringstream ss; ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return ss.str();
+}
+
+int media::detail::cover_image_rank(std::string name)
+{
+    static const std::vector<std::string> names
+    {
+        "cover.jpg", "cover.png", "folder.jpg", "folder.png",
+        "front.jpg", "front.png", "album.jpg", "album.png", "albumart.jpg"
+    };
+
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    auto it = std::find(names.begin(), names.end(), name);
+    return it == names.end() ? 0 : names.size() - (it - names.begin());
+}
+
+boost::filesystem::path media::detail::best_cover_image_in(const boost::filesystem::path& folder)
+{
+    boost::filesystem::path best; int best_rank = 0;
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator it{folder, ec}, end; not ec && it != end; it.increment(ec))
+    {
+        const auto rank = cover_image_rank(it->path().filename().string());
+        if (rank > best_rank)
+        {
+            best = it->path();
+            best_rank = rank;
+        }
+    }
+
+    return best;
+}
+
+struct media::CoverArtCache::Private
+{
+    struct Job
+    {
+        enum class Type
+        {
+            image,
+            folder
+        };
+
+        Type type;
+        // The content address of an image or the uri of a directory
+        std::string key;
+        // The encoded image or the uri of a track in the directory
+        std::string payload;
+        std::string album_key;
+    };
+
+    Private()
+        : directory(default_directory()),
+          size(default_size()),
+          lru(256),
+          queued_bytes(0),
+          stop(false),
+          hits(metrics::counter("cover_art.lru_hits")),
+          misses(metrics::counter("cover_art.lru_misses")),
+          written(metrics::counter("cover_art.thumbnails_written")),
+          failures(metrics::counter("cover_art.thumbnail_failures")),
+          dropped(metrics::counter("cover_art.jobs_dropped")),
+          latency(metrics::histogram("cover_art.thumbnail_us"))
+    {
+        // Make sure GStreamer is torn down after the worker
+        gstreamer::init();
+        worker = std::thread(&Private::run, this);
+    }
+
+    ~Private()
+    {
+        {
+            std::lock_guard<std::mutex> lg(guard);
+            stop = true;
+        }
+        wakeup.notify_one();
+
+        if (worker.joinable())
+            worker.join();
+    }
+
+    std::string url_for(const std::string& address) const
+    {
+        return "file://" + directory + "/" + address + ".png";
+    }
+
+    void remember(const std::string& key, const std::string& url)
+    {
+        if (not key.empty() && not url.empty())
+            lru.put(key, url);
+    }
+
+    // Returns false if the queue is full and the job was dropped
+    bool enqueue(Job job)
+    {
+        if (jobs.size() >= max_queued_jobs || queued_bytes + job.payload.size() > max_queued_bytes)
+        {
+            dropped.increment();
+            return false;
+        }
+
+        queued_bytes += job.payload.size();
+        jobs.push_back(std::move(job));
+        wakeup.notify_one();
+        return true;
+    }
+
+    void run()
+    {
+        media::scheduling::apply(media::scheduling::Class::background);
+
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> ul(guard);
+                wakeup.wait(ul, [this]() { return stop || not jobs.empty(); });
+                if (stop)
+                    return;
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                queued_bytes -= job.payload.size();
+            }
+
+            if (job.type == Job::Type::image)
+                process_image(job);
+            else
+                process_folder(job);
+        }
+    }
+
+    // Writes the thumbnail for address unless it is already on disk
+    bool ensure_thumbnail(const std::string& address, const std::string& data)
+    {
+        const auto path = directory + "/" + address + ".png";
+
+        boost::system::error_code ec;
+        if (boost::filesystem::exists(path, ec))
+            return true;
+
+        boost::filesystem::create_directories(directory, ec);
+
+        metrics::ScopedTimer timer{latency};
+        const auto tmp = path + ".tmp";
+        if (not gstreamer::write_thumbnail(data, tmp, size))
+        {
+            failures.increment();
+            boost::filesystem::remove(tmp, ec);
+            return false;
+        }
+
+        boost::filesystem::rename(tmp, path, ec);
+        if (ec)
+        {
+            failures.increment();
+            return false;
+        }
+
+        written.increment();
+        return true;
+    }
+
+    void process_image(const Job& job)
+    {
+        MH_TRACE_SCOPE("cover_art", "process_image");
+        const bool written = ensure_thumbnail(job.key, job.payload);
+        if (not written)
+            MH_WARNING("Could not create a thumbnail of embedded cover art " << job.key);
+
+        std::lock_guard<std::mutex> lg(guard);
+        pending_images.erase(job.key);
+        if (not written)
+        {
+            failed.insert(job.key);
+            return;
+        }
+
+        lru.put("image:" + job.key, url_for(job.key));
+        remember(job.album_key, url_for(job.key));
+    }
+
+    void process_folder(const Job& job)
+    {
+        MH_TRACE_SCOPE("cover_art", "process_folder");
+
+        std::string url;
+
+        gchar* filename = g_filename_from_uri(job.payload.c_str(), nullptr, nullptr);
+        if (filename != nullptr)
+        {
+            const auto best = detail::best_cover_image_in(boost::filesystem::path{filename}.parent_path());
+            g_free(filename);
+
+            if (not best.empty())
+            {
+                std::ifstream in(best.string(), std::ios::binary);
+                std::stringstream data; data << in.rdbuf();
+
+                const auto address = detail::content_address(data.str());
+                if (ensure_thumbnail(address, data.str()))
+                    url = url_for(address);
+            }
+        }
+
+        std::lock_guard<std::mutex> lg(guard);
+        pending_folders.erase(job.key);
+        // Remembered even if empty, such that the folder isn't searched again
+        lru.put("folder:" + job.key, url);
+        remember(job.album_key, url);
+    }
+
+    const std::string directory;
+    const unsigned int size;
+
+    std::mutex guard;
+    std::condition_variable wakeup;
+    detail::Lru lru;
+    std::deque<Job> jobs;
+    std::size_t queued_bytes;
+    std::set<std::string> pending_images;
+    std::set<std::string> pending_folders;
+    std::set<std::string> failed;
+    bool stop;
+
+    metrics::Counter& hits;
+    metrics::Counter& misses;
+    metrics::Counter& written;
+    metrics::Counter& failures;
+    metrics::Counter& dropped;
+    metrics::Histogram& latency;
+
+    std::thread worker;
+};
+
+media::CoverArtCache& media::CoverArtCache::instance()
+{
+    static media::CoverArtCache cache;
+    return cache;
+}
+
+media::CoverArtCache::CoverArtCache() : d(new Private())
+{
+}
+
+media::CoverArtCache::~CoverArtCache()
+{
+}
+
+std::string media::CoverArtCache::art_url_for_image(
+        const std::string& data,
+        const std::string& album,
+        const std::string& artist)
+{
+    const auto address = detail::content_address(data);
+
+    std::lock_guard<std::mutex> lg(d->guard);
+    if (d->failed.count(address) > 0)
+        return std::string{};
+
+    std::string cached;
+    if (d->lru.get("image:" + address, cached))
+    {
+        d->hits.increment();
+        d->remember(album_key(album, artist), cached);
+        return cached;
+    }
+
+    // Thumbnails already on disk are picked up by the worker without decoding
+    if (d->pending_images.count(address) == 0)
+    {
+        d->misses.increment();
+        if (d->enqueue(Private::Job{Private::Job::Type::image, address, data, album_key(album, artist)}))
+            d->pending_images.insert(address);
+    }
+
+    return std::string{};
+}
+
+std::string media::CoverArtCache::art_url_for_folder_of(
+        const std::string& uri,
+        const std::string& album,
+        const std::string& artist)
+{
+    static const std::string scheme{"file://"};
+    if (uri.compare(0, scheme.size(), scheme) != 0)
+        return std::string{};
+
+    const auto folder = uri.substr(0, uri.rfind('/'));
+
+    std::lock_guard<std::mutex> lg(d->guard);
+
+    std::string cached;
+    if (d->lru.get("folder:" + folder, cached))
+    {
+        d->hits.increment();
+        d->remember(album_key(album, artist), cached);
+        return cached;
+    }
+
+    if (d->pending_folders.count(folder) == 0)
+    {
+        d->misses.increment();
+        if (d->enqueue(Private::Job{Private::Job::Type::folder, folder, uri, album_key(album, artist)}))
+            d->pending_folders.insert(folder);
+    }
+
+    return std::string{};
+}
+
+std::string media::CoverArtCache::art_url_for_album(const std::string& album, const std::string& artist)
+{
+    const auto key = album_key(album, artist);
+    if (key.empty())
+        return std::string{};
+
+    std::lock_guard<std::mutex> lg(d->guard);
+
+    std::string cached;
+    d->lru.get(key, cached);
+    return cached;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CORE_UBUNTU_MEDIA_COVER_ART_CACHE_H_
+#define CORE_UBUNTU_MEDIA_COVER_ART_CACHE_H_
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+namespace detail
+{
+// Least recently used mapping of keys to urls
+class Lru
+{
+public:
+    explicit Lru(std::size_t capacity) : capacity(capacity)
+    {
+    }
+
+    bool get(const std::string& key, std::string& value)
+    {
+        auto it = index.find(key);
+        if (it == index.end())
+            return false;
+
+        entries.splice(entries.begin(), entries, it->second);
+        value = it->second->second;
+        return true;
+    }
+
+    void put(const std::string& key, const std::string& value)
+    {
+        auto it = index.find(key);
+        if (it != index.end())
+        {
+            it->second->second = value;
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+
+        entries.emplace_front(key, value);
+        index[key] = entries.begin();
+
+        if (entries.size() > capacity)
+        {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+    void erase(const std::string& key)
+    {
+        auto it = index.find(key);
+        if (it == index.end())
+            return;
+
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    std::size_t size() const
+    {
+        return entries.size();
+    }
+
+private:
+    typedef std::list<std::pair<std::string, std::string>> Entries;
+
+    std::size_t capacity;
+    Entries entries;
+    std::unordered_map<std::string, Entries::iterator> index;
+};
+
+// 64 bit FNV-1a of the data as 16 hex digits, good enough to tell thumbnails apart
+std::string content_address(const std::string& data);
+
+// Rank of a file name among the usual names of cover images, 0 if it isn't one
+int cover_image_rank(std::string name);
+
+// The best ranked cover image in folder, empty if there is none
+boost::filesystem::path best_cover_image_in(const boost::filesystem::path& folder);
+}
+
+// Content addressed on-disk cache of cover art thumbnails with an in-memory
+// LRU in front. Images are decoded and scaled on a background worker, callers
+// only ever hash data and consult memory.
+//
+// Thumbnails are stored in CORE_UBUNTU_MEDIA_SERVICE_COVER_ART_CACHE_DIR,
+// defaulting to $XDG_CACHE_HOME/media-hub/art, and are scaled to
+// CORE_UBUNTU_MEDIA_SERVICE_COVER_ART_SIZE pixels, defaulting to 256.
+class CoverArtCache
+{
+public:
+    static CoverArtCache& instance();
+
+    CoverArtCache(const CoverArtCache&) = delete;
+    ~CoverArtCache();
+
+    CoverArtCache& operator=(const CoverArtCache&) = delete;
+
+    // Returns the file:// url of the thumbnail of the encoded image. Empty
+    // until the thumbnail has been written, the first call schedules that.
+    std::string art_url_for_image(const std::string& data, const std::string& album, const std::string& artist);
+
+    // Returns the url of the thumbnail of a cover image in the directory of a
+    // local track. Empty while the directory has not been looked at yet or
+    // if it does not contain any, the first call schedules the lookup.
+    std::string art_url_for_folder_of(const std::string& uri, const std::string& album, const std::string& artist);
+
+    // Returns the art last seen for an album, empty if unknown. Never touches
+    // the disk.
+    std::string art_url_for_album(const std::string& album, const std::string& artist);
+
+private:
+    CoverArtCache();
+
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+}
+}
+}
+
+#endif // CORE_UBUNTU_MEDIA_COVER_ART_CACHE_H_
@@ -18,6 +18,8 @@
 
 #include "cover_art_resolver.h"
 
+#include "cover_art_cache.h"
+
 core::ubuntu::media::CoverArtResolver core::ubuntu::media::always_missing_cover_art_resolver()
 {
     return [](const std::string&, const std::string&, const std::string&)
@@ -25,3 +27,13 @@ core::ubuntu::media::CoverArtResolver core::ubuntu::media::always_missing_cover_
         return "file:///usr/share/unity/icons/album_missing.png";
     };
 }
+
+core::ubuntu::media::CoverArtResolver core::ubuntu::media::cached_cover_art_resolver()
+{
+    auto missing = always_missing_cover_art_resolver();
+    return [missing](const std::string& title, const std::string& album, const std::string& artist)
+    {
+        auto url = core::ubuntu::media::CoverArtCache::instance().art_url_for_album(album, artist);
+        return url.empty() ? missing(title, album, artist) : url;
+    };
+}
@@ -43,6 +43,11 @@ typedef std::function
 // Return a CoverArtResolver that always resolves to
 // file:///usr/share/unity/icons/album_missing.png
 CoverArtResolver always_missing_cover_art_resolver();
+
+// Return a CoverArtResolver that serves the thumbnail CoverArtCache last saw
+// for the album, falling back to always_missing_cover_art_resolver(). Only
+// consults memory and never blocks.
+CoverArtResolver cached_cover_art_resolver();
 }
 }
 }
@@ -34,6 +34,16 @@ double media::Engine::Volume::max()
     return 1.;
 }
 
+media::Player::PlaybackRate media::Engine::min_playback_rate()
+{
+    return -8.;
+}
+
+media::Player::PlaybackRate media::Engine::max_playback_rate()
+{
+    return 8.;
+}
+
 media::Engine::Volume::Volume(double v) : value(v)
 {
     if (value < min() || value > max())
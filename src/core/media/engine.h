@@ -58,6 +58,22 @@ public:
         double value;
     };
 
+    // How precisely a seek should land on the requested position.
+    enum class SeekAccuracy
+    {
+        // Jump to the key frame preceding the requested position.
+        // Cheapest mode, suited for scrubbing.
+        key_unit,
+        // Jump to the key frame closest to the requested position.
+        snap_nearest,
+        // Decode up to the exact requested position.
+        accurate
+    };
+
+    // Range of playback rates the engine honours, negative rates play backwards.
+    static Player::PlaybackRate min_playback_rate();
+    static Player::PlaybackRate max_playback_rate();
+
     class MetaDataExtractor
     {
     public:
@@ -84,6 +100,14 @@ public:
     virtual bool pause() = 0;
     virtual bool seek_to(const std::chrono::microseconds& ts) = 0;
 
+    // Releases everything the pipeline holds on to while remembering the uri
+    // and position. The next play() or pause() transparently restores it.
+    virtual bool hibernate() = 0;
+    virtual bool is_hibernated() const = 0;
+    // Opens uri in hibernation, i.e. without touching the pipeline. The next
+    // play() or pause() builds it and starts out at position.
+    virtual bool restore_resource_for_uri(const Track::UriType& uri, const std::chrono::microseconds& position) = 0;
+
     virtual const core::Property<bool>& is_video_source() const = 0;
     virtual const core::Property<bool>& is_audio_source() const = 0;
 
@@ -98,6 +122,12 @@ public:
 
     virtual const core::Property<core::ubuntu::media::Player::Orientation>& orientation() const = 0;
 
+    virtual const core::Property<SeekAccuracy>& seek_accuracy() const = 0;
+    virtual core::Property<SeekAccuracy>& seek_accuracy() = 0;
+
+    virtual const core::Property<Player::PlaybackRate>& playback_rate() const = 0;
+    virtual core::Property<Player::PlaybackRate>& playback_rate() = 0;
+
     virtual const core::Property<core::ubuntu::media::Player::Lifetime>& lifetime() const = 0;
     virtual core::Property<core::ubuntu::media::Player::Lifetime>& lifetime() = 0;
 
@@ -105,6 +135,8 @@ public:
 
     virtual const core::Signal<void>& about_to_finish_signal() const = 0;
     virtual const core::Signal<uint64_t>& seeked_to_signal() const = 0;
+    // Fill level of the network buffer in percent, emitted while streaming
+    virtual const core::Signal<int>& buffering_signal() const = 0;
     virtual const core::Signal<void>& client_disconnected_signal() const = 0;
     virtual const core::Signal<void>& end_of_stream_signal() const = 0;
     virtual const core::Signal<core::ubuntu::media::Player::PlaybackStatus>& playback_status_changed_signal() const = 0;
@@ -19,15 +19,23 @@
 #ifndef GSTREAMER_BUS_H_
 #define GSTREAMER_BUS_H_
 
+#include "../metrics.h"
+#include "../scheduling.h"
+#include "../trace.h"
+
 #include <core/property.h>
 
 #include <gst/gst.h>
 
 #include <boost/flyweight.hpp>
 
+#include <array>
 #include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <string>
 #include <tuple>
 
 namespace gstreamer
@@ -268,6 +276,28 @@ public:
         std::function<void()> cleanup;
     };
 
+    // Counts bus messages by type, extended types share a single counter
+    static void count_message(GstMessageType type)
+    {
+        static const std::array<core::ubuntu::media::metrics::Counter*, 32> counters = []()
+        {
+            std::array<core::ubuntu::media::metrics::Counter*, 32> result;
+            for (std::size_t i = 0; i < result.size(); i++)
+            {
+                const GstMessageType t = static_cast<GstMessageType>(1u << i);
+                result[i] = &core::ubuntu::media::metrics::counter(
+                            std::string{"gst.bus.messages."} + gst_message_type_get_name(t));
+            }
+            return result;
+        }();
+
+        if (type == GST_MESSAGE_UNKNOWN)
+            return;
+
+        const unsigned int bits = static_cast<unsigned int>(type);
+        counters[(bits & GST_MESSAGE_EXTENDED) ? 31 : __builtin_ctz(bits)]->increment();
+    }
+
     static GstBusSyncReply sync_handler(
             GstBus* bus,
             GstMessage* msg,
@@ -275,14 +305,24 @@ public:
     {
         (void) bus;
 
+        MH_TRACE_SCOPE("gst.bus", GST_MESSAGE_TYPE_NAME(msg));
+        count_message(GST_MESSAGE_TYPE(msg));
+
         auto thiz = static_cast<Bus*>(data);
+        if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_STREAM_STATUS)
+            thiz->on_stream_status(msg);
+
         Message message(msg);
         thiz->on_new_message(message);
 
         return GST_BUS_DROP;
     }
 
-    Bus(GstBus* bus) : bus(bus)
+    Bus(GstBus* bus)
+        : bus(bus),
+          task_pool(nullptr),
+          scheduled(false),
+          scheduling_class(core::ubuntu::media::scheduling::Class::multimedia)
     {
         if (!bus)
             throw std::runtime_error("Cannot create Bus instance if underlying instance is NULL.");
@@ -299,7 +339,76 @@ public:
         gst_object_unref(bus);
     }
 
+    // Runs the streaming tasks of the pipeline on threads from pool, nullptr
+    // leaves them on the GStreamer default pool. Needs to happen before the
+    // pipeline leaves NULL.
+    void use_task_pool(GstTaskPool* pool)
+    {
+        task_pool = pool;
+    }
+
+    // Schedules the streaming threads of the pipeline according to the policy
+    // of the class, including the ones already streaming.
+    void use_scheduling(core::ubuntu::media::scheduling::Class c)
+    {
+        std::lock_guard<std::mutex> lg(streaming_threads_guard);
+        scheduled = true;
+        scheduling_class = c;
+
+        for (auto tid : streaming_threads)
+            core::ubuntu::media::scheduling::apply(c, tid);
+    }
+
+    // Tasks announce themselves from the thread starting them before they run,
+    // and from their own thread when entering and leaving it.
+    void on_stream_status(GstMessage* msg)
+    {
+        GstStreamStatusType type;
+        GstElement* owner;
+        gst_message_parse_stream_status(msg, &type, &owner);
+
+        switch (type)
+        {
+        case GST_STREAM_STATUS_TYPE_CREATE:
+        {
+            if (task_pool == nullptr)
+                break;
+
+            const GValue* value = gst_message_get_stream_status_object(msg);
+            if (value != nullptr && G_VALUE_TYPE(value) == GST_TYPE_TASK)
+                gst_task_set_pool(GST_TASK(g_value_get_object(value)), task_pool);
+            break;
+        }
+        case GST_STREAM_STATUS_TYPE_ENTER:
+        {
+            std::lock_guard<std::mutex> lg(streaming_threads_guard);
+            if (not scheduled)
+                break;
+
+            streaming_threads.insert(core::ubuntu::media::scheduling::current_thread());
+            core::ubuntu::media::scheduling::apply(scheduling_class);
+            break;
+        }
+        case GST_STREAM_STATUS_TYPE_LEAVE:
+        {
+            std::lock_guard<std::mutex> lg(streaming_threads_guard);
+            streaming_threads.erase(core::ubuntu::media::scheduling::current_thread());
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
     GstBus* bus;
+    GstTaskPool* task_pool;
+
+    std::mutex streaming_threads_guard;
+    bool scheduled;
+    core::ubuntu::media::scheduling::Class scheduling_class;
+    // Threads currently running a task of the pipeline
+    std::set<pid_t> streaming_threads;
+
     core::Signal<Message> on_new_message;
 };
 }
@@ -22,31 +22,19 @@
 
 #include "bus.h"
 #include "engine.h"
+#include "../logger.h"
+#include "../metrics.h"
 #include "meta_data_extractor.h"
 #include "playbin.h"
+#include "../trace.h"
 
 #include <cassert>
+#include <mutex>
 
 namespace media = core::ubuntu::media;
 
 using namespace std;
 
-namespace gstreamer
-{
-struct Init
-{
-    Init()
-    {
-        gst_init(nullptr, nullptr);
-    }
-
-    ~Init()
-    {
-        gst_deinit();
-    }
-} init;
-}
-
 struct gstreamer::Engine::Private
 {
     void on_playbin_state_changed(
@@ -67,8 +55,8 @@ struct gstreamer::Engine::Private
             case GST_CORE_ERROR_MISSING_PLUGIN:
                 return media::Player::Error::format_error;
             default:
-                std::cerr << "Got an unhandled core error: '"
-                    << ewi.debug << "' (code: " << ewi.error->code << ")" << std::endl;
+                MH_ERROR("Got an unhandled core error: '"
+                         << ewi.debug << "' (code: " << ewi.error->code << ")");
                 return media::Player::Error::no_error;
             }
         }
@@ -85,8 +73,8 @@ struct gstreamer::Engine::Private
             case GST_RESOURCE_ERROR_NOT_AUTHORIZED:
                 return media::Player::Error::access_denied_error;
             default:
-                std::cerr << "Got an unhandled resource error: '"
-                    << ewi.debug << "' (code: " << ewi.error->code << ")" << std::endl;
+                MH_ERROR("Got an unhandled resource error: '"
+                         << ewi.debug << "' (code: " << ewi.error->code << ")");
                 return media::Player::Error::no_error;
             }
         }
@@ -97,8 +85,8 @@ struct gstreamer::Engine::Private
             case GST_STREAM_ERROR_CODEC_NOT_FOUND:
                 return media::Player::Error::format_error;
             default:
-                std::cerr << "Got an unhandled stream error: '"
-                    << ewi.debug << "' (code: " << ewi.error->code << ")" << std::endl;
+                MH_ERROR("Got an unhandled stream error: '"
+                         << ewi.debug << "' (code: " << ewi.error->code << ")");
                 return media::Player::Error::no_error;
             }
         }
@@ -108,6 +96,7 @@ struct gstreamer::Engine::Private
 
     void on_playbin_error(const gstreamer::Bus::Message::Detail::ErrorWarningInfo& ewi)
     {
+        MH_TRACE_INSTANT("pipeline", "error");
         const media::Player::Error e = from_gst_errorwarning(ewi);
         if (e != media::Player::Error::no_error)
             error(e);
@@ -122,13 +111,14 @@ struct gstreamer::Engine::Private
 
     void on_playbin_info(const gstreamer::Bus::Message::Detail::ErrorWarningInfo& ewi)
     {
-        std::cerr << "Got a playbin info message (no action taken): " << ewi.debug << std::endl;
+        MH_INFO("Got a playbin info message (no action taken): " << ewi.debug);
     }
 
     void on_tag_available(const gstreamer::Bus::Message::Detail::Tag& tag)
     {
         media::Track::MetaData md;
         gstreamer::MetaDataExtractor::on_tag_available(tag, md);
+        gstreamer::MetaDataExtractor::on_folder_art_wanted(playbin.uri(), md);
         track_meta_data.set(std::make_tuple(playbin.uri(), md));
     }
 
@@ -149,6 +139,16 @@ struct gstreamer::Engine::Private
         orientation.set(o);
     }
 
+    void on_seek_accuracy_changed(const media::Engine::SeekAccuracy& accuracy)
+    {
+        playbin.set_seek_accuracy(accuracy);
+    }
+
+    void on_playback_rate_changed(const media::Player::PlaybackRate& rate)
+    {
+        playbin.set_rate(rate);
+    }
+
     void on_lifetime_changed(const media::Player::Lifetime& lifetime)
     {
         playbin.set_lifetime(lifetime);
@@ -156,6 +156,7 @@ struct gstreamer::Engine::Private
 
     void on_about_to_finish()
     {
+        MH_TRACE_INSTANT("pipeline", "about_to_finish");
         state = Engine::State::ready;
         about_to_finish();
     }
@@ -165,6 +166,11 @@ struct gstreamer::Engine::Private
         seeked_to(value);
     }
 
+    void on_buffering(int percent)
+    {
+        buffering(percent);
+    }
+
     void on_client_disconnected()
     {
         client_disconnected();
@@ -172,6 +178,7 @@ struct gstreamer::Engine::Private
 
     void on_end_of_stream()
     {
+        MH_TRACE_INSTANT("pipeline", "end_of_stream");
         end_of_stream();
     }
 
@@ -180,10 +187,49 @@ struct gstreamer::Engine::Private
         video_dimension_changed(height, width);
     }
 
+    void discard_checkpoint()
+    {
+        if (!hibernated)
+            return;
+
+        set_hibernated(false);
+        media::metrics::gauge("gst.pipelines.hibernated").add(-1);
+    }
+
+    void set_hibernated(bool value)
+    {
+        std::lock_guard<std::mutex> lg(checkpoint_guard);
+        hibernated = value;
+    }
+
+    // Brings a hibernated pipeline back to PAUSED at the position it was left at
+    bool restore_from_hibernation()
+    {
+        if (!hibernated)
+            return true;
+
+        MH_TRACE_SCOPE("engine", "restore_from_hibernation");
+
+        discard_checkpoint();
+        MH_DEBUG("Restoring hibernated pipeline for " << checkpoint.uri);
+
+        playbin.set_uri(checkpoint.uri, checkpoint.headers);
+        if (!playbin.set_state_and_wait(GST_STATE_PAUSED))
+            return false;
+
+        if (checkpoint.position > 0)
+            playbin.seek(std::chrono::microseconds(checkpoint.position / 1000));
+
+        return true;
+    }
+
     Private()
         : meta_data_extractor(new gstreamer::MetaDataExtractor()),
           volume(media::Engine::Volume(1.)),
           orientation(media::Player::Orientation::rotate0),
+          seek_accuracy(playbin.seek_accuracy),
+          playback_rate(1.),
+          hibernated(false),
           is_video_source(false),
           is_audio_source(false),
           about_to_finish_connection(
@@ -239,6 +285,18 @@ struct gstreamer::Engine::Private
                       &Private::on_orientation_changed,
                       this,
                       std::placeholders::_1))),
+          on_seek_accuracy_changed_connection(
+              seek_accuracy.changed().connect(
+                  std::bind(
+                      &Private::on_seek_accuracy_changed,
+                      this,
+                      std::placeholders::_1))),
+          on_playback_rate_changed_connection(
+              playback_rate.changed().connect(
+                  std::bind(
+                      &Private::on_playback_rate_changed,
+                      this,
+                      std::placeholders::_1))),
           on_lifetime_changed_connection(
               lifetime.changed().connect(
                   std::bind(
@@ -251,6 +309,12 @@ struct gstreamer::Engine::Private
                       &Private::on_seeked_to,
                       this,
                       std::placeholders::_1))),
+          on_buffering_connection(
+              playbin.signals.on_buffering.connect(
+                  std::bind(
+                      &Private::on_buffering,
+                      this,
+                      std::placeholders::_1))),
           client_disconnected_connection(
               playbin.signals.client_disconnected.connect(
                   std::bind(
@@ -283,10 +347,31 @@ struct gstreamer::Engine::Private
     core::Property<media::Engine::Volume> volume;
     core::Property<media::Player::AudioStreamRole> audio_role;
     core::Property<media::Player::Orientation> orientation;
+    core::Property<media::Engine::SeekAccuracy> seek_accuracy;
+    core::Property<media::Player::PlaybackRate> playback_rate;
     core::Property<media::Player::Lifetime> lifetime;
     core::Property<bool> is_video_source;
     core::Property<bool> is_audio_source;
 
+    // What a hibernated pipeline needs to be restored
+    struct
+    {
+        media::Track::UriType uri;
+        media::Player::HeadersType headers;
+        uint64_t position;
+        uint64_t duration;
+        gstreamer::Playbin::MediaFileType file_type;
+    } checkpoint;
+    bool hibernated;
+    // Hibernation is driven from the service's timer thread, while play/pause/seek
+    // come in via D-Bus. Recursive as state changes call back into the engine.
+    std::recursive_mutex hibernation_guard;
+    // Writes to hibernated and, while hibernated, to the checkpoint happen with
+    // both mutexes held. position() and duration() are also called from
+    // streaming threads and only take this one: hibernation_guard is held
+    // across state changes that wait for those threads.
+    std::mutex checkpoint_guard;
+
     core::ScopedConnection about_to_finish_connection;
     core::ScopedConnection on_state_changed_connection;
     core::ScopedConnection on_error_connection;
@@ -296,14 +381,18 @@ struct gstreamer::Engine::Private
     core::ScopedConnection on_volume_changed_connection;
     core::ScopedConnection on_audio_stream_role_changed_connection;
     core::ScopedConnection on_orientation_changed_connection;
+    core::ScopedConnection on_seek_accuracy_changed_connection;
+    core::ScopedConnection on_playback_rate_changed_connection;
     core::ScopedConnection on_lifetime_changed_connection;
     core::ScopedConnection on_seeked_to_connection;
+    core::ScopedConnection on_buffering_connection;
     core::ScopedConnection client_disconnected_connection;
     core::ScopedConnection on_end_of_stream_connection;
     core::ScopedConnection on_video_dimension_changed_connection;
 
     core::Signal<void> about_to_finish;
     core::Signal<uint64_t> seeked_to;
+    core::Signal<int> buffering;
     core::Signal<void> client_disconnected;
     core::Signal<void> end_of_stream;
     core::Signal<media::Player::PlaybackStatus> playback_status_changed;
@@ -313,12 +402,16 @@ struct gstreamer::Engine::Private
 
 gstreamer::Engine::Engine() : d(new Private{})
 {
-    cout << "Creating a new Engine instance in " << __PRETTY_FUNCTION__ << endl;
+    MH_DEBUG("Creating a new Engine instance in " << __PRETTY_FUNCTION__);
     d->state = media::Engine::State::ready;
 }
 
 gstreamer::Engine::~Engine()
 {
+    {
+        std::lock_guard<std::recursive_mutex> lg(d->hibernation_guard);
+        d->discard_checkpoint();
+    }
     stop();
 }
 
@@ -334,29 +427,55 @@ const core::Property<media::Engine::State>& gstreamer::Engine::state() const
 
 bool gstreamer::Engine::open_resource_for_uri(const media::Track::UriType& uri)
 {
+    MH_TRACE_SCOPE("engine", "open_resource_for_uri");
+    std::lock_guard<std::recursive_mutex> lg(d->hibernation_guard);
+
+    d->discard_checkpoint();
     d->playbin.set_uri(uri);
     return true;
 }
 
 bool gstreamer::Engine::open_resource_for_uri(const media::Track::UriType& uri, const core::ubuntu::media::Player::HeadersType& headers)
 {
+    MH_TRACE_SCOPE("engine", "open_resource_for_uri");
+    std::lock_guard<std::recursive_mutex> lg(d->hibernation_guard);
+
+    d->discard_checkpoint();
     d->playbin.set_uri(uri, headers);
     return true;
 }
 
 void gstreamer::Engine::create_video_sink(uint32_t texture_id)
 {
+    MH_TRACE_SCOPE("engine", "create_video_sink");
     d->playbin.create_video_sink(texture_id);
 }
 
 bool gstreamer::Engine::play()
 {
+    MH_TRACE_SCOPE("engine", "play");
+    std::lock_guard<std::recursive_mutex> lg(d->hibernation_guard);
+
+    if (!d->restore_from_hibernation())
+        return false;
+
+    const auto start = std::chrono::steady_clock::now();
     auto result = d->playbin.set_state_and_wait(GST_STATE_PLAYING);
 
     if (result)
     {
+        // The first playback pays for loading whatever plugins weren't preloaded
+        static std::once_flag first_play;
+        std::call_once(first_play, [start]()
+        {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start);
+            media::metrics::gauge("playback.first_play_us").set(elapsed.count());
+            MH_INFO("First playback started after " << elapsed.count() / 1000 << "ms");
+        });
+
         d->state = media::Engine::State::playing;
-        cout << "play" << endl;
+        MH_DEBUG("play");
         d->playback_status_changed(media::Player::PlaybackStatus::playing);
     }
 
@@ -365,16 +484,29 @@ bool gstreamer::Engine::play()
 
 bool gstreamer::Engine::stop()
 {
+    MH_TRACE_SCOPE("engine", "stop");
+    std::lock_guard<std::recursive_mutex> lg(d->hibernation_guard);
+
     // No need to wait, and we can immediately return.
     if (d->state == media::Engine::State::stopped)
         return true;
 
-    auto result = d->playbin.set_state_and_wait(GST_STATE_NULL);
+    if (d->hibernated)
+    {
+        // The pipeline already sits in NULL
+        d->discard_checkpoint();
+        d->state = media::Engine::State::stopped;
+        d->playback_status_changed(media::Player::PlaybackStatus::stopped);
+        return true;
+    }
+
+    // Either NULL or, with warm stop enabled, READY
+    auto result = d->playbin.set_state_and_wait(d->playbin.idle_state());
 
     if (result)
     {
         d->state = media::Engine::State::stopped;
-        cout << "stop" << endl;
+        MH_DEBUG("stop");
         d->playback_status_changed(media::Player::PlaybackStatus::stopped);
     }
 
@@ -383,12 +515,18 @@ bool gstreamer::Engine::stop()
 
 bool gstreamer::Engine::pause()
 {
+    MH_TRACE_SCOPE("engine", "pause");
+    std::lock_guard<std::recursive_mutex> lg(d->hibernation_guard);
+
+    if (!d->restore_from_hibernation())
+        return false;
+
     auto result = d->playbin.set_state_and_wait(GST_STATE_PAUSED);
 
     if (result)
     {
         d->state = media::Engine::State::paused;
-        cout << "pause" << endl;
+        MH_DEBUG("pause");
         d->playback_status_changed(media::Player::PlaybackStatus::paused);
     }
 
@@ -397,9 +535,81 @@ bool gstreamer::Engine::pause()
 
 bool gstreamer::Engine::seek_to(const std::chrono::microseconds& ts)
 {
+    MH_TRACE_SCOPE("engine", "seek_to");
+    std::lock_guard<std::recursive_mutex> lg(d->hibernation_guard);
+
+    if (d->hibernated)
+    {
+        // Applied once restored
+        std::lock_guard<std::mutex> lg(d->checkpoint_guard);
+        d->checkpoint.position = ts.count() * 1000;
+        return true;
+    }
+
     return d->playbin.seek(ts);
 }
 
+bool gstreamer::Engine::hibernate()
+{
+    MH_TRACE_SCOPE("engine", "hibernate");
+    std::lock_guard<std::recursive_mutex> lg(d->hibernation_guard);
+
+    if (d->hibernated)
+        return true;
+
+    // Only idle pipelines that have something to restore are hibernated
+    if (d->state == media::Engine::State::playing || d->state == media::Engine::State::busy)
+        return false;
+    if (d->playbin.probed_uri.empty())
+        return false;
+
+    d->checkpoint.uri = d->playbin.probed_uri;
+    d->checkpoint.headers = d->playbin.request_headers;
+    d->checkpoint.position = d->playbin.position();
+    d->checkpoint.duration = d->playbin.duration();
+    d->checkpoint.file_type = d->playbin.media_file_type();
+
+    MH_DEBUG("Hibernating pipeline for " << d->checkpoint.uri
+             << " at " << d->checkpoint.position << " ns");
+
+    d->playbin.reset_pipeline(GST_STATE_NULL);
+    // Keep answering is_video_source/is_audio_source as before
+    d->playbin.file_type = d->checkpoint.file_type;
+    d->set_hibernated(true);
+    media::metrics::gauge("gst.pipelines.hibernated").add(1);
+
+    return true;
+}
+
+bool gstreamer::Engine::is_hibernated() const
+{
+    std::lock_guard<std::mutex> lg(d->checkpoint_guard);
+    return d->hibernated;
+}
+
+bool gstreamer::Engine::restore_resource_for_uri(const media::Track::UriType& uri, const std::chrono::microseconds& position)
+{
+    MH_TRACE_SCOPE("engine", "restore_resource_for_uri");
+    std::lock_guard<std::recursive_mutex> lg(d->hibernation_guard);
+
+    if (d->state == media::Engine::State::playing || d->state == media::Engine::State::busy)
+        return false;
+
+    d->discard_checkpoint();
+    d->playbin.reset_pipeline(GST_STATE_NULL);
+
+    d->checkpoint.uri = uri;
+    d->checkpoint.headers = media::Player::HeadersType{};
+    d->checkpoint.position = position.count() * 1000;
+    d->checkpoint.duration = 0;
+    d->checkpoint.file_type = gstreamer::Playbin::MediaFileType::MEDIA_FILE_TYPE_NONE;
+
+    d->set_hibernated(true);
+    media::metrics::gauge("gst.pipelines.hibernated").add(1);
+
+    return true;
+}
+
 const core::Property<bool>& gstreamer::Engine::is_video_source() const
 {
     gstreamer::Playbin::MediaFileType type = d->playbin.media_file_type();
@@ -424,13 +634,23 @@ const core::Property<bool>& gstreamer::Engine::is_audio_source() const
 
 const core::Property<uint64_t>& gstreamer::Engine::position() const
 {
-    d->position.set(d->playbin.position());
+    std::unique_lock<std::mutex> lk(d->checkpoint_guard);
+    const bool hibernated = d->hibernated;
+    const uint64_t checkpointed = hibernated ? d->checkpoint.position : 0;
+    lk.unlock();
+
+    d->position.set(hibernated ? checkpointed : d->playbin.position());
     return d->position;
 }
 
 const core::Property<uint64_t>& gstreamer::Engine::duration() const
 {
-    d->duration.set(d->playbin.duration());
+    std::unique_lock<std::mutex> lk(d->checkpoint_guard);
+    const bool hibernated = d->hibernated;
+    const uint64_t checkpointed = hibernated ? d->checkpoint.duration : 0;
+    lk.unlock();
+
+    d->duration.set(hibernated ? checkpointed : d->playbin.duration());
     return d->duration;
 }
 
@@ -469,6 +689,26 @@ core::Property<core::ubuntu::media::Player::Lifetime>& gstreamer::Engine::lifeti
     return d->lifetime;
 }
 
+const core::Property<core::ubuntu::media::Engine::SeekAccuracy>& gstreamer::Engine::seek_accuracy() const
+{
+    return d->seek_accuracy;
+}
+
+core::Property<core::ubuntu::media::Engine::SeekAccuracy>& gstreamer::Engine::seek_accuracy()
+{
+    return d->seek_accuracy;
+}
+
+const core::Property<core::ubuntu::media::Player::PlaybackRate>& gstreamer::Engine::playback_rate() const
+{
+    return d->playback_rate;
+}
+
+core::Property<core::ubuntu::media::Player::PlaybackRate>& gstreamer::Engine::playback_rate()
+{
+    return d->playback_rate;
+}
+
 const core::Property<std::tuple<media::Track::UriType, media::Track::MetaData>>&
 gstreamer::Engine::track_meta_data() const
 {
@@ -485,6 +725,11 @@ const core::Signal<uint64_t>& gstreamer::Engine::seeked_to_signal() const
     return d->seeked_to;
 }
 
+const core::Signal<int>& gstreamer::Engine::buffering_signal() const
+{
+    return d->buffering;
+}
+
 const core::Signal<void>& gstreamer::Engine::client_disconnected_signal() const
 {
     return d->client_disconnected;
@@ -512,5 +757,10 @@ const core::Signal<core::ubuntu::media::Player::Error>& gstreamer::Engine::error
 
 void gstreamer::Engine::reset()
 {
+    std::lock_guard<std::recursive_mutex> lg(d->hibernation_guard);
+
+    // A resumable session keeps its checkpoint for the next client
+    if (d->lifetime != media::Player::Lifetime::resumable)
+        d->discard_checkpoint();
     d->playbin.reset();
 }
@@ -42,6 +42,10 @@ public:
     bool pause();
     bool seek_to(const std::chrono::microseconds& ts);
 
+    bool hibernate();
+    bool is_hibernated() const;
+    bool restore_resource_for_uri(const core::ubuntu::media::Track::UriType& uri, const std::chrono::microseconds& position);
+
     const core::Property<bool>& is_video_source() const;
     const core::Property<bool>& is_audio_source() const;
 
@@ -56,6 +60,12 @@ public:
 
     const core::Property<core::ubuntu::media::Player::Orientation>& orientation() const;
 
+    const core::Property<core::ubuntu::media::Engine::SeekAccuracy>& seek_accuracy() const;
+    core::Property<core::ubuntu::media::Engine::SeekAccuracy>& seek_accuracy();
+
+    const core::Property<core::ubuntu::media::Player::PlaybackRate>& playback_rate() const;
+    core::Property<core::ubuntu::media::Player::PlaybackRate>& playback_rate();
+
     const core::Property<core::ubuntu::media::Player::Lifetime>& lifetime() const;
     core::Property<core::ubuntu::media::Player::Lifetime>& lifetime();
 
@@ -63,6 +73,7 @@ public:
 
     const core::Signal<void>& about_to_finish_signal() const;
     const core::Signal<uint64_t>& seeked_to_signal() const;
+    const core::Signal<int>& buffering_signal() const;
     const core::Signal<void>& client_disconnected_signal() const;
     const core::Signal<void>& end_of_stream_signal() const;
     const core::Signal<core::ubuntu::media::Player::PlaybackStatus>& playback_status_changed_signal() const;
@@ -0,0 +1,41 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSTREAMER_INIT_H_
+#define GSTREAMER_INIT_H_
+
+#include <gst/gst.h>
+
+#include <cstdlib>
+#include <mutex>
+
+namespace gstreamer
+{
+// Initializes GStreamer on first use rather than from a static initializer,
+// such that binaries linking the service don't pay for registry loading
+// until a pipeline is actually needed. Safe to call from any thread.
+inline void init()
+{
+    static std::once_flag once;
+    std::call_once(once, []()
+    {
+        gst_init(nullptr, nullptr);
+        std::atexit([]() { gst_deinit(); });
+    });
+}
+}
+
+#endif // GSTREAMER_INIT_H_
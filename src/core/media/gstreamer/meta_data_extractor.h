@@ -19,10 +19,17 @@
 #ifndef GSTREAMER_META_DATA_EXTRACTOR_H_
 #define GSTREAMER_META_DATA_EXTRACTOR_H_
 
+#include "../cover_art_cache.h"
 #include "../engine.h"
+#include "../logger.h"
+#include "../trace.h"
 #include "../xesam.h"
 
+#include "../mpris/metadata.h"
+
 #include "bus.h"
+#include "init.h"
+#include "task_pool.h"
 
 #include <gst/gst.h>
 
@@ -69,6 +76,10 @@ public:
         {
             (void) list;
 
+            // Images are handed to the cover art cache below
+            if (gst_tag_get_type(tag) == GST_TYPE_SAMPLE)
+                return;
+
             auto md = static_cast<media::Track::MetaData*>(user_data);
             std::stringstream ss;
 
@@ -142,13 +153,64 @@ public:
                         ss.str());
         },
         &md);
+
+        GstSample* sample = nullptr;
+        if (gst_tag_list_get_sample(tag.tag_list, GST_TAG_IMAGE, &sample) ||
+            gst_tag_list_get_sample(tag.tag_list, GST_TAG_PREVIEW_IMAGE, &sample))
+        {
+            auto buffer = gst_sample_get_buffer(sample);
+            GstMapInfo info;
+            if (buffer != nullptr && gst_buffer_map(buffer, &info, GST_MAP_READ))
+            {
+                // Only hashes the image, decoding and scaling happen on the
+                // cache's worker.
+                auto url = media::CoverArtCache::instance().art_url_for_image(
+                            std::string(reinterpret_cast<const char*>(info.data), info.size),
+                            md.count(xesam::Album::name) > 0 ? md.get(xesam::Album::name) : "",
+                            md.count(xesam::Artist::name) > 0 ? md.get(xesam::Artist::name) : "");
+                gst_buffer_unmap(buffer, &info);
+
+                if (not url.empty())
+                    md.set(mpris::metadata::ArtUrl::name, url);
+            }
+            gst_sample_unref(sample);
+        }
+    }
+
+    // Falls back to a cover image in the directory of a local track if the
+    // track doesn't carry any art itself.
+    static void on_folder_art_wanted(
+            const core::ubuntu::media::Track::UriType& uri,
+            core::ubuntu::media::Track::MetaData& md)
+    {
+        namespace media = core::ubuntu::media;
+
+        if (md.count(mpris::metadata::ArtUrl::name) > 0)
+            return;
+
+        auto url = media::CoverArtCache::instance().art_url_for_folder_of(
+                    uri,
+                    md.count(xesam::Album::name) > 0 ? md.get(xesam::Album::name) : "",
+                    md.count(xesam::Artist::name) > 0 ? md.get(xesam::Artist::name) : "");
+
+        if (not url.empty())
+            md.set(mpris::metadata::ArtUrl::name, url);
+    }
+
+    static GstElement* create_pipeline()
+    {
+        gstreamer::init();
+        return gst_pipeline_new("meta_data_extractor_pipeline");
     }
 
     MetaDataExtractor()
-        : pipe(gst_pipeline_new("meta_data_extractor_pipeline")),
+        : pipe(create_pipeline()),
           decoder(gst_element_factory_make ("uridecodebin", NULL)),
           bus(GST_ELEMENT_BUS(pipe))
     {
+        bus.use_task_pool(gstreamer::shared_task_pool(core::ubuntu::media::scheduling::Class::background));
+        bus.use_scheduling(core::ubuntu::media::scheduling::Class::background);
+
         gst_bin_add(GST_BIN(pipe), decoder);
 
         auto sink = gst_element_factory_make ("fakesink", NULL);
@@ -168,6 +230,11 @@ public:
         if (!gst_uri_is_valid(uri.c_str()))
             throw std::runtime_error("Invalid uri");
 
+        static auto& extraction_latency = core::ubuntu::media::metrics::histogram("metadata.extraction_us");
+        static auto& extraction_failures = core::ubuntu::media::metrics::counter("metadata.extraction_failures");
+        core::ubuntu::media::metrics::ScopedTimer timer{extraction_latency};
+        MH_TRACE_SCOPE("metadata", "meta_data_for_track_with_uri");
+
         core::ubuntu::media::Track::MetaData meta_data;
         std::promise<core::ubuntu::media::Track::MetaData> promise;
         std::future<core::ubuntu::media::Track::MetaData> future{promise.get_future()};
@@ -177,12 +244,13 @@ public:
             bus.on_new_message.connect(
                     [&](const gstreamer::Bus::Message& msg)
                     {
-                        std::cout << __PRETTY_FUNCTION__ << gst_message_type_get_name(msg.type) << std::endl;
+                        MH_TRACE(__PRETTY_FUNCTION__ << gst_message_type_get_name(msg.type));
                         if (msg.type == GST_MESSAGE_TAG)
                         {
                             MetaDataExtractor::on_tag_available(msg.detail.tag, meta_data);
                         } else if (msg.type == GST_MESSAGE_ASYNC_DONE)
                         {
+                            MetaDataExtractor::on_folder_art_wanted(uri, meta_data);
                             promise.set_value(meta_data);
                         }
                     })
@@ -193,6 +261,7 @@ public:
 
         if (std::future_status::ready != future.wait_for(std::chrono::seconds(2)))
         {
+            extraction_failures.increment();
             gst_element_set_state(pipe, GST_STATE_NULL);
             throw std::runtime_error("Problem extracting meta data for track");
         } else
@@ -20,7 +20,12 @@
 #define GSTREAMER_PLAYBIN_H_
 
 #include "bus.h"
+#include "init.h"
+#include "task_pool.h"
+#include "../engine.h"
+#include "../logger.h"
 #include "../mpris/player.h"
+#include "../trace.h"
 
 #include <hybris/media/surface_texture_client_hybris.h>
 #include <hybris/media/media_codec_layer.h>
@@ -28,7 +33,12 @@
 #include <gio/gio.h>
 #include <gst/gst.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 
 // Uncomment to generate a dot file at the time that the pipeline
@@ -47,7 +57,26 @@ struct Playbin
     {
         GST_PLAY_FLAG_VIDEO = (1 << 0),
         GST_PLAY_FLAG_AUDIO = (1 << 1),
-        GST_PLAY_FLAG_TEXT = (1 << 2)
+        GST_PLAY_FLAG_TEXT = (1 << 2),
+        GST_PLAY_FLAG_VIS = (1 << 3),
+        GST_PLAY_FLAG_SOFT_VOLUME = (1 << 4),
+        GST_PLAY_FLAG_NATIVE_AUDIO = (1 << 5),
+        GST_PLAY_FLAG_NATIVE_VIDEO = (1 << 6),
+        GST_PLAY_FLAG_DOWNLOAD = (1 << 7),
+        GST_PLAY_FLAG_BUFFERING = (1 << 8),
+        GST_PLAY_FLAG_DEINTERLACE = (1 << 9),
+        GST_PLAY_FLAG_SOFT_COLORBALANCE = (1 << 10)
+    };
+
+    // Decides which branches playbin sets up for a session
+    enum class PipelineProfile
+    {
+        // Audio and video, the historic default
+        video,
+        // No video, text or visualization branches
+        audio_only,
+        // Audio only with small sink buffers, for voice
+        low_latency
     };
 
     enum MediaFileType
@@ -80,8 +109,66 @@ struct Playbin
         static_cast<Playbin*>(user_data)->setup_source(source);
     }
 
+    static void element_setup(GstElement*,
+                              GstElement *element,
+                              gpointer user_data)
+    {
+        if (user_data == nullptr)
+            return;
+
+        static_cast<Playbin*>(user_data)->setup_element(element);
+    }
+
+    static bool warm_stop_enabled()
+    {
+        return g_strcmp0(::getenv("CORE_UBUNTU_MEDIA_SERVICE_WARM_STOP"), "1") == 0;
+    }
+
+    // Forces a profile for all sessions, mostly useful for measurements
+    static const char* forced_pipeline_profile()
+    {
+        return ::getenv("CORE_UBUNTU_MEDIA_SERVICE_PIPELINE_PROFILE");
+    }
+
+    static media::Engine::SeekAccuracy default_seek_accuracy()
+    {
+        const char* accuracy = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_SEEK_ACCURACY");
+        if (g_strcmp0(accuracy, "accurate") == 0)
+            return media::Engine::SeekAccuracy::accurate;
+        else if (g_strcmp0(accuracy, "snap-nearest") == 0)
+            return media::Engine::SeekAccuracy::snap_nearest;
+
+        return media::Engine::SeekAccuracy::key_unit;
+    }
+
+    // Issues the seek that was queued up while the previous one was in flight.
+    // Runs on a GStreamer worker thread, never on a streaming thread.
+    static void issue_pending_seek(GstElement*, gpointer user_data)
+    {
+        auto thiz = static_cast<Playbin*>(user_data);
+
+        std::unique_lock<std::mutex> lk(thiz->seek_guard);
+        if (!thiz->seek_shutdown && thiz->has_pending_seek)
+        {
+            auto target = thiz->seek_target;
+            thiz->has_pending_seek = false;
+            lk.unlock();
+            thiz->issue_seek(target);
+            lk.lock();
+        }
+
+        --thiz->seeks_scheduled;
+        thiz->seek_idle.notify_all();
+    }
+
+    static GstElement* create_pipeline()
+    {
+        gstreamer::init();
+        return gst_element_factory_make("playbin", pipeline_name().c_str());
+    }
+
     Playbin()
-        : pipeline(gst_element_factory_make("playbin", pipeline_name().c_str())),
+        : pipeline(create_pipeline()),
           bus{gst_element_get_bus(pipeline)},
           file_type(MEDIA_FILE_TYPE_NONE),
           video_sink(nullptr),
@@ -94,11 +181,34 @@ struct Playbin
                       this,
                       std::placeholders::_1))),
           is_seeking(false),
+          has_pending_seek(false),
+          seek_target(0),
+          last_seek_latency(0),
+          seeks_coalesced(0),
+          seeks_scheduled(0),
+          seek_shutdown(false),
+          seek_accuracy(default_seek_accuracy()),
+          rate(1.),
+          rate_pending(false),
+          cached_position(0),
+          warm_stop(warm_stop_enabled()),
+          probed_file_type(MEDIA_FILE_TYPE_NONE),
+          audio_role(media::Player::AudioStreamRole::multimedia),
+          profile(PipelineProfile::video),
+          video_flags(0),
+          low_latency_sink(false),
+          seek_latency(media::metrics::histogram("pipeline.seek_us")),
+          seeks_coalesced_counter(media::metrics::counter("pipeline.seeks_coalesced")),
           player_lifetime(media::Player::Lifetime::normal)
     {
         if (!pipeline)
             throw std::runtime_error("Could not create pipeline for playbin.");
 
+        media::metrics::gauge("gst.pipelines").add(1);
+
+        bus.use_task_pool(gstreamer::shared_task_pool(media::scheduling::class_for_role(audio_role)));
+        bus.use_scheduling(media::scheduling::class_for_role(audio_role));
+
         // Add audio and/or video sink elements depending on environment variables
         // being set or not set
         setup_pipeline_for_audio_video();
@@ -117,17 +227,41 @@ struct Playbin
                     this
                     );
 
+        // Unless CORE_UBUNTU_MEDIA_SERVICE_AUDIO_SINK_NAME is set, the audio
+        // sink is auto-plugged and only shows up once playbin builds its chain
+        if (g_signal_lookup("element-setup", G_OBJECT_TYPE(pipeline)) != 0)
+            g_signal_connect(
+                        pipeline,
+                        "element-setup",
+                        G_CALLBACK(element_setup),
+                        this
+                        );
+        else
+            MH_WARNING("playbin lacks element-setup, auto-plugged audio sinks keep their latency");
+
     }
 
     ~Playbin()
     {
+        {
+            // Wait for a queued seek that might still reference us
+            std::unique_lock<std::mutex> lk(seek_guard);
+            seek_shutdown = true;
+            seek_idle.wait(lk, [this]() { return seeks_scheduled == 0; });
+        }
+
         if (pipeline)
+        {
+            // A warm stopped pipeline still sits in READY
+            gst_element_set_state(pipeline, GST_STATE_NULL);
             gst_object_unref(pipeline);
+            media::metrics::gauge("gst.pipelines").add(-1);
+        }
     }
 
     void reset()
     {
-        std::cout << "Client died, resetting pipeline" << std::endl;
+        MH_INFO("Client died, resetting pipeline");
         // When the client dies, tear down the current pipeline and get it
         // in a state that is ready for the next client that connects to the
         // service
@@ -141,23 +275,46 @@ struct Playbin
         signals.client_disconnected();
     }
 
-    void reset_pipeline()
+    // The state the pipeline is parked in when stopped. READY keeps the sinks
+    // (and thus the pulse stream) open, NULL releases everything.
+    GstState idle_state() const
+    {
+        return warm_stop ? GST_STATE_READY : GST_STATE_NULL;
+    }
+
+    void reset_pipeline(GstState target = GST_STATE_NULL)
     {
-        std::cout << __PRETTY_FUNCTION__ << std::endl;
-        auto ret = gst_element_set_state(pipeline, GST_STATE_NULL);
+        MH_DEBUG(__PRETTY_FUNCTION__);
+        auto ret = gst_element_set_state(pipeline, target);
         switch(ret)
         {
         case GST_STATE_CHANGE_FAILURE:
-            std::cout << "Failed to reset the pipeline state. Client reconnect may not function properly." << std::endl;
+            MH_WARNING("Failed to reset the pipeline state. Client reconnect may not function properly.");
             break;
         case GST_STATE_CHANGE_NO_PREROLL:
         case GST_STATE_CHANGE_SUCCESS:
         case GST_STATE_CHANGE_ASYNC:
             break;
         default:
-            std::cout << "Failed to reset the pipeline state. Client reconnect may not function properly." << std::endl;
+            MH_WARNING("Failed to reset the pipeline state. Client reconnect may not function properly.");
         }
         file_type = MEDIA_FILE_TYPE_NONE;
+        reset_seek_state();
+
+        {
+            std::lock_guard<std::mutex> lg(position_guard);
+            cached_position = 0;
+        }
+        // The new segment starts out at 1.0, re-apply the rate once prerolled
+        rate_pending = rate != 1.;
+    }
+
+    // A seek in flight won't complete once the pipeline left PAUSED/PLAYING
+    void reset_seek_state()
+    {
+        std::lock_guard<std::mutex> lg(seek_guard);
+        is_seeking = false;
+        has_pending_seek = false;
     }
 
     void on_new_message(const Bus::Message& message)
@@ -190,12 +347,10 @@ struct Playbin
             signals.on_state_changed(message.detail.state_changed);
             break;
         case GST_MESSAGE_ASYNC_DONE:
-            if (is_seeking)
-            {
-                // FIXME: Pass the actual playback time position to the signal call
-                signals.on_seeked_to(0);
-                is_seeking = false;
-            }
+            on_seek_done();
+            break;
+        case GST_MESSAGE_BUFFERING:
+            signals.on_buffering(message.detail.buffering.percent);
             break;
         case GST_MESSAGE_EOS:
             signals.on_end_of_stream();
@@ -209,6 +364,144 @@ struct Playbin
         return bus;
     }
 
+    PipelineProfile select_pipeline_profile() const
+    {
+        const char* forced = forced_pipeline_profile();
+        if (g_strcmp0(forced, "video") == 0)
+            return PipelineProfile::video;
+        else if (g_strcmp0(forced, "audio-only") == 0)
+            return PipelineProfile::audio_only;
+        else if (g_strcmp0(forced, "low-latency") == 0)
+            return PipelineProfile::low_latency;
+
+        switch (audio_role)
+        {
+        case media::Player::AudioStreamRole::phone:
+            return PipelineProfile::low_latency;
+        case media::Player::AudioStreamRole::alarm:
+        case media::Player::AudioStreamRole::alert:
+            return PipelineProfile::audio_only;
+        default:
+            break;
+        }
+
+        // Only local files are actually probed, everything else
+        // claims to be audio and video
+        if (file_type == MEDIA_FILE_TYPE_AUDIO && probed_uri.find("file://") == 0)
+            return PipelineProfile::audio_only;
+
+        return PipelineProfile::video;
+    }
+
+    // playbin only picks up flag changes in NULL and READY
+    void apply_pipeline_profile(PipelineProfile new_profile)
+    {
+        gint flags;
+        g_object_get (pipeline, "flags", &flags, nullptr);
+        if (new_profile == PipelineProfile::video)
+        {
+            // Bring back everything the audio profiles stripped
+            if (video_flags != 0)
+                flags = video_flags;
+            video_flags = 0;
+            flags |= GST_PLAY_FLAG_VIDEO;
+        }
+        else
+        {
+            // Remember the video setup only once, the audio profiles strip the same flags
+            if (video_flags == 0)
+                video_flags = flags;
+            flags &= ~(GST_PLAY_FLAG_VIDEO | GST_PLAY_FLAG_VIS |
+                       GST_PLAY_FLAG_DEINTERLACE | GST_PLAY_FLAG_SOFT_COLORBALANCE);
+        }
+        flags |= GST_PLAY_FLAG_AUDIO;
+        flags &= ~GST_PLAY_FLAG_TEXT;
+        g_object_set (pipeline, "flags", flags, nullptr);
+
+        tune_audio_sink_latency(new_profile == PipelineProfile::low_latency);
+        use_pitch_correction(new_profile != PipelineProfile::low_latency);
+
+        if (new_profile != profile)
+            MH_DEBUG("Switched pipeline profile to " << static_cast<int>(new_profile));
+        profile = new_profile;
+    }
+
+    // Keeps the pitch when playing at a rate other than 1.0. scaletempo is in
+    // passthrough mode at normal speed but still costs a copy per buffer, so
+    // calls and other low latency streams go without.
+    void use_pitch_correction(bool enabled)
+    {
+        if (g_object_class_find_property(G_OBJECT_GET_CLASS(pipeline), "audio-filter") == nullptr)
+            return;
+
+        GstElement *filter = nullptr;
+        g_object_get (pipeline, "audio-filter", &filter, nullptr);
+        const bool installed = filter != nullptr;
+        if (filter != nullptr)
+            gst_object_unref(filter);
+
+        if (enabled == installed)
+            return;
+
+        g_object_set (pipeline,
+                      "audio-filter", enabled ? gst_element_factory_make("scaletempo", nullptr) : nullptr,
+                      nullptr);
+    }
+
+    static bool has_latency_properties(GstElement *audio_sink)
+    {
+        return g_object_class_find_property(G_OBJECT_GET_CLASS(audio_sink), "buffer-time") != nullptr &&
+               g_object_class_find_property(G_OBJECT_GET_CLASS(audio_sink), "latency-time") != nullptr;
+    }
+
+    static gint64 default_int64_property(GstElement *element, const char *name)
+    {
+        auto spec = g_object_class_find_property(G_OBJECT_GET_CLASS(element), name);
+        return G_IS_PARAM_SPEC_INT64(spec) ? G_PARAM_SPEC_INT64(spec)->default_value : -1;
+    }
+
+    // Shrinks the audio sink's ring buffer for low latency, restores the
+    // sink's defaults otherwise. Sinks without these properties are left alone.
+    static void set_audio_sink_latency(GstElement *audio_sink, bool low_latency)
+    {
+        static const gint64 low_latency_buffer_time{40000};
+        static const gint64 low_latency_latency_time{10000};
+
+        if (!has_latency_properties(audio_sink))
+            return;
+
+        g_object_set (audio_sink,
+                      "buffer-time", low_latency ? low_latency_buffer_time : default_int64_property(audio_sink, "buffer-time"),
+                      "latency-time", low_latency ? low_latency_latency_time : default_int64_property(audio_sink, "latency-time"),
+                      nullptr);
+    }
+
+    // Sinks created from now on are set up by setup_element, a sink that
+    // already exists (set explicitly or kept from a previous uri) is
+    // adjusted right away.
+    void tune_audio_sink_latency(bool low_latency)
+    {
+        low_latency_sink = low_latency;
+
+        GstElement *audio_sink = nullptr;
+        g_object_get (pipeline, "audio-sink", &audio_sink, nullptr);
+        if (audio_sink == nullptr)
+            return;
+
+        set_audio_sink_latency(audio_sink, low_latency);
+        gst_object_unref(audio_sink);
+    }
+
+    // Runs on a streaming thread for every element playbin adds
+    void setup_element(GstElement *element)
+    {
+        // Fresh sinks come with the default latency already
+        if (!low_latency_sink.load() || !GST_OBJECT_FLAG_IS_SET(element, GST_ELEMENT_FLAG_SINK))
+            return;
+
+        set_audio_sink_latency(element, true);
+    }
+
     void setup_pipeline_for_audio_video()
     {
         gint flags;
@@ -224,7 +517,7 @@ struct Playbin
                         ::getenv("CORE_UBUNTU_MEDIA_SERVICE_AUDIO_SINK_NAME"),
                         "audio-sink");
 
-            std::cout << "audio_sink: " << ::getenv("CORE_UBUNTU_MEDIA_SERVICE_AUDIO_SINK_NAME") << std::endl;
+            MH_INFO("audio_sink: " << ::getenv("CORE_UBUNTU_MEDIA_SERVICE_AUDIO_SINK_NAME"));
 
             g_object_set (
                         pipeline,
@@ -239,7 +532,7 @@ struct Playbin
                 ::getenv("CORE_UBUNTU_MEDIA_SERVICE_VIDEO_SINK_NAME"),
                 "video-sink");
 
-            std::cout << "video_sink: " << ::getenv("CORE_UBUNTU_MEDIA_SERVICE_VIDEO_SINK_NAME") << std::endl;
+            MH_INFO("video_sink: " << ::getenv("CORE_UBUNTU_MEDIA_SERVICE_VIDEO_SINK_NAME"));
 
             g_object_set (
                     pipeline,
@@ -251,7 +544,7 @@ struct Playbin
 
     void create_video_sink(uint32_t texture_id)
     {
-        std::cout << "Creating video sink for texture_id: " << texture_id << std::endl;
+        MH_DEBUG("Creating video sink for texture_id: " << texture_id);
 
         if (::getenv("CORE_UBUNTU_MEDIA_SERVICE_VIDEO_SINK_NAME") != nullptr)
         {
@@ -312,20 +605,29 @@ struct Playbin
     /** Sets the new audio stream role on the pulsesink in playbin */
     void set_audio_stream_role(media::Player::AudioStreamRole new_audio_role)
     {
+        audio_role = new_audio_role;
+        // Tasks created from now on go to the pool of the new class
+        bus.use_task_pool(gstreamer::shared_task_pool(media::scheduling::class_for_role(new_audio_role)));
+        bus.use_scheduling(media::scheduling::class_for_role(new_audio_role));
+
+        // Otherwise picked up with the next uri
+        GstState current = GST_STATE_NULL;
+        gst_element_get_state(pipeline, &current, nullptr, 0);
+        if (current <= GST_STATE_READY)
+            apply_pipeline_profile(select_pipeline_profile());
+
         GstElement *audio_sink = NULL;
         g_object_get (pipeline, "audio-sink", &audio_sink, NULL);
 
         std::string role_str("props,media.role=" + get_audio_role_str(new_audio_role));
-        std::cout << "Audio stream role: " << role_str << std::endl;
+        MH_DEBUG("Audio stream role: " << role_str);
 
         GstStructure *props = gst_structure_from_string (role_str.c_str(), NULL);
         if (audio_sink != nullptr && props != nullptr)
             g_object_set (audio_sink, "stream-properties", props, NULL);
         else
         {
-            std::cerr <<
-                "Warning: couldn't set audio stream role - couldn't get audio_sink from pipeline" <<
-                std::endl;
+            MH_WARNING("Couldn't set audio stream role - couldn't get audio_sink from pipeline");
         }
 
         gst_structure_free (props);
@@ -339,7 +641,23 @@ struct Playbin
     uint64_t position() const
     {
         int64_t pos = 0;
-        gst_element_query_position (pipeline, GST_FORMAT_TIME, &pos);
+        std::lock_guard<std::mutex> lg(position_guard);
+        const auto now = std::chrono::steady_clock::now();
+        if (gst_element_query_position (pipeline, GST_FORMAT_TIME, &pos))
+        {
+            cached_position = pos;
+            cached_position_time = now;
+        }
+        else if (GST_STATE(pipeline) == GST_STATE_PLAYING)
+        {
+            // The query fails while the pipeline is busy, e.g. during a seek or rate
+            // change. Extrapolate from the last known position at the current rate.
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        now - cached_position_time).count();
+            pos = std::max<int64_t>(0, cached_position + static_cast<int64_t>(elapsed * rate.load()));
+        }
+        else
+            pos = cached_position;
 
         // FIXME: this should be int64_t, but dbus-cpp doesn't seem to handle it correctly
         return static_cast<uint64_t>(pos);
@@ -357,13 +675,26 @@ struct Playbin
     void set_uri(const std::string& uri,
                   const core::ubuntu::media::Player::HeadersType& headers = core::ubuntu::media::Player::HeadersType())
     {
-       reset_pipeline();
+        reset_pipeline(idle_state());
 
         g_object_set(pipeline, "uri", uri.c_str(), NULL);
-        if (is_video_file(uri))
-            file_type = MEDIA_FILE_TYPE_VIDEO;
-        else if (is_audio_file(uri))
-            file_type = MEDIA_FILE_TYPE_AUDIO;
+        if (warm_stop && uri == probed_uri)
+        {
+            // Re-opening the same item, skip probing the content type again
+            file_type = probed_file_type;
+        }
+        else
+        {
+            if (is_video_file(uri))
+                file_type = MEDIA_FILE_TYPE_VIDEO;
+            else if (is_audio_file(uri))
+                file_type = MEDIA_FILE_TYPE_AUDIO;
+
+            probed_uri = uri;
+            probed_file_type = file_type;
+        }
+
+        apply_pipeline_profile(select_pipeline_profile());
 
         request_headers = headers;
     }
@@ -411,6 +742,32 @@ struct Playbin
             std::chrono::milliseconds{5000}
         };
 
+        static media::metrics::Histogram* const state_change_latency[] =
+        {
+            &media::metrics::histogram("pipeline.set_state.void_pending_us"),
+            &media::metrics::histogram("pipeline.set_state.null_us"),
+            &media::metrics::histogram("pipeline.set_state.ready_us"),
+            &media::metrics::histogram("pipeline.set_state.paused_us"),
+            &media::metrics::histogram("pipeline.set_state.playing_us")
+        };
+        media::metrics::ScopedTimer timer{*state_change_latency[new_state]};
+
+        static const char* const state_change_trace_names[] =
+        {
+            "set_state.VOID_PENDING",
+            "set_state.NULL",
+            "set_state.READY",
+            "set_state.PAUSED",
+            "set_state.PLAYING"
+        };
+        MH_TRACE_SCOPE("pipeline", state_change_trace_names[new_state]);
+
+        if (new_state <= GST_STATE_READY)
+        {
+            reset_seek_state();
+            rate_pending = rate != 1.;
+        }
+
         auto ret = gst_element_set_state(pipeline, new_state);
         bool result = false; GstState current, pending;
         switch(ret)
@@ -432,24 +789,197 @@ struct Playbin
             // Get the video height/width from the video sink
             get_video_dimensions();
 #ifdef DEBUG_GST_PIPELINE
-            std::cout << "Dumping pipeline dot file" << std::endl;
+            MH_DEBUG("Dumping pipeline dot file");
             GST_DEBUG_BIN_TO_DOT_FILE((GstBin*)pipeline, GST_DEBUG_GRAPH_SHOW_ALL, "pipeline");
 #endif
         }
             break;
         }
 
+        if (result && new_state >= GST_STATE_PAUSED && rate_pending)
+            apply_rate(1.);
+
         return result;
     }
 
-    bool seek(const std::chrono::microseconds& ms)
+    bool set_rate(double new_rate)
+    {
+        // A rate of 0 is meaningless for a segment, callers pause instead
+        if (new_rate == 0. || new_rate == rate)
+            return new_rate != 0.;
+
+        const double old_rate = rate;
+        rate = new_rate;
+
+        GstState current = GST_STATE_NULL;
+        gst_element_get_state(pipeline, &current, nullptr, 0);
+        if (current < GST_STATE_PAUSED)
+        {
+            // Applied once the pipeline prerolled, see set_state_and_wait
+            rate_pending = true;
+            return true;
+        }
+
+        return apply_rate(old_rate);
+    }
+
+    bool apply_rate(double old_rate)
+    {
+        rate_pending = false;
+        const double new_rate = rate;
+        const bool same_direction = (old_rate > 0.) == (new_rate > 0.);
+
+#if GST_CHECK_VERSION(1,18,0)
+        // Switches the rate of the running segment without flushing anything
+        if (same_direction && gst_element_seek(
+                    pipeline,
+                    new_rate,
+                    GST_FORMAT_TIME,
+                    GST_SEEK_FLAG_INSTANT_RATE_CHANGE,
+                    GST_SEEK_TYPE_NONE, 0,
+                    GST_SEEK_TYPE_NONE, 0))
+            return true;
+#endif
+
+        int64_t pos = 0;
+        if (!gst_element_query_position(pipeline, GST_FORMAT_TIME, &pos))
+            return false;
+
+        // Start a new segment at the current position. Keeping the direction,
+        // the new segment simply follows the data that is already queued.
+        // Reversing requires a flush.
+        int flags = GST_SEEK_FLAG_ACCURATE;
+        if (!same_direction)
+            flags |= GST_SEEK_FLAG_FLUSH;
+#if GST_CHECK_VERSION(1,6,0)
+        // Let decoders skip frames when fast-forwarding or rewinding
+        if (std::fabs(new_rate) > 2.)
+            flags |= GST_SEEK_FLAG_TRICKMODE;
+#endif
+
+        return segment_seek(new_rate, static_cast<GstSeekFlags>(flags), pos);
+    }
+
+    // Positive rates play from pos to the end, negative rates from pos back to the start
+    bool segment_seek(double segment_rate, GstSeekFlags flags, int64_t pos)
     {
-        is_seeking = true;
-        return gst_element_seek_simple(
+        if (segment_rate > 0.)
+            return gst_element_seek(
+                        pipeline,
+                        segment_rate,
+                        GST_FORMAT_TIME,
+                        flags,
+                        GST_SEEK_TYPE_SET, pos,
+                        GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+
+        return gst_element_seek(
                     pipeline,
+                    segment_rate,
                     GST_FORMAT_TIME,
-                    (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT),
-                    ms.count() * 1000);
+                    flags,
+                    GST_SEEK_TYPE_SET, 0,
+                    GST_SEEK_TYPE_SET, pos);
+    }
+
+    void set_seek_accuracy(media::Engine::SeekAccuracy accuracy)
+    {
+        std::lock_guard<std::mutex> lg(seek_guard);
+        seek_accuracy = accuracy;
+    }
+
+    GstSeekFlags seek_flags() const
+    {
+        switch (seek_accuracy)
+        {
+        case media::Engine::SeekAccuracy::accurate:
+            return (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE);
+        case media::Engine::SeekAccuracy::snap_nearest:
+            return (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_NEAREST);
+        case media::Engine::SeekAccuracy::key_unit:
+        default:
+            return (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT);
+        }
+    }
+
+    bool seek(const std::chrono::microseconds& ms)
+    {
+        {
+            std::lock_guard<std::mutex> lg(seek_guard);
+            if (is_seeking)
+            {
+                // A seek is still in flight, only remember the latest target. Every
+                // target in between would be superseded before it got rendered.
+                if (has_pending_seek)
+                {
+                    ++seeks_coalesced;
+                    seeks_coalesced_counter.increment();
+                }
+                seek_target = ms;
+                has_pending_seek = true;
+                return true;
+            }
+            is_seeking = true;
+        }
+
+        return issue_seek(ms);
+    }
+
+    // Must be called without holding seek_guard, a flushing seek
+    // might post ASYNC_DONE synchronously.
+    bool issue_seek(const std::chrono::microseconds& ms)
+    {
+        MH_TRACE_SCOPE("pipeline", "issue_seek");
+
+        GstSeekFlags flags;
+        {
+            std::lock_guard<std::mutex> lg(seek_guard);
+            seek_started = std::chrono::steady_clock::now();
+            flags = seek_flags();
+        }
+
+        // Seek within a segment that keeps the current rate
+        auto result = segment_seek(rate, flags, ms.count() * 1000);
+
+        if (!result)
+        {
+            std::lock_guard<std::mutex> lg(seek_guard);
+            is_seeking = false;
+            has_pending_seek = false;
+        }
+
+        return result;
+    }
+
+    void on_seek_done()
+    {
+        {
+            std::lock_guard<std::mutex> lg(seek_guard);
+            if (!is_seeking)
+                return;
+
+            last_seek_latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - seek_started);
+            seek_latency.record(last_seek_latency.count());
+
+            if (has_pending_seek && !seek_shutdown)
+            {
+                // We are called from a streaming thread here, issuing a flushing
+                // seek from it would deadlock. Hand it off to a worker instead.
+                ++seeks_scheduled;
+                gst_element_call_async(pipeline, &Playbin::issue_pending_seek, this, nullptr);
+                return;
+            }
+
+            has_pending_seek = false;
+            is_seeking = false;
+        }
+
+        // Report where we actually landed, in microseconds like the request
+        const uint64_t landed = position() / 1000;
+        MH_DEBUG("Seek landed at " << landed << " us after "
+                 << last_seek_latency.count() << " us ("
+                 << seeks_coalesced << " seeks coalesced so far)");
+        signals.on_seeked_to(landed);
     }
 
     void get_video_dimensions()
@@ -458,11 +988,11 @@ struct Playbin
         {
             g_object_get (video_sink, "height", &video_height, nullptr);
             g_object_get (video_sink, "width", &video_width, nullptr);
-            std::cout << "video_height: " << video_height << ", video_width: " << video_width << std::endl;
+            MH_DEBUG("video_height: " << video_height << ", video_width: " << video_width);
             signals.on_add_frame_dimension(video_height, video_width);
         }
         else
-            std::cerr << "Could not get the height/width of each video frame" << std::endl;
+            MH_WARNING("Could not get the height/width of each video frame");
     }
 
     int get_video_height() const
@@ -481,7 +1011,7 @@ struct Playbin
             return std::string();
 
         std::string filename(uri);
-        std::cout << "filename: " << filename << std::endl;
+        MH_TRACE("filename: " << filename);
         size_t pos = uri.find("file://");
         if (pos != std::string::npos)
             filename = uri.substr(pos + 7, std::string::npos);
@@ -506,8 +1036,8 @@ struct Playbin
             std::string error_str(error->message);
             g_error_free(error);
 
-            std::cout << "Failed to query the URI for the presence of video content: "
-                << error_str << std::endl;
+            MH_WARNING("Failed to query the URI for the presence of video content: "
+                       << error_str);
             return std::string();
         }
 
@@ -524,7 +1054,7 @@ struct Playbin
 
         if (get_file_content_type(uri).find("audio/") == 0)
         {
-            std::cout << "Found audio content" << std::endl;
+            MH_DEBUG("Found audio content");
             return true;
         }
 
@@ -538,7 +1068,7 @@ struct Playbin
 
         if (get_file_content_type(uri).find("video/") == 0)
         {
-            std::cout << "Found video content" << std::endl;
+            MH_DEBUG("Found video content");
             return true;
         }
 
@@ -558,7 +1088,36 @@ struct Playbin
     uint32_t video_height;
     uint32_t video_width;
     core::Connection on_new_message_connection;
+    // Guards the seek scheduler state below
+    std::mutex seek_guard;
+    std::condition_variable seek_idle;
     bool is_seeking;
+    bool has_pending_seek;
+    std::chrono::microseconds seek_target;
+    std::chrono::steady_clock::time_point seek_started;
+    std::chrono::microseconds last_seek_latency;
+    uint64_t seeks_coalesced;
+    unsigned int seeks_scheduled;
+    bool seek_shutdown;
+    media::Engine::SeekAccuracy seek_accuracy;
+    std::atomic<double> rate;
+    bool rate_pending;
+    // Last successfully queried position, used to extrapolate while queries fail
+    mutable std::mutex position_guard;
+    mutable int64_t cached_position;
+    mutable std::chrono::steady_clock::time_point cached_position_time;
+    // Park the pipeline in READY instead of NULL on stop and re-open
+    bool warm_stop;
+    std::string probed_uri;
+    MediaFileType probed_file_type;
+    media::Player::AudioStreamRole audio_role;
+    PipelineProfile profile;
+    // playbin flags from before switching to an audio profile, 0 in the video profile
+    gint video_flags;
+    // Whether audio sinks playbin creates get the low latency settings
+    std::atomic<bool> low_latency_sink;
+    media::metrics::Histogram& seek_latency;
+    media::metrics::Counter& seeks_coalesced_counter;
     core::ubuntu::media::Player::HeadersType request_headers;
     media::Player::Lifetime player_lifetime;
     struct
@@ -570,6 +1129,7 @@ struct Playbin
         core::Signal<Bus::Message::Detail::Tag> on_tag_available;
         core::Signal<Bus::Message::Detail::StateChanged> on_state_changed;
         core::Signal<uint64_t> on_seeked_to;
+        core::Signal<int> on_buffering;
         core::Signal<void> on_end_of_stream;
         core::Signal<media::Player::PlaybackStatus> on_playback_status_changed;
         core::Signal<media::Player::Orientation> on_orientation_changed;
@@ -0,0 +1,129 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSTREAMER_PRELOAD_H_
+#define GSTREAMER_PRELOAD_H_
+
+#include "init.h"
+#include "../logger.h"
+#include "../metrics.h"
+#include "../trace.h"
+
+#include <gst/gst.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace gstreamer
+{
+// Elements a typical first playback ends up plugging, covering the parsers,
+// demuxers and decoders for the formats we ship plus the sinks.
+inline std::vector<std::string> default_preload_elements()
+{
+    return
+    {
+        "playbin",
+        "uridecodebin",
+        "decodebin",
+        "typefind",
+        "filesrc",
+        "souphttpsrc",
+        "queue2",
+        "id3demux",
+        "mpegaudioparse",
+        "mad",
+        "mpg123audiodec",
+        "oggdemux",
+        "vorbisdec",
+        "qtdemux",
+        "aacparse",
+        "audioconvert",
+        "audioresample",
+        "volume",
+        "pulsesink"
+    };
+}
+
+// CORE_UBUNTU_MEDIA_SERVICE_PRELOAD_ELEMENTS overrides the list with comma
+// separated factory names, an empty value or "none" disables preloading.
+inline std::vector<std::string> preload_elements()
+{
+    const char* value = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_PRELOAD_ELEMENTS");
+    if (value == nullptr)
+        return default_preload_elements();
+
+    std::vector<std::string> result;
+    if (std::string{value} == "none")
+        return result;
+
+    std::stringstream ss{value};
+    std::string name;
+    while (std::getline(ss, name, ','))
+        if (not name.empty())
+            result.push_back(name);
+
+    return result;
+}
+
+// Loads the registry and dlopens the plugins behind the given elements by
+// instantiating and discarding one of each, such that the first Playbin
+// doesn't pay for it. Lowers the priority of the calling thread to idle
+// once GStreamer is initialized, meant to be run on a thread of its own.
+inline void preload(const std::vector<std::string>& elements)
+{
+    if (elements.empty())
+        return;
+
+    MH_TRACE_SCOPE("gst", "preload");
+    const auto start = std::chrono::steady_clock::now();
+
+    // A Playbin constructed meanwhile waits for init() to finish, which
+    // must not be held up by an idle priority thread.
+    gstreamer::init();
+
+    sched_param param{0};
+    if (::pthread_setschedparam(::pthread_self(), SCHED_IDLE, &param) != 0)
+        MH_DEBUG("Could not lower priority of the preload thread");
+
+    std::size_t loaded = 0;
+    for (const auto& name : elements)
+    {
+        auto element = gst_element_factory_make(name.c_str(), nullptr);
+        if (element == nullptr)
+        {
+            MH_DEBUG("No element factory for " << name << ", not preloading it");
+            continue;
+        }
+
+        gst_object_unref(element);
+        loaded++;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+    core::ubuntu::media::metrics::gauge("startup.preload_us").set(elapsed.count());
+    MH_INFO("Preloaded " << loaded << " of " << elements.size() << " elements in "
+            << elapsed.count() / 1000 << "ms");
+}
+}
+
+#endif // GSTREAMER_PRELOAD_H_
@@ -0,0 +1,333 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSTREAMER_TASK_POOL_H_
+#define GSTREAMER_TASK_POOL_H_
+
+#include "../logger.h"
+#include "../metrics.h"
+#include "../scheduling.h"
+
+#include <gst/gst.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <pthread.h>
+
+namespace gstreamer
+{
+// The threads running the streaming tasks of all pipelines.
+//
+// A streaming task keeps its thread for as long as the pipeline streams, so
+// the number of busy threads cannot be bounded without stalling pipelines.
+// What is bounded are the idle threads: a thread whose task stopped waits for
+// the next one instead of exiting, such that tearing down and rebuilding
+// pipelines, e.g. when hibernating or skipping tracks, doesn't create threads.
+//
+// Threads are put back to the scheduling of the process after every task. A
+// scheduling class that can't be undone, see scheduling::reversible, gets
+// threads of its own which keep its policy between tasks instead.
+class StreamingThreads
+{
+public:
+    struct Job
+    {
+        GstTaskPoolFunction func;
+        gpointer data;
+        std::chrono::steady_clock::time_point queued;
+
+        std::mutex guard;
+        std::condition_variable finished;
+        bool done;
+    };
+
+    // Never destroyed, tasks might still be running at exit
+    static StreamingThreads& instance()
+    {
+        static auto threads = new StreamingThreads(false);
+        return *threads;
+    }
+
+    // The threads dedicated to a class that can't be undone
+    static StreamingThreads& instance_for(core::ubuntu::media::scheduling::Class c)
+    {
+        static std::mutex guard;
+        static std::map<core::ubuntu::media::scheduling::Class, StreamingThreads*> dedicated;
+
+        std::lock_guard<std::mutex> lg(guard);
+        auto& threads = dedicated[c];
+        if (threads == nullptr)
+            threads = new StreamingThreads(true);
+        return *threads;
+    }
+
+    Job* push(GstTaskPoolFunction func, gpointer data, GError** error)
+    {
+        auto job = new Job;
+        job->func = func;
+        job->data = data;
+        job->queued = std::chrono::steady_clock::now();
+        job->done = false;
+
+        std::lock_guard<std::mutex> lg(guard);
+        queue.push_back(job);
+
+        if (queue.size() <= idle)
+        {
+            wakeup.notify_one();
+            return job;
+        }
+
+        if (!spawn())
+        {
+            queue.pop_back();
+            delete job;
+            g_set_error(error, GST_CORE_ERROR, GST_CORE_ERROR_FAILED, "Failed to create streaming thread");
+            return nullptr;
+        }
+
+        return job;
+    }
+
+    void join(Job* job)
+    {
+        {
+            std::unique_lock<std::mutex> ul(job->guard);
+            job->finished.wait(ul, [job]() { return job->done; });
+        }
+        delete job;
+    }
+
+private:
+    explicit StreamingThreads(bool keep_scheduling)
+        : keep_scheduling(keep_scheduling),
+          idle(0),
+          max_idle(env_or("CORE_UBUNTU_MEDIA_SERVICE_STREAMING_THREADS_IDLE", 8)),
+          stack_size(env_or("CORE_UBUNTU_MEDIA_SERVICE_STREAMING_THREAD_STACK_KB", 0) * 1024),
+          idle_timeout(std::chrono::seconds{30}),
+          threads(core::ubuntu::media::metrics::gauge("gst.streaming_threads")),
+          idle_threads(core::ubuntu::media::metrics::gauge("gst.streaming_threads.idle")),
+          spawned(core::ubuntu::media::metrics::counter("gst.streaming_threads.spawned")),
+          dispatch_latency(core::ubuntu::media::metrics::histogram("gst.streaming_tasks.dispatch_us"))
+    {
+    }
+
+    static unsigned int env_or(const char* name, unsigned int fallback)
+    {
+        const char* value = ::getenv(name);
+        return value != nullptr ? std::strtoul(value, nullptr, 10) : fallback;
+    }
+
+    // Called with the guard held
+    bool spawn()
+    {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (stack_size > 0)
+            pthread_attr_setstacksize(&attr, std::max<std::size_t>(stack_size, PTHREAD_STACK_MIN));
+
+        pthread_t thread;
+        const int rc = pthread_create(&thread, &attr, &StreamingThreads::run, this);
+        pthread_attr_destroy(&attr);
+
+        if (rc != 0)
+        {
+            MH_WARNING("Failed to create streaming thread: " << std::strerror(rc));
+            return false;
+        }
+
+        threads.add(1);
+        spawned.increment();
+        return true;
+    }
+
+    static void* run(void* data)
+    {
+        auto thiz = static_cast<StreamingThreads*>(data);
+        pthread_setname_np(pthread_self(), "mh-streaming");
+
+        std::unique_lock<std::mutex> ul(thiz->guard);
+        while (true)
+        {
+            if (thiz->queue.empty())
+            {
+                thiz->idle++;
+                thiz->idle_threads.add(1);
+
+                const bool woken = thiz->wakeup.wait_for(ul, thiz->idle_timeout, [thiz]() { return !thiz->queue.empty(); });
+
+                thiz->idle--;
+                thiz->idle_threads.add(-1);
+
+                if (!woken)
+                    break;
+            }
+
+            auto job = thiz->queue.front();
+            thiz->queue.pop_front();
+            ul.unlock();
+
+            thiz->dispatch_latency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                                              std::chrono::steady_clock::now() - job->queued).count());
+            job->func(job->data);
+
+            {
+                std::lock_guard<std::mutex> lg(job->guard);
+                job->done = true;
+            }
+            job->finished.notify_all();
+
+            // Tasks leave their scheduling policy behind, see scheduling::apply.
+            // A thread that can't shed it anyway is not handed the next task.
+            if (!thiz->keep_scheduling && !core::ubuntu::media::scheduling::reset())
+            {
+                thiz->threads.add(-1);
+                return nullptr;
+            }
+
+            ul.lock();
+            if (thiz->queue.empty() && thiz->idle >= thiz->max_idle)
+                break;
+        }
+
+        thiz->threads.add(-1);
+        return nullptr;
+    }
+
+    // Only ever runs tasks of a single class, the policy is kept between them
+    const bool keep_scheduling;
+
+    std::mutex guard;
+    std::condition_variable wakeup;
+    std::deque<Job*> queue;
+    // Threads waiting for a job
+    unsigned int idle;
+
+    const unsigned int max_idle;
+    const std::size_t stack_size;
+    const std::chrono::seconds idle_timeout;
+
+    core::ubuntu::media::metrics::Gauge& threads;
+    core::ubuntu::media::metrics::Gauge& idle_threads;
+    core::ubuntu::media::metrics::Counter& spawned;
+    core::ubuntu::media::metrics::Histogram& dispatch_latency;
+};
+
+// A GstTaskPool handing tasks to StreamingThreads
+struct SharedTaskPool
+{
+    GstTaskPool parent;
+    StreamingThreads* threads;
+};
+
+struct SharedTaskPoolClass
+{
+    GstTaskPoolClass parent_class;
+};
+
+inline void shared_task_pool_prepare(GstTaskPool*, GError**)
+{
+}
+
+inline void shared_task_pool_cleanup(GstTaskPool*)
+{
+}
+
+inline gpointer shared_task_pool_push(GstTaskPool* pool, GstTaskPoolFunction func, gpointer data, GError** error)
+{
+    return reinterpret_cast<SharedTaskPool*>(pool)->threads->push(func, data, error);
+}
+
+inline void shared_task_pool_join(GstTaskPool* pool, gpointer id)
+{
+    if (id != nullptr)
+        reinterpret_cast<SharedTaskPool*>(pool)->threads->join(static_cast<StreamingThreads::Job*>(id));
+}
+
+inline void shared_task_pool_class_init(gpointer klass, gpointer)
+{
+    auto pool_class = GST_TASK_POOL_CLASS(klass);
+    pool_class->prepare = shared_task_pool_prepare;
+    pool_class->cleanup = shared_task_pool_cleanup;
+    pool_class->push = shared_task_pool_push;
+    pool_class->join = shared_task_pool_join;
+}
+
+inline GType shared_task_pool_get_type()
+{
+    static const GType type = g_type_register_static_simple(
+                GST_TYPE_TASK_POOL,
+                "MediaHubSharedTaskPool",
+                sizeof(SharedTaskPoolClass),
+                shared_task_pool_class_init,
+                sizeof(SharedTaskPool),
+                nullptr,
+                static_cast<GTypeFlags>(0));
+    return type;
+}
+
+inline GstTaskPool* create_shared_task_pool(StreamingThreads& threads)
+{
+    auto pool = GST_TASK_POOL(g_object_new(shared_task_pool_get_type(), nullptr));
+    reinterpret_cast<SharedTaskPool*>(pool)->threads = &threads;
+    gst_object_ref_sink(pool);
+    gst_task_pool_prepare(pool, nullptr);
+    return pool;
+}
+
+// The pool for the streaming tasks of pipelines scheduled as c, or nullptr
+// if CORE_UBUNTU_MEDIA_SERVICE_SHARED_TASK_POOL is set to 0 and every task
+// gets a thread from the GStreamer default pool. All classes whose policy
+// can be undone share one pool, every other class has a pool of its own.
+inline GstTaskPool* shared_task_pool(core::ubuntu::media::scheduling::Class c)
+{
+    static const bool enabled = []()
+    {
+        const char* value = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_SHARED_TASK_POOL");
+        return value == nullptr || std::string{value} != "0";
+    }();
+
+    if (!enabled)
+        return nullptr;
+
+    if (core::ubuntu::media::scheduling::reversible(c))
+    {
+        static GstTaskPool* const pool = create_shared_task_pool(StreamingThreads::instance());
+        return pool;
+    }
+
+    static std::mutex guard;
+    static std::map<core::ubuntu::media::scheduling::Class, GstTaskPool*> dedicated;
+
+    std::lock_guard<std::mutex> lg(guard);
+    auto& pool = dedicated[c];
+    if (pool == nullptr)
+        pool = create_shared_task_pool(StreamingThreads::instance_for(c));
+    return pool;
+}
+}
+
+#endif // GSTREAMER_TASK_POOL_H_
@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef GSTREAMER_THUMBNAILER_H_
+#define GSTREAMER_THUMBNAILER_H_
+
+#include "init.h"
+#include "task_pool.h"
+#include "../logger.h"
+#include "../scheduling.h"
+#include "../trace.h"
+
+#include <gst/gst.h>
+
+#include <sstream>
+#include <string>
+
+namespace gstreamer
+{
+// Runs the streaming threads of a thumbnail pipeline as background work,
+// on the threads of the background pool if there is one, leaving all
+// messages to be popped from the bus.
+inline GstBusSyncReply demote_streaming_threads(GstBus*, GstMessage* msg, gpointer)
+{
+    if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_STREAM_STATUS)
+    {
+        GstStreamStatusType type;
+        GstElement* owner;
+        gst_message_parse_stream_status(msg, &type, &owner);
+        if (type == GST_STREAM_STATUS_TYPE_CREATE)
+        {
+            auto pool = shared_task_pool(core::ubuntu::media::scheduling::Class::background);
+            const GValue* value = gst_message_get_stream_status_object(msg);
+            if (pool != nullptr && value != nullptr && G_VALUE_TYPE(value) == GST_TYPE_TASK)
+                gst_task_set_pool(GST_TASK(g_value_get_object(value)), pool);
+        } else if (type == GST_STREAM_STATUS_TYPE_ENTER)
+        {
+            core::ubuntu::media::scheduling::apply(core::ubuntu::media::scheduling::Class::background);
+        }
+    }
+
+    return GST_BUS_PASS;
+}
+
+// Decodes an encoded image (jpeg, png, ...), scales it to fit a size x size
+// square keeping its aspect and writes it to path as png. Blocks until the
+// image is written or a few seconds have passed, meant for a worker thread.
+inline bool write_thumbnail(const std::string& data, const std::string& path, unsigned int size)
+{
+    MH_TRACE_SCOPE("gst", "write_thumbnail");
+    gstreamer::init();
+
+    std::stringstream ss;
+    ss << "appsrc name=src ! decodebin ! videoconvert ! videoscale add-borders=true ! "
+       << "video/x-raw,format=RGBA,width=" << size << ",height=" << size << ",pixel-aspect-ratio=1/1 ! "
+       << "pngenc snapshot=true ! filesink name=sink";
+
+    GError* error = nullptr;
+    auto pipeline = gst_parse_launch(ss.str().c_str(), &error);
+    if (error != nullptr)
+    {
+        MH_WARNING("Could not create thumbnail pipeline: " << error->message);
+        g_error_free(error);
+        if (pipeline != nullptr)
+            gst_object_unref(pipeline);
+        return false;
+    }
+
+    auto src = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+    auto sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    g_object_set(sink, "location", path.c_str(), NULL);
+
+    auto buffer = gst_buffer_new_allocate(nullptr, data.size(), nullptr);
+    gst_buffer_fill(buffer, 0, data.data(), data.size());
+
+    auto bus = gst_element_get_bus(pipeline);
+    gst_bus_set_sync_handler(bus, demote_streaming_threads, nullptr, nullptr);
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    GstFlowReturn flow_return;
+    g_signal_emit_by_name(src, "push-buffer", buffer, &flow_return);
+    gst_buffer_unref(buffer);
+    g_signal_emit_by_name(src, "end-of-stream", &flow_return);
+
+    auto msg = gst_bus_timed_pop_filtered(
+                bus,
+                5 * GST_SECOND,
+                static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+
+    const bool written = msg != nullptr && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS;
+    if (msg != nullptr)
+        gst_message_unref(msg);
+
+    gst_object_unref(bus);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(src);
+    gst_object_unref(sink);
+    gst_object_unref(pipeline);
+
+    return written;
+}
+}
+
+#endif // GSTREAMER_THUMBNAILER_H_
@@ -0,0 +1,330 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace log = core::ubuntu::media::log;
+
+namespace
+{
+struct Entry
+{
+    log::Level level;
+    std::chrono::system_clock::time_point when;
+    std::string message;
+};
+
+// Single producer (the owning thread), single consumer (whoever holds
+// the drain lock of the Logger).
+struct Ring
+{
+    static constexpr std::size_t capacity = 1024;
+
+    Ring() : tid(::syscall(SYS_gettid)), slots(capacity), head(0), tail(0), dropped(0)
+    {
+    }
+
+    bool push(Entry&& entry)
+    {
+        const auto h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == capacity)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        slots[h % capacity] = std::move(entry);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    template<typename F>
+    void drain(F f)
+    {
+        auto t = tail.load(std::memory_order_relaxed);
+        const auto h = head.load(std::memory_order_acquire);
+        for (; t != h; t++)
+            f(tid, std::move(slots[t % capacity]));
+        tail.store(t, std::memory_order_release);
+    }
+
+    const long tid;
+    std::vector<Entry> slots;
+    std::atomic<std::size_t> head;
+    std::atomic<std::size_t> tail;
+    std::atomic<std::uint64_t> dropped;
+};
+
+constexpr std::size_t Ring::capacity;
+
+const char* tag_for(log::Level level)
+{
+    switch (level)
+    {
+    case log::Level::trace: return "T";
+    case log::Level::debug: return "D";
+    case log::Level::info: return "I";
+    case log::Level::warning: return "W";
+    case log::Level::error: return "E";
+    }
+    return "?";
+}
+
+void write_fully(int fd, const std::string& data)
+{
+    std::size_t offset = 0;
+    while (offset < data.size())
+    {
+        auto rc = ::write(fd, data.data() + offset, data.size() - offset);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        offset += rc;
+    }
+}
+
+class Logger
+{
+public:
+    // Intentionally leaked, messages might still be logged during static destruction
+    static Logger& instance()
+    {
+        static Logger* logger = new Logger();
+        return *logger;
+    }
+
+    void write(log::Level level, std::string&& message)
+    {
+        auto& ring = this_thread_ring();
+        ring.push(Entry{level, std::chrono::system_clock::now(), std::move(message)});
+
+        // After shutdown, for errors or bursts we do not wait for the next flush
+        if (stopped.load(std::memory_order_acquire))
+            flush();
+        else if (level >= log::Level::warning || ring.size() >= Ring::capacity / 2)
+            wake(true);
+        else
+        {
+            // Pairs with the fence in run(): either the flusher sees this
+            // message or we see that no flush is pending
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!pending.load(std::memory_order_relaxed))
+                wake(false);
+        }
+    }
+
+    void flush()
+    {
+        std::lock_guard<std::mutex> lg(drain_guard);
+
+        std::vector<std::pair<long, Entry>> entries;
+        std::uint64_t dropped = 0;
+        {
+            std::lock_guard<std::mutex> rlg(rings_guard);
+            for (const auto& ring : rings)
+            {
+                ring->drain([&entries](long tid, Entry&& entry)
+                {
+                    entries.emplace_back(tid, std::move(entry));
+                });
+                dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+            }
+
+            // Rings of exited threads are only referenced from here
+            rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::shared_ptr<Ring>& ring)
+            {
+                return ring.use_count() == 1 && ring->empty();
+            }), rings.end());
+        }
+
+        // Restore the global order of messages logged from different threads
+        std::stable_sort(entries.begin(), entries.end(), [](const std::pair<long, Entry>& lhs, const std::pair<long, Entry>& rhs)
+        {
+            return lhs.second.when < rhs.second.when;
+        });
+
+        std::string out, err;
+        for (const auto& pair : entries)
+        {
+            auto& target = pair.second.level >= log::Level::warning ? err : out;
+            format(target, pair.first, pair.second);
+        }
+        if (dropped > 0)
+            err += "[W] Dropped " + std::to_string(dropped) + " log messages\n";
+
+        write_fully(STDOUT_FILENO, out);
+        write_fully(STDERR_FILENO, err);
+    }
+
+private:
+    Logger() : stopped(false), pending(false), urgent(false)
+    {
+        flusher = std::thread([this]() { run(); });
+        std::atexit([]() { Logger::instance().shutdown(); });
+    }
+
+    static void format(std::string& target, long tid, const Entry& entry)
+    {
+        const auto t = std::chrono::system_clock::to_time_t(entry.when);
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    entry.when.time_since_epoch()).count() % 1000;
+
+        struct tm tm;
+        ::localtime_r(&t, &tm);
+
+        char prefix[64];
+        std::snprintf(prefix, sizeof(prefix), "[%s %02d:%02d:%02d.%03d %ld] ",
+                      tag_for(entry.level), tm.tm_hour, tm.tm_min, tm.tm_sec, static_cast<int>(ms), tid);
+
+        target += prefix;
+        target += entry.message;
+        target += '\n';
+    }
+
+    std::shared_ptr<Ring> create_ring()
+    {
+        auto ring = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lg(rings_guard);
+        rings.push_back(ring);
+        return ring;
+    }
+
+    Ring& this_thread_ring()
+    {
+        static thread_local std::shared_ptr<Ring> ring = create_ring();
+        return *ring;
+    }
+
+    // Only the first message of a batch and urgent ones take the lock
+    void wake(bool now)
+    {
+        {
+            std::lock_guard<std::mutex> lg(wakeup_guard);
+            pending.store(true, std::memory_order_release);
+            urgent = urgent || now;
+        }
+        wakeup.notify_one();
+    }
+
+    // Sleeps until something was logged, such that idle processes, e.g.
+    // clients of the service, never wake up for logging.
+    void run()
+    {
+        static const std::chrono::milliseconds flush_interval{100};
+
+        std::unique_lock<std::mutex> ul(wakeup_guard);
+        while (!stopped.load(std::memory_order_acquire))
+        {
+            wakeup.wait(ul, [this]() { return pending.load(std::memory_order_acquire) || stopped.load(std::memory_order_acquire); });
+            // Let the batch fill up a little
+            wakeup.wait_for(ul, flush_interval, [this]() { return urgent || stopped.load(std::memory_order_acquire); });
+
+            pending.store(false, std::memory_order_relaxed);
+            urgent = false;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            ul.unlock();
+            flush();
+            ul.lock();
+        }
+    }
+
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lg(wakeup_guard);
+            stopped.store(true, std::memory_order_release);
+        }
+        wakeup.notify_one();
+        if (flusher.joinable())
+            flusher.join();
+        flush();
+    }
+
+    std::mutex rings_guard;
+    std::vector<std::shared_ptr<Ring>> rings;
+
+    std::mutex drain_guard;
+
+    std::atomic<bool> stopped;
+    std::mutex wakeup_guard;
+    std::condition_variable wakeup;
+    // Messages are waiting for the flusher
+    std::atomic<bool> pending;
+    // Guarded by wakeup_guard
+    bool urgent;
+    std::thread flusher;
+};
+
+int initial_threshold()
+{
+    const char* value = std::getenv("CORE_UBUNTU_MEDIA_SERVICE_LOG_LEVEL");
+    if (value == nullptr)
+        return static_cast<int>(log::Level::info);
+
+    static const char* const names[] = {"trace", "debug", "info", "warning", "error"};
+    for (int i = 0; i < 5; i++)
+        if (std::strcmp(value, names[i]) == 0)
+            return i;
+
+    return static_cast<int>(log::Level::info);
+}
+}
+
+std::atomic<int> log::detail::threshold{initial_threshold()};
+
+void log::set_level(log::Level level)
+{
+    detail::threshold.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void log::write(log::Level level, std::string message)
+{
+    Logger::instance().write(level, std::move(message));
+}
+
+void log::flush()
+{
+    Logger::instance().flush();
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_UBUNTU_MEDIA_LOGGER_H_
+#define CORE_UBUNTU_MEDIA_LOGGER_H_
+
+#include <atomic>
+#include <sstream>
+#include <string>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+namespace log
+{
+enum class Level
+{
+    // Per message or per buffer output, only useful when chasing a bug
+    trace,
+    debug,
+    info,
+    warning,
+    error
+};
+
+namespace detail
+{
+extern std::atomic<int> threshold;
+}
+
+// The threshold defaults to info and can be adjusted by setting
+// CORE_UBUNTU_MEDIA_SERVICE_LOG_LEVEL to trace, debug, info, warning or error.
+inline bool is_enabled(Level level)
+{
+    return static_cast<int>(level) >= detail::threshold.load(std::memory_order_relaxed);
+}
+
+void set_level(Level level);
+
+// Hands the message to the background flusher. Never waits for output: every
+// thread owns a lock-free ring and messages are dropped, and counted, if it is full.
+void write(Level level, std::string message);
+
+// Blocks until all messages written so far are out
+void flush();
+}
+}
+}
+}
+
+// Formatting only happens if the level is enabled, e.g.:
+//   MH_INFO("Pausing Player with key: " << key);
+#define MH_LOG(level, expr) \
+    do \
+    { \
+        if (core::ubuntu::media::log::is_enabled(level)) \
+        { \
+            std::ostringstream mh_log_ss; \
+            mh_log_ss << expr; \
+            core::ubuntu::media::log::write(level, mh_log_ss.str()); \
+        } \
+    } while(0)
+
+#define MH_TRACE(expr) MH_LOG(core::ubuntu::media::log::Level::trace, expr)
+#define MH_DEBUG(expr) MH_LOG(core::ubuntu::media::log::Level::debug, expr)
+#define MH_INFO(expr) MH_LOG(core::ubuntu::media::log::Level::info, expr)
+#define MH_WARNING(expr) MH_LOG(core::ubuntu::media::log::Level::warning, expr)
+#define MH_ERROR(expr) MH_LOG(core::ubuntu::media::log::Level::error, expr)
+
+#endif // CORE_UBUNTU_MEDIA_LOGGER_H_
@@ -0,0 +1,231 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include <time.h>
+#include <unistd.h>
+
+namespace metrics = core::ubuntu::media::metrics;
+
+std::size_t metrics::this_thread_stripe()
+{
+    static std::atomic<std::size_t> next_stripe{0};
+    static thread_local const std::size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % stripe_count;
+    return stripe;
+}
+
+std::uint64_t metrics::Counter::value() const
+{
+    std::uint64_t result = 0;
+    for (const auto& stripe : stripes)
+        result += stripe.value.load(std::memory_order_relaxed);
+    return result;
+}
+
+constexpr std::size_t metrics::Histogram::sub_bucket_bits;
+constexpr std::size_t metrics::Histogram::sub_bucket_count;
+constexpr std::size_t metrics::Histogram::max_magnitude;
+constexpr std::size_t metrics::Histogram::bucket_count;
+
+std::size_t metrics::Histogram::bucket_for(std::uint64_t value)
+{
+    if (value < sub_bucket_count)
+        return value;
+
+    std::size_t magnitude = 63 - __builtin_clzll(value);
+    if (magnitude > max_magnitude)
+        return bucket_count - 1;
+
+    const std::size_t shift = magnitude - sub_bucket_bits;
+    const std::size_t sub_bucket = (value >> shift) - sub_bucket_count;
+    return sub_bucket_count * (shift + 1) + sub_bucket;
+}
+
+std::uint64_t metrics::Histogram::value_for(std::size_t bucket)
+{
+    if (bucket < sub_bucket_count)
+        return bucket;
+
+    const std::size_t shift = bucket / sub_bucket_count - 1;
+    const std::uint64_t lower = static_cast<std::uint64_t>(sub_bucket_count + bucket % sub_bucket_count) << shift;
+    return lower + ((std::uint64_t{1} << shift) >> 1);
+}
+
+metrics::Histogram::Histogram() : count(0), sum(0), maximum(0)
+{
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+void metrics::Histogram::record(std::uint64_t value)
+{
+    buckets[bucket_for(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    auto current = maximum.load(std::memory_order_relaxed);
+    while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        ;
+}
+
+metrics::Histogram::Summary metrics::Histogram::summary() const
+{
+    Summary result{0, 0., 0, 0, 0, maximum.load(std::memory_order_relaxed)};
+
+    // Counts are read bucket by bucket, the total is taken from
+    // the buckets to stay consistent with concurrent recording.
+    std::array<std::uint64_t, bucket_count> snapshot;
+    for (std::size_t i = 0; i < bucket_count; i++)
+    {
+        snapshot[i] = buckets[i].load(std::memory_order_relaxed);
+        result.count += snapshot[i];
+    }
+
+    if (result.count == 0)
+        return result;
+
+    result.mean = static_cast<double>(sum.load(std::memory_order_relaxed)) / count.load(std::memory_order_relaxed);
+
+    const std::uint64_t p50_rank = (result.count * 50 + 99) / 100;
+    const std::uint64_t p90_rank = (result.count * 90 + 99) / 100;
+    const std::uint64_t p99_rank = (result.count * 99 + 99) / 100;
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucket_count; i++)
+    {
+        if (snapshot[i] == 0)
+            continue;
+
+        const std::uint64_t before = seen;
+        seen += snapshot[i];
+
+        if (before < p50_rank && seen >= p50_rank)
+            result.p50 = value_for(i);
+        if (before < p90_rank && seen >= p90_rank)
+            result.p90 = value_for(i);
+        if (before < p99_rank && seen >= p99_rank)
+            result.p99 = value_for(i);
+    }
+
+    return result;
+}
+
+metrics::Registry& metrics::Registry::instance()
+{
+    static Registry registry;
+    return registry;
+}
+
+metrics::Counter& metrics::Registry::counter(const std::string& name)
+{
+    std::lock_guard<std::mutex> lg(guard);
+    auto& entry = counters[name];
+    if (!entry)
+        entry.reset(new Counter());
+    return *entry;
+}
+
+metrics::Gauge& metrics::Registry::gauge(const std::string& name)
+{
+    std::lock_guard<std::mutex> lg(guard);
+    auto& entry = gauges[name];
+    if (!entry)
+        entry.reset(new Gauge());
+    return *entry;
+}
+
+metrics::Histogram& metrics::Registry::histogram(const std::string& name)
+{
+    std::lock_guard<std::mutex> lg(guard);
+    auto& entry = histograms[name];
+    if (!entry)
+        entry.reset(new Histogram());
+    return *entry;
+}
+
+std::map<std::string, double> metrics::Registry::snapshot() const
+{
+    std::map<std::string, double> result;
+
+    std::lock_guard<std::mutex> lg(guard);
+    for (const auto& pair : counters)
+        result[pair.first] = pair.second->value();
+    for (const auto& pair : gauges)
+        result[pair.first] = pair.second->value();
+    for (const auto& pair : histograms)
+    {
+        auto summary = pair.second->summary();
+        result[pair.first + ".count"] = summary.count;
+        result[pair.first + ".mean"] = summary.mean;
+        result[pair.first + ".p50"] = summary.p50;
+        result[pair.first + ".p90"] = summary.p90;
+        result[pair.first + ".p99"] = summary.p99;
+        result[pair.first + ".max"] = summary.max;
+    }
+
+    return result;
+}
+
+bool metrics::Registry::dump_to_file(const std::string& path) const
+{
+    const std::string tmp_path{path + ".tmp"};
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        if (!out)
+            return false;
+
+        for (const auto& pair : snapshot())
+            out << pair.first << " " << pair.second << "\n";
+
+        if (!out)
+            return false;
+    }
+
+    return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+std::chrono::microseconds metrics::time_since_process_start()
+{
+    std::ifstream in("/proc/self/stat");
+    std::string stat{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    // The command name may contain spaces, fields are counted from its closing
+    // parenthesis. starttime is field 22, the 20th after it.
+    const auto comm_end = stat.rfind(')');
+    if (comm_end == std::string::npos)
+        return std::chrono::microseconds{0};
+
+    unsigned long long start_ticks = 0;
+    if (std::sscanf(stat.c_str() + comm_end + 1,
+                    " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu",
+                    &start_ticks) != 1)
+        return std::chrono::microseconds{0};
+
+    // starttime is relative to boot, including suspend
+    timespec ts;
+    if (::clock_gettime(CLOCK_BOOTTIME, &ts) != 0)
+        return std::chrono::microseconds{0};
+
+    const std::int64_t now_us = std::int64_t{ts.tv_sec} * 1000000 + ts.tv_nsec / 1000;
+    const std::int64_t start_us = start_ticks * 1000000 / ::sysconf(_SC_CLK_TCK);
+    return std::chrono::microseconds{std::max<std::int64_t>(0, now_us - start_us)};
+}
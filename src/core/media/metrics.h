@@ -0,0 +1,240 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_UBUNTU_MEDIA_METRICS_H_
+#define CORE_UBUNTU_MEDIA_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+namespace metrics
+{
+// Hot counters are striped over this many cache lines. A thread always
+// hits the same stripe, so recording is an uncontended relaxed add.
+static constexpr std::size_t stripe_count = 8;
+
+// Returns the stripe assigned to the calling thread
+std::size_t this_thread_stripe();
+
+// Monotonically increasing count of events
+class Counter
+{
+public:
+    Counter() = default;
+    Counter(const Counter&) = delete;
+    Counter& operator=(const Counter&) = delete;
+
+    void increment(std::uint64_t delta = 1)
+    {
+        stripes[this_thread_stripe()].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const;
+
+private:
+    // Padded to a cache line to avoid false sharing between stripes
+    struct Stripe
+    {
+        std::atomic<std::uint64_t> value{0};
+        char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+    };
+    std::array<Stripe, stripe_count> stripes;
+};
+
+// Current value of a quantity, e.g. the number of active sessions
+class Gauge
+{
+public:
+    Gauge() = default;
+    Gauge(const Gauge&) = delete;
+    Gauge& operator=(const Gauge&) = delete;
+
+    void set(std::int64_t v)
+    {
+        current.store(v, std::memory_order_relaxed);
+    }
+
+    void add(std::int64_t delta)
+    {
+        current.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    std::int64_t value() const
+    {
+        return current.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::int64_t> current{0};
+};
+
+// HDR-style log-linear histogram. Values below 16 are recorded exactly,
+// every power of two above is split into 16 linear buckets, which bounds
+// the relative error to ~6%. Recording is lock-free.
+class Histogram
+{
+public:
+    struct Summary
+    {
+        std::uint64_t count;
+        double mean;
+        std::uint64_t p50;
+        std::uint64_t p90;
+        std::uint64_t p99;
+        std::uint64_t max;
+    };
+
+    // Values beyond 2^max_magnitude are clamped into the last bucket
+    static constexpr std::size_t sub_bucket_bits = 4;
+    static constexpr std::size_t sub_bucket_count = 1 << sub_bucket_bits;
+    static constexpr std::size_t max_magnitude = 40;
+    static constexpr std::size_t bucket_count = sub_bucket_count * (max_magnitude - sub_bucket_bits + 2);
+
+    static std::size_t bucket_for(std::uint64_t value);
+    // Returns the value in the middle of the given bucket
+    static std::uint64_t value_for(std::size_t bucket);
+
+    Histogram();
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    void record(std::uint64_t value);
+
+    Summary summary() const;
+
+private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets;
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> sum;
+    std::atomic<std::uint64_t> maximum;
+};
+
+// Owns all metrics of the process. Creating a metric takes a lock, callers
+// are expected to look up a metric once and keep the reference around.
+class Registry
+{
+public:
+    static Registry& instance();
+
+    Counter& counter(const std::string& name);
+    Gauge& gauge(const std::string& name);
+    Histogram& histogram(const std::string& name);
+
+    // Flattened view of all metrics. Histograms contribute name.count,
+    // name.mean, name.p50, name.p90, name.p99 and name.max.
+    std::map<std::string, double> snapshot() const;
+
+    // Writes the snapshot as "name value" lines, replacing path atomically
+    bool dump_to_file(const std::string& path) const;
+
+private:
+    Registry() = default;
+
+    mutable std::mutex guard;
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+};
+
+inline Counter& counter(const std::string& name)
+{
+    return Registry::instance().counter(name);
+}
+
+inline Gauge& gauge(const std::string& name)
+{
+    return Registry::instance().gauge(name);
+}
+
+inline Histogram& histogram(const std::string& name)
+{
+    return Registry::instance().histogram(name);
+}
+
+// Records the lifetime of the instance in microseconds
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram(histogram),
+          start(std::chrono::steady_clock::now())
+    {
+    }
+
+    // Also accounts for the time since start, for requests completed asynchronously
+    ScopedTimer(Histogram& histogram, std::chrono::steady_clock::time_point start)
+        : histogram(histogram),
+          start(start)
+    {
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer()
+    {
+        histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    Histogram& histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Time since the kernel started the process, which includes dynamic linking
+// and static initialization. Resolution is a clock tick, usually 10ms.
+std::chrono::microseconds time_since_process_start();
+
+// Wraps a callable such that the latency of every invocation is recorded
+template<typename F>
+struct Timed
+{
+    template<typename... Args>
+    void operator()(Args&&... args) const
+    {
+        ScopedTimer timer(*histogram);
+        f(std::forward<Args>(args)...);
+    }
+
+    Histogram* histogram;
+    F f;
+};
+
+template<typename F>
+Timed<F> timed(const std::string& name, F f)
+{
+    return Timed<F>{&metrics::histogram(name), f};
+}
+}
+}
+}
+}
+
+#endif // CORE_UBUNTU_MEDIA_METRICS_H_
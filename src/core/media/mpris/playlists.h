@@ -98,6 +98,27 @@ struct Playlists
         >
     > MaybePlaylist;
 
+    struct Errors
+    {
+        Errors() = delete;
+
+        struct UnknownPlaylist
+        {
+            static const std::string& name()
+            {
+                static const std::string s{"org.mpris.MediaPlayer2.Playlists.Error.UnknownPlaylist"}; return s;
+            }
+        };
+
+        struct Failed
+        {
+            static const std::string& name()
+            {
+                static const std::string s{"org.mpris.MediaPlayer2.Playlists.Error.Failed"}; return s;
+            }
+        };
+    };
+
     struct Methods
     {
         Methods() = delete;
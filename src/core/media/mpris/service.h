@@ -71,12 +71,42 @@ struct Service
                 return s;
             }
         };
+
+        struct SavingPlaylist
+        {
+            static const std::string& name()
+            {
+                static const std::string s
+                {
+                    "core.ubuntu.media.Service.Error.SavingPlaylist"
+                };
+                return s;
+            }
+        };
     };
 
     DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(CreateSession, Service, 1000)
     DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(CreateFixedSession, Service, 1000)
     DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(ResumeSession, Service, 1000)
     DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(PauseOtherSessions, Service, 1000)
+    // Saves the tracks of a session as a new playlist, offered through the
+    // MPRIS Playlists interface. Takes the session key and the name of the
+    // playlist, returns the object path of the playlist.
+    DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(SavePlaylist, Service, 1000)
+
+    // Exposes the service's runtime metrics and trace for diagnostics
+    struct Stats
+    {
+        static const std::string& name()
+        {
+            static const std::string s{"core.ubuntu.media.Service.Stats"};
+            return s;
+        }
+
+        DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(GetMetrics, Stats, 1000)
+        DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(SetTracing, Stats, 1000)
+        DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(DumpTrace, Stats, 5000)
+    };
 };
 }
 
@@ -44,6 +44,7 @@ struct TrackList
     }
 
     DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(GetTracksMetadata, TrackList, 1000)
+    DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(GetTracks, TrackList, 1000)
     DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(AddTrack, TrackList, 1000)
     DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(RemoveTrack, TrackList, 1000)
     DBUS_CPP_METHOD_WITH_TIMEOUT_DEF(GoTo, TrackList, 1000)
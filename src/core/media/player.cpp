@@ -42,3 +42,77 @@ media::Player::~Player()
 {
 }
 
+
+namespace
+{
+// Runs f right away and hands its outcome out as a ready future, used by
+// implementations that have no cheaper asynchronous path.
+template<typename T, typename F>
+std::future<T> completed(F f)
+{
+    std::promise<T> promise;
+    try
+    {
+        promise.set_value(f());
+    } catch (...)
+    {
+        promise.set_exception(std::current_exception());
+    }
+    return promise.get_future();
+}
+
+template<typename F>
+std::future<void> completed_void(F f)
+{
+    std::promise<void> promise;
+    try
+    {
+        f();
+        promise.set_value();
+    } catch (...)
+    {
+        promise.set_exception(std::current_exception());
+    }
+    return promise.get_future();
+}
+}
+
+std::future<bool> media::Player::open_uri_async(const media::Track::UriType& uri)
+{
+    return completed<bool>([this, &uri]() { return open_uri(uri); });
+}
+
+std::future<bool> media::Player::open_uri_async(const media::Track::UriType& uri, const media::Player::HeadersType& headers)
+{
+    return completed<bool>([this, &uri, &headers]() { return open_uri(uri, headers); });
+}
+
+std::future<void> media::Player::next_async()
+{
+    return completed_void([this]() { next(); });
+}
+
+std::future<void> media::Player::previous_async()
+{
+    return completed_void([this]() { previous(); });
+}
+
+std::future<void> media::Player::play_async()
+{
+    return completed_void([this]() { play(); });
+}
+
+std::future<void> media::Player::pause_async()
+{
+    return completed_void([this]() { pause(); });
+}
+
+std::future<void> media::Player::stop_async()
+{
+    return completed_void([this]() { stop(); });
+}
+
+std::future<void> media::Player::seek_to_async(const std::chrono::microseconds& offset)
+{
+    return completed_void([this, &offset]() { seek_to(offset); });
+}
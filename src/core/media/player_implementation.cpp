@@ -22,6 +22,8 @@
 #include <unistd.h>
 
 #include "engine.h"
+#include "logger.h"
+#include "metrics.h"
 #include "track_list_implementation.h"
 
 #include <hybris/media/media_codec_layer.h>
@@ -29,9 +31,10 @@
 #include "unity_screen_service.h"
 #include "gstreamer/engine.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <exception>
-#include <iostream>
 #include <mutex>
 
 #define UNUSED __attribute__((unused))
@@ -70,6 +73,7 @@ struct media::PlayerImplementation::Private :
           display_wakelock_count(0),
           previous_state(Engine::State::stopped),
           key(key),
+          last_activity(std::chrono::steady_clock::now().time_since_epoch().count()),
           engine_state_change_connection(engine->state().changed().connect(make_state_change_handler()))
     {
         auto bus = std::shared_ptr<dbus::Bus>(new dbus::Bus(core::dbus::WellKnownBus::system));
@@ -82,6 +86,8 @@ struct media::PlayerImplementation::Private :
         uscreen_session = uscreen_stub_service->object_for_path(dbus::types::ObjectPath("/com/canonical/Unity/Screen"));
 
         decoding_service_set_client_death_cb(&Private::on_client_died_cb, key, static_cast<void*>(this));
+
+        metrics::gauge("service.sessions").add(1);
     }
 
     ~Private()
@@ -94,6 +100,8 @@ struct media::PlayerImplementation::Private :
         // trigger the state change handler. Ensure the handler is not called
         // by disconnecting the state change signal
         engine_state_change_connection.disconnect();
+
+        metrics::gauge("service.sessions").add(-1);
     }
 
     std::function<void(const Engine::State& state)> make_state_change_handler()
@@ -150,6 +158,7 @@ struct media::PlayerImplementation::Private :
 
             // Keep track of the previous Engine playback state:
             previous_state = state;
+            touch();
         };
     }
 
@@ -165,7 +174,7 @@ struct media::PlayerImplementation::Private :
                     if (result.is_error())
                         throw std::runtime_error(result.error().print());
                     disp_cookie = result.value();
-                    cout << "Requested new display wakelock" << endl;
+                    MH_DEBUG("Requested new display wakelock");
                 }
             }
             else
@@ -176,20 +185,19 @@ struct media::PlayerImplementation::Private :
                     if (result.is_error())
                         throw std::runtime_error(result.error().print());
                     sys_cookie = result.value();
-                    cout << "Requested new system wakelock" << endl;
+                    MH_DEBUG("Requested new system wakelock");
                 }
             }
         }
         catch(const std::exception& e)
         {
-            std::cerr << "Warning: failed to request power state: ";
-            std::cerr << e.what() << std::endl;
+            MH_WARNING("Failed to request power state: " << e.what());
         }
     }
 
     void clear_wakelock(const wakelock_clear_t &wakelock)
     {
-        cout << __PRETTY_FUNCTION__ << endl;
+        MH_DEBUG(__PRETTY_FUNCTION__);
         try
         {
             switch (wakelock)
@@ -200,7 +208,7 @@ struct media::PlayerImplementation::Private :
                     // Only actually clear the system wakelock once the count reaches zero
                     if (--system_wakelock_count == 0)
                     {
-                        cout << "Clearing system wakelock" << endl;
+                        MH_DEBUG("Clearing system wakelock");
                         powerd_session->invoke_method_synchronously<core::Powerd::clearSysState, void>(sys_cookie);
                         sys_cookie.clear();
                     }
@@ -209,20 +217,19 @@ struct media::PlayerImplementation::Private :
                     // Only actually clear the display wakelock once the count reaches zero
                     if (--display_wakelock_count == 0)
                     {
-                        cout << "Clearing display wakelock" << endl;
+                        MH_DEBUG("Clearing display wakelock");
                         uscreen_session->invoke_method_synchronously<core::UScreen::removeDisplayOnRequest, void>(disp_cookie);
                         disp_cookie = -1;
                     }
                     break;
                 case wakelock_clear_t::WAKELOCK_CLEAR_INVALID:
                 default:
-                    cerr << "Can't clear invalid wakelock type" << endl;
+                    MH_ERROR("Can't clear invalid wakelock type");
             }
         }
         catch(const std::exception& e)
         {
-            std::cerr << "Warning: failed to clear power state: ";
-            std::cerr << e.what() << std::endl;
+            MH_WARNING("Failed to clear power state: " << e.what());
         }
     }
 
@@ -275,6 +282,24 @@ struct media::PlayerImplementation::Private :
         engine->reset();
     }
 
+    // Remembers when the player was last used, for idle hibernation
+    void touch()
+    {
+        last_activity = std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    std::chrono::steady_clock::duration idle_time() const
+    {
+        return std::chrono::steady_clock::now().time_since_epoch() -
+                std::chrono::steady_clock::duration(last_activity.load());
+    }
+
+    void set_uri(const Track::UriType& new_uri)
+    {
+        std::lock_guard<std::mutex> lg(uri_guard);
+        uri = new_uri;
+    }
+
     PlayerImplementation* parent;
     std::shared_ptr<Service> service;
     std::shared_ptr<Engine> engine;
@@ -289,6 +314,10 @@ struct media::PlayerImplementation::Private :
     std::atomic<int> display_wakelock_count;
     Engine::State previous_state;
     PlayerImplementation::PlayerKey key;
+    std::atomic<std::chrono::steady_clock::rep> last_activity;
+    // The uri last opened, for checkpointing the session
+    mutable std::mutex uri_guard;
+    Track::UriType uri;
     core::Signal<> on_client_disconnected;
     core::Connection engine_state_change_connection;
 };
@@ -324,6 +353,8 @@ media::PlayerImplementation::PlayerImplementation(
     is_audio_source().set(false);
     is_shuffle().set(true);
     playback_rate().set(1.f);
+    minimum_playback_rate().set(Engine::min_playback_rate());
+    maximum_playback_rate().set(Engine::max_playback_rate());
     playback_status().set(Player::PlaybackStatus::null);
     loop_status().set(Player::LoopStatus::none);
     position().set(0);
@@ -376,6 +407,20 @@ media::PlayerImplementation::PlayerImplementation(
         orientation().set(o);
     });
 
+    // Forward rate changes requested by the client to the Engine. As per the
+    // mpris spec a rate of 0 pauses playback.
+    playback_rate().changed().connect([this](media::Player::PlaybackRate rate)
+    {
+        if (rate == 0.)
+        {
+            pause();
+            return;
+        }
+
+        d->engine->playback_rate().set(
+                    std::min(std::max(rate, Engine::min_playback_rate()), Engine::max_playback_rate()));
+    });
+
     lifetime().changed().connect([this](media::Player::Lifetime lifetime)
     {
         d->engine->lifetime().set(lifetime);
@@ -472,11 +517,15 @@ media::Player::PlayerKey media::PlayerImplementation::key() const
 
 bool media::PlayerImplementation::open_uri(const Track::UriType& uri)
 {
+    d->touch();
+    d->set_uri(uri);
     return d->engine->open_resource_for_uri(uri);
 }
 
 bool media::PlayerImplementation::open_uri(const Track::UriType& uri, const Player::HeadersType& headers)
 {
+    d->touch();
+    d->set_uri(uri);
     return d->engine->open_resource_for_uri(uri, headers);
 }
 
@@ -501,17 +550,20 @@ void media::PlayerImplementation::previous()
 
 void media::PlayerImplementation::play()
 {
+    d->touch();
     d->engine->play();
 }
 
 void media::PlayerImplementation::pause()
 {
+    d->touch();
     d->engine->pause();
 }
 
 void media::PlayerImplementation::stop()
 {
-    std::cout << __PRETTY_FUNCTION__ << std::endl;
+    MH_DEBUG(__PRETTY_FUNCTION__);
+    d->touch();
     d->engine->stop();
 }
 
@@ -529,9 +581,37 @@ void media::PlayerImplementation::set_playback_complete_callback(
 
 void media::PlayerImplementation::seek_to(const std::chrono::microseconds& ms)
 {
+    d->touch();
     d->engine->seek_to(ms);
 }
 
+bool media::PlayerImplementation::hibernate_if_idle_for(const std::chrono::seconds& idle_time)
+{
+    if (d->engine->is_hibernated() || d->idle_time() < idle_time)
+        return false;
+
+    // The engine refuses while playing
+    return d->engine->hibernate();
+}
+
+media::Track::UriType media::PlayerImplementation::uri() const
+{
+    std::lock_guard<std::mutex> lg(d->uri_guard);
+    return d->uri;
+}
+
+std::vector<media::Track::UriType> media::PlayerImplementation::track_uris() const
+{
+    return d->track_list->uris();
+}
+
+bool media::PlayerImplementation::restore_uri(const Track::UriType& uri, const std::chrono::microseconds& position)
+{
+    // Deliberately not touching the player, it stays idle until used
+    d->set_uri(uri);
+    return d->engine->restore_resource_for_uri(uri, position);
+}
+
 const core::Signal<>& media::PlayerImplementation::on_client_disconnected() const
 {
     return d->on_client_disconnected;
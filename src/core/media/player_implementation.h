@@ -21,7 +21,9 @@
 
 #include "player_skeleton.h"
 
+#include <chrono>
 #include <memory>
+#include <vector>
 
 namespace core
 {
@@ -59,6 +61,17 @@ public:
     virtual void set_playback_complete_callback(PlaybackCompleteCb cb, void *context);
     virtual void seek_to(const std::chrono::microseconds& offset);
 
+    // Releases the engine's pipeline if the player saw no activity for the given time
+    bool hibernate_if_idle_for(const std::chrono::seconds& idle_time);
+
+    // The uri last opened, empty if none
+    Track::UriType uri() const;
+    // The uris of all tracks in the track list, in order. Safe to call from
+    // any thread.
+    std::vector<Track::UriType> track_uris() const;
+    // Opens uri without building a pipeline, playback starts out at position
+    bool restore_uri(const Track::UriType& uri, const std::chrono::microseconds& position);
+
     const core::Signal<>& on_client_disconnected() const;
 private:
     struct Private;
@@ -19,10 +19,13 @@
 
 #include "apparmor.h"
 #include "codec.h"
+#include "logger.h"
+#include "metrics.h"
 #include "player_skeleton.h"
 #include "player_traits.h"
 #include "property_stub.h"
 #include "the_session_bus.h"
+#include "trace.h"
 #include "xesam.h"
 
 #include "mpris/media_player2.h"
@@ -66,6 +69,7 @@ struct media::PlayerSkeleton::Private
 
     void handle_next(const core::dbus::Message::Ptr& msg)
     {
+        MH_TRACE_SCOPE("dbus", "Player.Next");
         impl->next();
         auto reply = dbus::Message::make_method_return(msg);
         bus->send(reply);
@@ -73,6 +77,7 @@ struct media::PlayerSkeleton::Private
 
     void handle_previous(const core::dbus::Message::Ptr& msg)
     {
+        MH_TRACE_SCOPE("dbus", "Player.Previous");
         impl->previous();
         auto reply = dbus::Message::make_method_return(msg);
         bus->send(reply);
@@ -80,6 +85,7 @@ struct media::PlayerSkeleton::Private
 
     void handle_pause(const core::dbus::Message::Ptr& msg)
     {
+        MH_TRACE_SCOPE("dbus", "Player.Pause");
         impl->pause();
         auto reply = dbus::Message::make_method_return(msg);
         bus->send(reply);
@@ -87,6 +93,7 @@ struct media::PlayerSkeleton::Private
 
     void handle_stop(const core::dbus::Message::Ptr& msg)
     {
+        MH_TRACE_SCOPE("dbus", "Player.Stop");
         impl->stop();
         auto reply = dbus::Message::make_method_return(msg);
         bus->send(reply);
@@ -94,6 +101,7 @@ struct media::PlayerSkeleton::Private
 
     void handle_play(const core::dbus::Message::Ptr& msg)
     {
+        MH_TRACE_SCOPE("dbus", "Player.Play");
         impl->play();
         auto reply = dbus::Message::make_method_return(msg);
         bus->send(reply);
@@ -101,6 +109,7 @@ struct media::PlayerSkeleton::Private
 
     void handle_play_pause(const core::dbus::Message::Ptr& msg)
     {
+        MH_TRACE_SCOPE("dbus", "Player.PlayPause");
         switch(impl->playback_status().get())
         {
         case core::ubuntu::media::Player::PlaybackStatus::ready:
@@ -120,6 +129,7 @@ struct media::PlayerSkeleton::Private
 
     void handle_seek(const core::dbus::Message::Ptr& in)
     {
+        MH_TRACE_SCOPE("dbus", "Player.Seek");
         uint64_t ticks;
         in->reader() >> ticks;
         impl->seek_to(std::chrono::microseconds(ticks));
@@ -128,12 +138,22 @@ struct media::PlayerSkeleton::Private
         bus->send(reply);
     }
 
-    void handle_set_position(const core::dbus::Message::Ptr&)
+    void handle_set_position(const core::dbus::Message::Ptr& in)
     {
+        MH_TRACE_SCOPE("dbus", "Player.SetPosition");
+        // The track id is ignored, we only ever have one track playing
+        dbus::types::ObjectPath track;
+        int64_t position;
+        in->reader() >> track >> position;
+        impl->seek_to(std::chrono::microseconds(position));
+
+        auto reply = dbus::Message::make_method_return(in);
+        bus->send(reply);
     }
 
     void handle_create_video_sink(const core::dbus::Message::Ptr& in)
     {
+        MH_TRACE_SCOPE("dbus", "Player.CreateVideoSink");
         uint32_t texture_id;
         in->reader() >> texture_id;
         impl->create_video_sink(texture_id);
@@ -146,45 +166,45 @@ struct media::PlayerSkeleton::Private
     {
         if (context.empty() || uri.empty())
         {
-            std::cout << "Client denied access since context or uri are empty" << std::endl;
+            MH_INFO("Client denied access since context or uri are empty");
             return false;
         }
 
         if (context == "unconfined")
         {
-            std::cout << "Client allowed access since it's unconfined" << std::endl;
+            MH_DEBUG("Client allowed access since it's unconfined");
             return true;
         }
 
         size_t pos = context.find_first_of('_');
         if (pos == std::string::npos)
         {
-            std::cout << "Client denied access since it's an invalid apparmor security context" << std::endl;
+            MH_INFO("Client denied access since it's an invalid apparmor security context");
             return false;
         }
 
         const std::string pkgname = context.substr(0, pos);
-        std::cout << "client pkgname: " << pkgname << std::endl;
-        std::cout << "uri: " << uri << std::endl;
+        MH_DEBUG("client pkgname: " << pkgname);
+        MH_DEBUG("uri: " << uri);
 
         // All confined apps can access their own files
         if (uri.find(std::string(".local/share/" + pkgname + "/")) != std::string::npos
                 || uri.find(std::string(".cache/" + pkgname + "/")) != std::string::npos)
         {
-            std::cout << "Client can access content in ~/.local/share/" << pkgname << " or ~/.cache/" << pkgname << std::endl;
+            MH_DEBUG("Client can access content in ~/.local/share/" << pkgname << " or ~/.cache/" << pkgname);
             return true;
         }
         else if (uri.find(std::string("opt/click.ubuntu.com/")) != std::string::npos
                 && uri.find(pkgname) != std::string::npos)
         {
-            std::cout << "Client can access content in own opt directory" << std::endl;
+            MH_DEBUG("Client can access content in own opt directory");
             return true;
         }
         else if ((uri.find(std::string("/system/media/audio/ui/")) != std::string::npos
                 || uri.find(std::string("/android/system/media/audio/ui/")) != std::string::npos)
                 && pkgname == "com.ubuntu.camera")
         {
-            std::cout << "Camera app can access ui sounds" << std::endl;
+            MH_DEBUG("Camera app can access ui sounds");
             return true;
         }
         // TODO: Check if the trust store previously allowed direct access to uri
@@ -197,29 +217,30 @@ struct media::PlayerSkeleton::Private
                 || uri.find(std::string("Videos/")) != std::string::npos
                 || uri.find(std::string("/media")) != std::string::npos))
         {
-            std::cout << "Client can access content in ~/Music or ~/Videos" << std::endl;
+            MH_DEBUG("Client can access content in ~/Music or ~/Videos");
             return true;
         }
         else if (uri.find(std::string("/usr/share/sounds")) != std::string::npos)
         {
-            std::cout << "Client can access content in /usr/share/sounds" << std::endl;
+            MH_DEBUG("Client can access content in /usr/share/sounds");
             return true;
         }
         else if (uri.find(std::string("http://")) != std::string::npos
                 || uri.find(std::string("rtsp://")) != std::string::npos)
         {
-            std::cout << "Client can access streaming content" << std::endl;
+            MH_DEBUG("Client can access streaming content");
             return true;
         }
         else
         {
-            std::cout << "Client denied access to open_uri()" << std::endl;
+            MH_INFO("Client denied access to open_uri()");
             return false;
         }
     }
 
     void handle_key(const core::dbus::Message::Ptr& in)
     {
+        MH_TRACE_SCOPE("dbus", "Player.Key");
         auto reply = dbus::Message::make_method_return(in);
         reply->writer() << impl->key();
         bus->send(reply);
@@ -227,8 +248,14 @@ struct media::PlayerSkeleton::Private
 
     void handle_open_uri(const core::dbus::Message::Ptr& in)
     {
-        dbus_stub.get_connection_app_armor_security_async(in->sender(), [this, in](const std::string& profile)
+        MH_TRACE_SCOPE("dbus", "Player.OpenUri");
+        const auto received = std::chrono::steady_clock::now();
+        dbus_stub.get_connection_app_armor_security_async(in->sender(), [this, in, received](const std::string& profile)
         {
+            // Covers the access check, the reply is sent from here
+            static auto& latency = metrics::histogram("dbus.Player.OpenUri_us");
+            metrics::ScopedTimer timer{latency, received};
+            MH_TRACE_SCOPE("dbus", "Player.OpenUri.access_checked");
             Track::UriType uri;
             in->reader() >> uri;
 
@@ -243,8 +270,13 @@ struct media::PlayerSkeleton::Private
 
     void handle_open_uri_extended(const core::dbus::Message::Ptr& in)
     {
-        dbus_stub.get_connection_app_armor_security_async(in->sender(), [this, in](const std::string& profile)
+        MH_TRACE_SCOPE("dbus", "Player.OpenUriExtended");
+        const auto received = std::chrono::steady_clock::now();
+        dbus_stub.get_connection_app_armor_security_async(in->sender(), [this, in, received](const std::string& profile)
         {
+            static auto& latency = metrics::histogram("dbus.Player.OpenUriExtended_us");
+            metrics::ScopedTimer timer{latency, received};
+            MH_TRACE_SCOPE("dbus", "Player.OpenUriExtended.access_checked");
             Track::UriType uri;
             Player::HeadersType headers;
 
@@ -343,42 +375,44 @@ media::PlayerSkeleton::PlayerSkeleton(const media::PlayerSkeleton::Configuration
 {
     // Setup method handlers for mpris::Player methods.
     auto next = std::bind(&Private::handle_next, d, std::placeholders::_1);
-    d->object->install_method_handler<mpris::Player::Next>(next);
+    d->object->install_method_handler<mpris::Player::Next>(metrics::timed("dbus.Player.Next_us", next));
 
     auto previous = std::bind(&Private::handle_previous, d, std::placeholders::_1);
-    d->object->install_method_handler<mpris::Player::Previous>(previous);
+    d->object->install_method_handler<mpris::Player::Previous>(metrics::timed("dbus.Player.Previous_us", previous));
 
     auto pause = std::bind(&Private::handle_pause, d, std::placeholders::_1);
-    d->object->install_method_handler<mpris::Player::Pause>(pause);
+    d->object->install_method_handler<mpris::Player::Pause>(metrics::timed("dbus.Player.Pause_us", pause));
 
     auto stop = std::bind(&Private::handle_stop, d, std::placeholders::_1);
-    d->object->install_method_handler<mpris::Player::Stop>(stop);
+    d->object->install_method_handler<mpris::Player::Stop>(metrics::timed("dbus.Player.Stop_us", stop));
 
     auto play = std::bind(&Private::handle_play, d, std::placeholders::_1);
-    d->object->install_method_handler<mpris::Player::Play>(play);
+    d->object->install_method_handler<mpris::Player::Play>(metrics::timed("dbus.Player.Play_us", play));
 
     auto play_pause = std::bind(&Private::handle_play_pause, d, std::placeholders::_1);
-    d->object->install_method_handler<mpris::Player::PlayPause>(play_pause);
+    d->object->install_method_handler<mpris::Player::PlayPause>(metrics::timed("dbus.Player.PlayPause_us", play_pause));
 
     auto seek = std::bind(&Private::handle_seek, d, std::placeholders::_1);
-    d->object->install_method_handler<mpris::Player::Seek>(seek);
+    d->object->install_method_handler<mpris::Player::Seek>(metrics::timed("dbus.Player.Seek_us", seek));
 
     auto set_position = std::bind(&Private::handle_set_position, d, std::placeholders::_1);
-    d->object->install_method_handler<mpris::Player::SetPosition>(set_position);
+    d->object->install_method_handler<mpris::Player::SetPosition>(metrics::timed("dbus.Player.SetPosition_us", set_position));
 
     auto open_uri = std::bind(&Private::handle_open_uri, d, std::placeholders::_1);
     d->object->install_method_handler<mpris::Player::OpenUri>(open_uri);
 
     // All the method handlers that exceed the mpris spec go here.
     d->object->install_method_handler<mpris::Player::CreateVideoSink>(
-        std::bind(&Private::handle_create_video_sink,
-                  d,
-                  std::placeholders::_1));
+        metrics::timed("dbus.Player.CreateVideoSink_us",
+                       std::bind(&Private::handle_create_video_sink,
+                                 d,
+                                 std::placeholders::_1)));
 
     d->object->install_method_handler<mpris::Player::Key>(
-        std::bind(&Private::handle_key,
-                  d,
-                  std::placeholders::_1));
+        metrics::timed("dbus.Player.Key_us",
+                       std::bind(&Private::handle_key,
+                                 d,
+                                 std::placeholders::_1)));
 
     d->object->install_method_handler<mpris::Player::OpenUriExtended>(
         std::bind(&Private::handle_open_uri_extended,
@@ -21,8 +21,10 @@
 #include <core/media/track_list.h>
 
 #include "codec.h"
+#include "logger.h"
 #include "player_stub.h"
 #include "player_traits.h"
+#include "property_cache.h"
 #include "property_stub.h"
 #include "the_session_bus.h"
 #include "track_list_stub.h"
@@ -30,13 +32,24 @@
 #include "mpris/player.h"
 
 #include <core/dbus/property.h>
+#include <core/dbus/interfaces/properties.h>
 #include <core/dbus/types/object_path.h>
+#include <core/dbus/types/variant.h>
 
 // Hybris
 #include <hybris/media/media_codec_layer.h>
 #include <hybris/media/surface_texture_client_hybris.h>
 
+#include <cstdlib>
+#include <deque>
+#include <future>
 #include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #define UNUSED __attribute__((unused))
 
@@ -55,6 +68,7 @@ struct media::PlayerStub::Private
                 frame_available_cb(nullptr),
                 frame_available_context(nullptr),
                 object(object),
+                pipeline(std::make_shared<Pipeline>()),
                 properties
                 {
                     // Link the properties from the server side to the client side over the bus
@@ -91,6 +105,15 @@ struct media::PlayerStub::Private
     {
         auto op = object->invoke_method_synchronously<mpris::Player::Key, media::Player::PlayerKey>();
         decoding_session = decoding_service_create_session(op.value());
+
+        static const bool use_property_cache = []()
+        {
+            const char* value = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_CLIENT_PROPERTY_CACHE");
+            return value != nullptr && std::string{value} == "1";
+        }();
+
+        if (use_property_cache)
+            cache.reset(new Cache(*this));
     }
 
     ~Private()
@@ -104,7 +127,7 @@ struct media::PlayerStub::Private
             p->on_frame_available();
         }
         else
-            std::cerr << "context is nullptr, can't call on_frame_available()" << std::endl;
+            MH_WARNING("context is nullptr, can't call on_frame_available()");
     }
 
     void on_frame_available()
@@ -113,7 +136,7 @@ struct media::PlayerStub::Private
             frame_available_cb(frame_available_context);
         }
         else
-            std::cerr << "frame_available_cb is nullptr, can't call frame_available_cb()" << std::endl;
+            MH_WARNING("frame_available_cb is nullptr, can't call frame_available_cb()");
     }
 
     void set_frame_available_cb(FrameAvailableCb cb, void *context)
@@ -133,6 +156,281 @@ struct media::PlayerStub::Private
 
     }
 
+    // Sends method calls without waiting for the replies to earlier ones. The
+    // service completes OpenUri asynchronously, after its access check, so a
+    // call sent right behind it could overtake it. Calls issued while such a
+    // barrier is outstanding are held back until it replied.
+    struct Pipeline
+    {
+        struct Call
+        {
+            std::function<void()> send;
+            bool barrier;
+        };
+
+        Pipeline() : blocked(false), draining(false)
+        {
+        }
+
+        void submit(const Call& call)
+        {
+            {
+                std::lock_guard<std::mutex> lg(guard);
+                if (blocked || draining)
+                {
+                    queued.push_back(call);
+                    return;
+                }
+                blocked = call.barrier;
+            }
+            call.send();
+        }
+
+        // Invoked once the reply to a barrier arrived
+        void release()
+        {
+            std::unique_lock<std::mutex> lk(guard);
+            blocked = false;
+            draining = true;
+            while (!queued.empty() && !blocked)
+            {
+                auto call = queued.front();
+                queued.pop_front();
+                blocked = call.barrier;
+
+                lk.unlock();
+                call.send();
+                lk.lock();
+            }
+            draining = false;
+        }
+
+        std::mutex guard;
+        std::deque<Call> queued;
+        bool blocked;
+        bool draining;
+    };
+
+    template<typename T>
+    static void fulfill(std::promise<T>& promise, const core::dbus::Result<T>& result)
+    {
+        promise.set_value(result.value());
+    }
+
+    static void fulfill(std::promise<void>& promise, const core::dbus::Result<void>&)
+    {
+        promise.set_value();
+    }
+
+    // Sends Method through the pipeline, the future reports the reply or a
+    // runtime_error starting with what.
+    template<typename Method, typename ResultType, typename... Args>
+    std::future<ResultType> invoke(bool barrier, const std::string& what, const Args&... args)
+    {
+        auto promise = std::make_shared<std::promise<ResultType>>();
+        auto future = promise->get_future();
+
+        auto object = this->object;
+        auto pipeline = this->pipeline;
+        pipeline->submit(Pipeline::Call
+        {
+            [object, pipeline, promise, barrier, what, args...]()
+            {
+                object->invoke_method_asynchronously_with_callback<Method, ResultType>(
+                            [pipeline, promise, barrier, what](const core::dbus::Result<ResultType>& result)
+                            {
+                                if (result.is_error())
+                                    promise->set_exception(std::make_exception_ptr(
+                                            std::runtime_error(what + ": " + result.error().print())));
+                                else
+                                    fulfill(*promise, result);
+
+                                if (barrier)
+                                    pipeline->release();
+                            }, args...);
+            },
+            barrier
+        });
+
+        return future;
+    }
+
+    // Opt-in client side cache of the remote properties, enabled with
+    // CORE_UBUNTU_MEDIA_SERVICE_CLIENT_PROPERTY_CACHE=1. Without it, every
+    // read of a property is a synchronous Get on the bus.
+    struct Cache
+    {
+        typedef std::chrono::steady_clock::duration Age;
+        typedef std::map<std::string, core::dbus::types::Variant> Dictionary;
+
+        // How long a value is served before it is fetched again. Properties
+        // the service announces changes for can be kept around longer.
+        struct Policy
+        {
+            static Age capabilities() { return std::chrono::seconds{1}; }
+            static Age source_type() { return std::chrono::seconds{1}; }
+            static Age settings() { return std::chrono::seconds{5}; }
+            static Age playback_status() { return std::chrono::seconds{5}; }
+            static Age meta_data() { return std::chrono::seconds{1}; }
+            static Age position() { return std::chrono::seconds{1}; }
+            static Age duration() { return std::chrono::seconds{1}; }
+            static Age rate_limits() { return std::chrono::seconds{30}; }
+        };
+
+        template<typename P>
+        static std::function<typename P::element_type::ValueType()> fetch(const P& remote)
+        {
+            return [remote]() { return remote->get(); };
+        }
+
+        // Keeps the cache in sync with local writes and values received via the bus
+        template<typename P, typename C>
+        static core::Connection follow(const P& remote, C& cached)
+        {
+            return remote->changed().connect([&cached](const typename P::element_type::ValueType& value)
+            {
+                cached.update(value);
+            });
+        }
+
+        Cache(Private& p)
+            : can_play{fetch(p.properties.can_play), Policy::capabilities()},
+              can_pause{fetch(p.properties.can_pause), Policy::capabilities()},
+              can_seek{fetch(p.properties.can_seek), Policy::capabilities()},
+              can_go_next{fetch(p.properties.can_go_next), Policy::capabilities()},
+              can_go_previous{fetch(p.properties.can_go_previous), Policy::capabilities()},
+              is_video_source{fetch(p.properties.is_video_source), Policy::source_type()},
+              is_audio_source{fetch(p.properties.is_audio_source), Policy::source_type()},
+              playback_status{fetch(p.properties.playback_status), Policy::playback_status()},
+              loop_status{fetch(p.properties.loop_status), Policy::settings()},
+              playback_rate{fetch(p.properties.playback_rate), Policy::settings()},
+              is_shuffle{fetch(p.properties.is_shuffle), Policy::settings()},
+              meta_data_for_current_track{fetch(p.properties.meta_data_for_current_track), Policy::meta_data()},
+              volume{fetch(p.properties.volume), Policy::settings()},
+              duration{fetch(p.properties.duration), Policy::duration()},
+              audio_role{fetch(p.properties.audio_role), Policy::settings()},
+              orientation{fetch(p.properties.orientation), Policy::settings()},
+              lifetime{fetch(p.properties.lifetime), Policy::settings()},
+              minimum_playback_rate{fetch(p.properties.minimum_playback_rate), Policy::rate_limits()},
+              maximum_playback_rate{fetch(p.properties.maximum_playback_rate), Policy::rate_limits()},
+              position
+              {
+                  InterpolatedPosition::Configuration
+                  {
+                      fetch(p.properties.position),
+                      [this]() { return playback_status.get() == media::Player::PlaybackStatus::playing; },
+                      [this]() { return playback_rate.get(); },
+                      [this]() { return duration.get(); },
+                      Policy::position()
+                  }
+              },
+              properties_changed(p.object->get_signal<core::dbus::interfaces::Properties::Signals::PropertiesChanged>())
+        {
+            // Values announced via PropertiesChanged or written locally
+            connections.emplace_back(follow(p.properties.can_play, can_play));
+            connections.emplace_back(follow(p.properties.can_pause, can_pause));
+            connections.emplace_back(follow(p.properties.can_seek, can_seek));
+            connections.emplace_back(follow(p.properties.can_go_next, can_go_next));
+            connections.emplace_back(follow(p.properties.can_go_previous, can_go_previous));
+            connections.emplace_back(follow(p.properties.is_video_source, is_video_source));
+            connections.emplace_back(follow(p.properties.is_audio_source, is_audio_source));
+            connections.emplace_back(follow(p.properties.playback_status, playback_status));
+            connections.emplace_back(follow(p.properties.loop_status, loop_status));
+            connections.emplace_back(follow(p.properties.playback_rate, playback_rate));
+            connections.emplace_back(follow(p.properties.is_shuffle, is_shuffle));
+            connections.emplace_back(follow(p.properties.meta_data_for_current_track, meta_data_for_current_track));
+            connections.emplace_back(follow(p.properties.volume, volume));
+            connections.emplace_back(follow(p.properties.duration, duration));
+            connections.emplace_back(follow(p.properties.audio_role, audio_role));
+            connections.emplace_back(follow(p.properties.orientation, orientation));
+            connections.emplace_back(follow(p.properties.lifetime, lifetime));
+            connections.emplace_back(follow(p.properties.minimum_playback_rate, minimum_playback_rate));
+            connections.emplace_back(follow(p.properties.maximum_playback_rate, maximum_playback_rate));
+            connections.emplace_back(follow(p.properties.position, position));
+
+            connections.emplace_back(p.signals.playback_status_changed.connect([this](const media::Player::PlaybackStatus& status)
+            {
+                playback_status.update(status);
+                // Interpolation starts or stops from wherever we actually are
+                position.invalidate();
+            }));
+
+            connections.emplace_back(p.signals.seeked_to.connect([this](int64_t us)
+            {
+                position.update(us * 1000);
+            }));
+
+            properties_changed->connect([this](const core::dbus::interfaces::Properties::Signals::PropertiesChanged::ArgumentType& args)
+            {
+                for (const auto& pair : std::get<1>(args))
+                    on_property_changed(pair.first, &pair.second);
+                for (const auto& name : std::get<2>(args))
+                    on_property_changed(name, nullptr);
+            });
+        }
+
+        // Takes over announced values, unknown or invalidated ones are refetched
+        // on next read, which notifies subscribers if the value changed. Fetching
+        // right away is not an option, we are on the bus thread.
+        void on_property_changed(const std::string& name, const core::dbus::types::Variant* value)
+        {
+            if (name == mpris::Player::Properties::Position::name())
+            {
+                if (value)
+                    position.update(value->as<mpris::Player::Properties::Position::ValueType>());
+                else
+                    position.invalidate();
+            } else if (name == mpris::Player::Properties::Duration::name())
+            {
+                if (value)
+                    duration.update(value->as<mpris::Player::Properties::Duration::ValueType>());
+                else
+                    duration.invalidate();
+            } else if (name == mpris::Player::Properties::PlaybackStatus::name())
+            {
+                playback_status.invalidate();
+                position.invalidate();
+            } else if (name == mpris::Player::Properties::LoopStatus::name())
+            {
+                loop_status.invalidate();
+            } else if (name == mpris::Player::Properties::Orientation::name())
+            {
+                orientation.invalidate();
+            } else if (name == mpris::Player::Properties::Metadata::name())
+            {
+                meta_data_for_current_track.invalidate();
+            }
+        }
+
+        CachedProperty<bool> can_play;
+        CachedProperty<bool> can_pause;
+        CachedProperty<bool> can_seek;
+        CachedProperty<bool> can_go_next;
+        CachedProperty<bool> can_go_previous;
+        CachedProperty<bool> is_video_source;
+        CachedProperty<bool> is_audio_source;
+        CachedProperty<media::Player::PlaybackStatus> playback_status;
+        CachedProperty<media::Player::LoopStatus> loop_status;
+        CachedProperty<media::Player::PlaybackRate> playback_rate;
+        CachedProperty<bool> is_shuffle;
+        CachedProperty<media::Track::MetaData> meta_data_for_current_track;
+        CachedProperty<media::Player::Volume> volume;
+        CachedProperty<int64_t> duration;
+        CachedProperty<media::Player::AudioStreamRole> audio_role;
+        CachedProperty<media::Player::Orientation> orientation;
+        CachedProperty<media::Player::Lifetime> lifetime;
+        CachedProperty<media::Player::PlaybackRate> minimum_playback_rate;
+        CachedProperty<media::Player::PlaybackRate> maximum_playback_rate;
+        InterpolatedPosition position;
+
+        core::dbus::Signal
+        <
+            core::dbus::interfaces::Properties::Signals::PropertiesChanged,
+            core::dbus::interfaces::Properties::Signals::PropertiesChanged::ArgumentType
+        >::Ptr properties_changed;
+        std::vector<core::ScopedConnection> connections;
+    };
+
     std::shared_ptr<Service> parent;
     std::shared_ptr<TrackList> track_list;
 
@@ -146,6 +444,7 @@ struct media::PlayerStub::Private
     void *frame_available_context;
 
     dbus::Object::Ptr object;
+    std::shared_ptr<Pipeline> pipeline;
 
     struct
     {
@@ -204,13 +503,13 @@ struct media::PlayerStub::Private
         {
             dbus.seeked_to->connect([this](std::uint64_t value)
             {
-                std::cout << "seeked_to signal arrived via the bus." << std::endl;
+                MH_TRACE("seeked_to signal arrived via the bus.");
                 seeked_to(value);
             });
 
             dbus.end_of_stream->connect([this]()
             {
-                std::cout << "EndOfStream signal arrived via the bus." << std::endl;
+                MH_TRACE("EndOfStream signal arrived via the bus.");
                 if (playback_complete_cb)
                     playback_complete_cb(playback_complete_context);
                 end_of_stream();
@@ -218,19 +517,19 @@ struct media::PlayerStub::Private
 
             dbus.playback_status_changed->connect([this](const media::Player::PlaybackStatus& status)
             {
-                std::cout << "PlaybackStatusChanged signal arrived via the bus." << std::endl;
+                MH_TRACE("PlaybackStatusChanged signal arrived via the bus.");
                 playback_status_changed(status);
             });
 
             dbus.video_dimension_changed->connect([this](uint64_t mask)
             {
-                std::cout << "VideoDimensionChanged signal arrived via the bus." << std::endl;
+                MH_TRACE("VideoDimensionChanged signal arrived via the bus.");
                 video_dimension_changed(mask);
             });
 
             dbus.error->connect([this](const media::Player::Error& e)
             {
-                std::cout << "Error signal arrived via the bus (Error: " << e << ")" << std::endl;
+                MH_TRACE("Error signal arrived via the bus (Error: " << e << ")");
                 error(e);
             });
         }
@@ -258,6 +557,8 @@ struct media::PlayerStub::Private
             std::shared_ptr<DBusErrorSignal> error;
         } dbus;
     } signals;
+
+    std::unique_ptr<Cache> cache;
 };
 
 media::PlayerStub::PlayerStub(
@@ -289,6 +590,9 @@ media::Player::PlayerKey media::PlayerStub::key() const
     return op.value();
 }
 
+// The synchronous calls block on the reply in place. Waiting on a future
+// instead would deadlock when called from a signal handler, as the reply is
+// delivered by the very thread running the handler.
 bool media::PlayerStub::open_uri(const media::Track::UriType& uri)
 {
     auto op = d->object->invoke_method_synchronously<mpris::Player::OpenUri, bool>(uri);
@@ -366,6 +670,46 @@ void media::PlayerStub::stop()
         throw std::runtime_error("Problem stopping playback on remote object");
 }
 
+std::future<bool> media::PlayerStub::open_uri_async(const media::Track::UriType& uri)
+{
+    return d->invoke<mpris::Player::OpenUri, bool>(true, "Problem opening uri on remote object", uri);
+}
+
+std::future<bool> media::PlayerStub::open_uri_async(const Track::UriType& uri, const Player::HeadersType& headers)
+{
+    return d->invoke<mpris::Player::OpenUriExtended, bool>(true, "Problem opening uri on remote object", uri, headers);
+}
+
+std::future<void> media::PlayerStub::next_async()
+{
+    return d->invoke<mpris::Player::Next, void>(false, "Problem switching to next track on remote object");
+}
+
+std::future<void> media::PlayerStub::previous_async()
+{
+    return d->invoke<mpris::Player::Previous, void>(false, "Problem switching to previous track on remote object");
+}
+
+std::future<void> media::PlayerStub::play_async()
+{
+    return d->invoke<mpris::Player::Play, void>(false, "Problem starting playback on remote object");
+}
+
+std::future<void> media::PlayerStub::pause_async()
+{
+    return d->invoke<mpris::Player::Pause, void>(false, "Problem pausing playback on remote object");
+}
+
+std::future<void> media::PlayerStub::seek_to_async(const std::chrono::microseconds& offset)
+{
+    return d->invoke<mpris::Player::Seek, void>(false, "Problem seeking on remote object", static_cast<uint64_t>(offset.count()));
+}
+
+std::future<void> media::PlayerStub::stop_async()
+{
+    return d->invoke<mpris::Player::Stop, void>(false, "Problem stopping playback on remote object");
+}
+
 void media::PlayerStub::set_frame_available_callback(FrameAvailableCb cb, void *context)
 {
     d->set_frame_available_cb(cb, context);
@@ -378,101 +722,161 @@ void media::PlayerStub::set_playback_complete_callback(PlaybackCompleteCb cb, vo
 
 const core::Property<bool>& media::PlayerStub::can_play() const
 {
+    if (d->cache)
+        return d->cache->can_play.local();
+
     return *d->properties.can_play;
 }
 
 const core::Property<bool>& media::PlayerStub::can_pause() const
 {
+    if (d->cache)
+        return d->cache->can_pause.local();
+
     return *d->properties.can_pause;
 }
 
 const core::Property<bool>& media::PlayerStub::can_seek() const
 {
+    if (d->cache)
+        return d->cache->can_seek.local();
+
     return *d->properties.can_seek;
 }
 
 const core::Property<bool>& media::PlayerStub::can_go_previous() const
 {
+    if (d->cache)
+        return d->cache->can_go_previous.local();
+
     return *d->properties.can_go_previous;
 }
 
 const core::Property<bool>& media::PlayerStub::can_go_next() const
 {
+    if (d->cache)
+        return d->cache->can_go_next.local();
+
     return *d->properties.can_go_next;
 }
 
 const core::Property<bool>& media::PlayerStub::is_video_source() const
 {
+    if (d->cache)
+        return d->cache->is_video_source.local();
+
     return *d->properties.is_video_source;
 }
 
 const core::Property<bool>& media::PlayerStub::is_audio_source() const
 {
+    if (d->cache)
+        return d->cache->is_audio_source.local();
+
     return *d->properties.is_audio_source;
 }
 
 const core::Property<media::Player::PlaybackStatus>& media::PlayerStub::playback_status() const
 {
+    if (d->cache)
+        return d->cache->playback_status.local();
+
     return *d->properties.playback_status;
 }
 
 const core::Property<media::Player::LoopStatus>& media::PlayerStub::loop_status() const
 {
+    if (d->cache)
+        return d->cache->loop_status.local();
+
     return *d->properties.loop_status;
 }
 
 const core::Property<media::Player::PlaybackRate>& media::PlayerStub::playback_rate() const
 {
+    if (d->cache)
+        return d->cache->playback_rate.local();
+
     return *d->properties.playback_rate;
 }
 
 const core::Property<bool>& media::PlayerStub::is_shuffle() const
 {
+    if (d->cache)
+        return d->cache->is_shuffle.local();
+
     return *d->properties.is_shuffle;
 }
 
 const core::Property<media::Track::MetaData>& media::PlayerStub::meta_data_for_current_track() const
 {
+    if (d->cache)
+        return d->cache->meta_data_for_current_track.local();
+
     return *d->properties.meta_data_for_current_track;
 }
 
 const core::Property<media::Player::Volume>& media::PlayerStub::volume() const
 {
+    if (d->cache)
+        return d->cache->volume.local();
+
     return *d->properties.volume;
 }
 
 const core::Property<int64_t>& media::PlayerStub::position() const
 {
+    if (d->cache)
+        return d->cache->position.local();
+
     return *d->properties.position;
 }
 
 const core::Property<int64_t>& media::PlayerStub::duration() const
 {
+    if (d->cache)
+        return d->cache->duration.local();
+
     return *d->properties.duration;
 }
 
 const core::Property<media::Player::AudioStreamRole>& media::PlayerStub::audio_stream_role() const
 {
+    if (d->cache)
+        return d->cache->audio_role.local();
+
     return *d->properties.audio_role;
 }
 
 const core::Property<media::Player::Orientation>& media::PlayerStub::orientation() const
 {
+    if (d->cache)
+        return d->cache->orientation.local();
+
     return *d->properties.orientation;
 }
 
 const core::Property<media::Player::Lifetime>& media::PlayerStub::lifetime() const
 {
+    if (d->cache)
+        return d->cache->lifetime.local();
+
     return *d->properties.lifetime;
 }
 
 const core::Property<media::Player::PlaybackRate>& media::PlayerStub::minimum_playback_rate() const
 {
+    if (d->cache)
+        return d->cache->minimum_playback_rate.local();
+
     return *d->properties.minimum_playback_rate;
 }
 
 const core::Property<media::Player::PlaybackRate>& media::PlayerStub::maximum_playback_rate() const
 {
+    if (d->cache)
+        return d->cache->maximum_playback_rate.local();
+
     return *d->properties.maximum_playback_rate;
 }
 
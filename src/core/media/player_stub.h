@@ -57,6 +57,15 @@ class PlayerStub : public Player
     virtual void seek_to(const std::chrono::microseconds& offset);
     virtual void stop();
 
+    virtual std::future<bool> open_uri_async(const Track::UriType& uri);
+    virtual std::future<bool> open_uri_async(const Track::UriType& uri, const Player::HeadersType& headers);
+    virtual std::future<void> next_async();
+    virtual std::future<void> previous_async();
+    virtual std::future<void> play_async();
+    virtual std::future<void> pause_async();
+    virtual std::future<void> stop_async();
+    virtual std::future<void> seek_to_async(const std::chrono::microseconds& offset);
+
     virtual void set_frame_available_callback(FrameAvailableCb cb, void *context);
     virtual void set_playback_complete_callback(PlaybackCompleteCb cb, void *context);
 
@@ -0,0 +1,422 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "playlist_store.h"
+
+#include "logger.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace media = core::ubuntu::media;
+
+namespace
+{
+// "MHPL" followed by the format version
+constexpr std::uint32_t magic{0x4d48504c};
+constexpr std::uint32_t version{1};
+
+std::int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+template<typename T>
+void write(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void write(std::ostream& out, const std::string& value)
+{
+    write(out, static_cast<std::uint32_t>(value.size()));
+    out.write(value.data(), value.size());
+}
+
+template<typename T>
+void read(std::istream& in, T& value)
+{
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(value)))
+        throw std::runtime_error("Truncated playlist index");
+}
+
+void read(std::istream& in, std::string& value)
+{
+    std::uint32_t size; read(in, size);
+    value.resize(size);
+    if (!in.read(&value[0], size))
+        throw std::runtime_error("Truncated playlist index");
+}
+
+// Entries sorted by (key, id), ties between equal keys are broken by id
+template<typename Key>
+class Index
+{
+public:
+    typedef std::pair<Key, media::PlaylistStore::Id> Entry;
+
+    void insert(const Key& key, media::PlaylistStore::Id id)
+    {
+        Entry entry{key, id};
+        entries.insert(std::lower_bound(entries.begin(), entries.end(), entry), entry);
+    }
+
+    void erase(const Key& key, media::PlaylistStore::Id id)
+    {
+        Entry entry{key, id};
+        auto it = std::lower_bound(entries.begin(), entries.end(), entry);
+        if (it != entries.end() && *it == entry)
+            entries.erase(it);
+    }
+
+    media::PlaylistStore::Id at(std::size_t i, bool reverse) const
+    {
+        return reverse ? entries[entries.size() - 1 - i].second : entries[i].second;
+    }
+
+private:
+    std::vector<Entry> entries;
+};
+
+std::string folded(std::string name)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    return name;
+}
+}
+
+struct media::PlaylistStore::Private
+{
+    explicit Private(const std::string& directory) : directory(directory), next_id(1)
+    {
+    }
+
+    boost::filesystem::path index_path() const
+    {
+        return boost::filesystem::path{directory} / "playlists";
+    }
+
+    boost::filesystem::path tracks_path(Id id) const
+    {
+        return boost::filesystem::path{directory} / (std::to_string(id) + ".tracks");
+    }
+
+    void load()
+    {
+        std::ifstream in(index_path().string(), std::ios::binary);
+        if (!in)
+            return;
+
+        std::uint32_t m, v; read(in, m); read(in, v);
+        if (m != magic || v != version)
+            throw std::runtime_error("Unknown playlist index format");
+
+        std::uint32_t count;
+        read(in, next_id);
+        read(in, count);
+
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            Playlist p;
+            read(in, p.id);
+            read(in, p.created);
+            read(in, p.modified);
+            read(in, p.last_played);
+            read(in, p.track_count);
+            read(in, p.name);
+            read(in, p.icon);
+            add(p);
+        }
+    }
+
+    // Written next to the index and renamed over it, such that a crash never
+    // leaves a partial index behind.
+    void save() const
+    {
+        boost::filesystem::create_directories(directory);
+
+        const auto tmp = index_path().string() + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            write(out, magic);
+            write(out, version);
+            write(out, next_id);
+            write(out, static_cast<std::uint32_t>(playlists.size()));
+
+            for (const auto& pair : playlists)
+            {
+                const auto& p = pair.second;
+                write(out, p.id);
+                write(out, p.created);
+                write(out, p.modified);
+                write(out, p.last_played);
+                write(out, p.track_count);
+                write(out, p.name);
+                write(out, p.icon);
+            }
+
+            if (!out.flush())
+                throw std::runtime_error("Problem writing playlist index");
+        }
+
+        boost::filesystem::rename(tmp, index_path());
+    }
+
+    // One uri per line, uris never contain a raw newline
+    void save_tracks(Id id, const std::vector<Track::UriType>& tracks) const
+    {
+        boost::filesystem::create_directories(directory);
+
+        const auto tmp = tracks_path(id).string() + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::trunc);
+            for (const auto& uri : tracks)
+                out << uri << '\n';
+
+            if (!out.flush())
+                throw std::runtime_error("Problem writing playlist tracks");
+        }
+
+        boost::filesystem::rename(tmp, tracks_path(id));
+    }
+
+    void add(const Playlist& p)
+    {
+        playlists[p.id] = p;
+        alphabetical.insert(folded(p.name), p.id);
+        creation_date.insert(p.created, p.id);
+        modified_date.insert(p.modified, p.id);
+        last_play_date.insert(p.last_played, p.id);
+    }
+
+    void erase(const Playlist& p)
+    {
+        alphabetical.erase(folded(p.name), p.id);
+        creation_date.erase(p.created, p.id);
+        modified_date.erase(p.modified, p.id);
+        last_play_date.erase(p.last_played, p.id);
+        playlists.erase(p.id);
+    }
+
+    // Applies f to a copy of the playlist and reindexes it
+    template<typename F>
+    bool update(Id id, F f)
+    {
+        auto it = playlists.find(id);
+        if (it == playlists.end())
+            return false;
+
+        Playlist p = it->second;
+        erase(p);
+        f(p);
+        add(p);
+        save();
+        return true;
+    }
+
+    const std::string directory;
+
+    mutable std::mutex guard;
+    Id next_id;
+    std::unordered_map<Id, Playlist> playlists;
+
+    Index<std::string> alphabetical;
+    Index<std::int64_t> creation_date;
+    Index<std::int64_t> modified_date;
+    Index<std::int64_t> last_play_date;
+};
+
+std::string media::PlaylistStore::default_directory()
+{
+    if (auto dir = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_PLAYLIST_DIR"))
+        return dir;
+
+    if (auto xdg = ::getenv("XDG_DATA_HOME"))
+        return std::string{xdg} + "/media-hub/playlists";
+
+    auto home = ::getenv("HOME");
+    return std::string{home ? home : "/tmp"} + "/.local/share/media-hub/playlists";
+}
+
+media::PlaylistStore::PlaylistStore(const std::string& directory)
+    : d(new Private(directory))
+{
+    try
+    {
+        d->load();
+    } catch (const std::exception& e)
+    {
+        MH_WARNING("Ignoring playlists in " << directory << ": " << e.what());
+        d.reset(new Private(directory));
+    }
+}
+
+media::PlaylistStore::~PlaylistStore()
+{
+}
+
+std::size_t media::PlaylistStore::count() const
+{
+    std::lock_guard<std::mutex> lg(d->guard);
+    return d->playlists.size();
+}
+
+std::vector<media::PlaylistStore::Playlist> media::PlaylistStore::playlists(
+        std::size_t index,
+        std::size_t max_count,
+        media::PlaylistStore::Ordering ordering,
+        bool reverse) const
+{
+    std::lock_guard<std::mutex> lg(d->guard);
+
+    std::vector<Playlist> result;
+    const auto size = d->playlists.size();
+    if (index >= size)
+        return result;
+
+    const auto last = index + std::min(max_count, size - index);
+    result.reserve(last - index);
+
+    for (auto i = index; i < last; i++)
+    {
+        Id id = 0;
+        switch (ordering)
+        {
+        case Ordering::alphabetical:
+            id = d->alphabetical.at(i, reverse);
+            break;
+        case Ordering::creation_date:
+            id = d->creation_date.at(i, reverse);
+            break;
+        case Ordering::modified_date:
+            id = d->modified_date.at(i, reverse);
+            break;
+        case Ordering::last_play_date:
+            id = d->last_play_date.at(i, reverse);
+            break;
+        }
+        result.push_back(d->playlists.at(id));
+    }
+
+    return result;
+}
+
+bool media::PlaylistStore::lookup(media::PlaylistStore::Id id, media::PlaylistStore::Playlist& playlist) const
+{
+    std::lock_guard<std::mutex> lg(d->guard);
+
+    auto it = d->playlists.find(id);
+    if (it == d->playlists.end())
+        return false;
+
+    playlist = it->second;
+    return true;
+}
+
+std::vector<media::Track::UriType> media::PlaylistStore::tracks(media::PlaylistStore::Id id) const
+{
+    std::vector<Track::UriType> result;
+    {
+        std::lock_guard<std::mutex> lg(d->guard);
+        if (d->playlists.count(id) == 0)
+            return result;
+    }
+
+    std::ifstream in(d->tracks_path(id).string());
+    std::string uri;
+    while (std::getline(in, uri))
+        if (not uri.empty())
+            result.push_back(uri);
+
+    return result;
+}
+
+media::PlaylistStore::Id media::PlaylistStore::create(
+        const std::string& name,
+        const std::vector<media::Track::UriType>& tracks,
+        const std::string& icon)
+{
+    std::lock_guard<std::mutex> lg(d->guard);
+
+    const auto timestamp = now();
+    Playlist p{d->next_id++, name, icon, timestamp, timestamp, 0, static_cast<std::uint32_t>(tracks.size())};
+
+    d->save_tracks(p.id, tracks);
+    d->add(p);
+    d->save();
+
+    return p.id;
+}
+
+bool media::PlaylistStore::rename(media::PlaylistStore::Id id, const std::string& name)
+{
+    std::lock_guard<std::mutex> lg(d->guard);
+    return d->update(id, [&name](Playlist& p)
+    {
+        p.name = name;
+        p.modified = now();
+    });
+}
+
+bool media::PlaylistStore::set_tracks(media::PlaylistStore::Id id, const std::vector<media::Track::UriType>& tracks)
+{
+    std::lock_guard<std::mutex> lg(d->guard);
+    if (d->playlists.count(id) == 0)
+        return false;
+
+    d->save_tracks(id, tracks);
+    return d->update(id, [&tracks](Playlist& p)
+    {
+        p.track_count = tracks.size();
+        p.modified = now();
+    });
+}
+
+bool media::PlaylistStore::mark_played(media::PlaylistStore::Id id)
+{
+    std::lock_guard<std::mutex> lg(d->guard);
+    return d->update(id, [](Playlist& p)
+    {
+        p.last_played = now();
+    });
+}
+
+bool media::PlaylistStore::remove(media::PlaylistStore::Id id)
+{
+    std::lock_guard<std::mutex> lg(d->guard);
+
+    auto it = d->playlists.find(id);
+    if (it == d->playlists.end())
+        return false;
+
+    d->erase(Playlist(it->second));
+    d->save();
+
+    boost::system::error_code ec;
+    boost::filesystem::remove(d->tracks_path(id), ec);
+    return true;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CORE_UBUNTU_MEDIA_PLAYLIST_STORE_H_
+#define CORE_UBUNTU_MEDIA_PLAYLIST_STORE_H_
+
+#include <core/media/track.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+// Persistent collection of playlists backing the MPRIS Playlists interface.
+//
+// Playlist descriptions live in a single compact binary index, the tracks of
+// every playlist in a file of their own that is only read on activation.
+// A sorted index per ordering is kept in memory, such that paging through
+// the playlists in any order costs O(k) for a page of k entries.
+class PlaylistStore
+{
+public:
+    typedef std::uint64_t Id;
+
+    enum class Ordering
+    {
+        alphabetical,
+        creation_date,
+        modified_date,
+        last_play_date
+    };
+
+    struct Playlist
+    {
+        Id id;
+        std::string name;
+        std::string icon;
+        // Seconds since the epoch, 0 if never played
+        std::int64_t created;
+        std::int64_t modified;
+        std::int64_t last_played;
+        std::uint32_t track_count;
+    };
+
+    // CORE_UBUNTU_MEDIA_SERVICE_PLAYLIST_DIR if set, otherwise
+    // $XDG_DATA_HOME/media-hub/playlists.
+    static std::string default_directory();
+
+    // Loads the store from directory, which is created on first write.
+    explicit PlaylistStore(const std::string& directory = default_directory());
+    PlaylistStore(const PlaylistStore&) = delete;
+    ~PlaylistStore();
+
+    PlaylistStore& operator=(const PlaylistStore&) = delete;
+
+    std::size_t count() const;
+
+    // Returns at most max_count playlists starting at index in the given order.
+    std::vector<Playlist> playlists(std::size_t index, std::size_t max_count, Ordering ordering, bool reverse) const;
+
+    // Returns false if there is no playlist with the given id.
+    bool lookup(Id id, Playlist& playlist) const;
+
+    // Reads the tracks of a playlist from disk, empty for unknown playlists.
+    std::vector<Track::UriType> tracks(Id id) const;
+
+    Id create(const std::string& name, const std::vector<Track::UriType>& tracks, const std::string& icon = std::string{});
+    bool rename(Id id, const std::string& name);
+    bool set_tracks(Id id, const std::vector<Track::UriType>& tracks);
+    bool mark_played(Id id);
+    bool remove(Id id);
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+}
+}
+}
+
+#endif // CORE_UBUNTU_MEDIA_PLAYLIST_STORE_H_
@@ -0,0 +1,213 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_UBUNTU_MEDIA_PROPERTY_CACHE_H_
+#define CORE_UBUNTU_MEDIA_PROPERTY_CACHE_H_
+
+#include <core/property.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+// Serves reads of a remote property from a local copy. The remote value is
+// only fetched again once the copy is older than max_age, values pushed by
+// the service through signals refresh the copy without a round trip.
+// Subscribers to local().changed() are notified whenever a pushed or
+// fetched value differs from the last one they saw.
+template<typename T>
+class CachedProperty
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<T()> Fetcher;
+
+    // Never expires, the value is only refreshed by pushed updates
+    static constexpr Clock::duration pushed_only()
+    {
+        return Clock::duration::max();
+    }
+
+    CachedProperty(const Fetcher& fetch, Clock::duration max_age)
+        : fetch(fetch),
+          max_age(max_age),
+          valid(false)
+    {
+        property.install([this]() { return get(); });
+    }
+
+    CachedProperty(const CachedProperty&) = delete;
+    CachedProperty& operator=(const CachedProperty&) = delete;
+
+    T get()
+    {
+        {
+            std::lock_guard<std::mutex> lg(guard);
+            if (valid && Clock::now() - updated_at < max_age)
+                return value;
+        }
+
+        // Updates are delivered on the bus thread, which also dispatches the
+        // reply to our fetch. Holding the lock across it could deadlock.
+        const T fetched = fetch();
+        update(fetched);
+        return fetched;
+    }
+
+    void update(const T& v)
+    {
+        {
+            std::lock_guard<std::mutex> lg(guard);
+            value = v;
+            updated_at = Clock::now();
+            valid = true;
+        }
+
+        // Outside the lock, handlers are free to read the property
+        property.set(v);
+    }
+
+    void invalidate()
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        valid = false;
+    }
+
+    // The property handed out to clients, reads go through the cache
+    const core::Property<T>& local() const
+    {
+        return property;
+    }
+
+private:
+    Fetcher fetch;
+    Clock::duration max_age;
+
+    std::mutex guard;
+    T value;
+    Clock::time_point updated_at;
+    bool valid;
+
+    core::Property<T> property;
+};
+
+// Position in nanoseconds, extrapolated from the last known position while
+// playing such that reads don't need to ask the service every frame. The
+// position is resynchronized every max_age to correct for drift.
+class InterpolatedPosition
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Configuration
+    {
+        std::function<std::int64_t()> fetch;
+        std::function<bool()> is_playing;
+        std::function<double()> rate;
+        // Upper bound for the position, 0 if unknown
+        std::function<std::int64_t()> duration;
+        Clock::duration max_age;
+    };
+
+    explicit InterpolatedPosition(const Configuration& configuration)
+        : configuration(configuration),
+          base(0),
+          valid(false)
+    {
+        property.install([this]() { return get(); });
+    }
+
+    InterpolatedPosition(const InterpolatedPosition&) = delete;
+    InterpolatedPosition& operator=(const InterpolatedPosition&) = delete;
+
+    std::int64_t get()
+    {
+        std::int64_t position = 0;
+        Clock::time_point at;
+        bool fresh = false;
+        {
+            std::lock_guard<std::mutex> lg(guard);
+            const auto now = Clock::now();
+            fresh = valid && now - base_time < configuration.max_age;
+            position = base;
+            at = base_time;
+        }
+
+        if (!fresh)
+        {
+            position = configuration.fetch();
+            update(position);
+            return position;
+        }
+
+        if (configuration.is_playing())
+        {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - at);
+            position += static_cast<std::int64_t>(elapsed.count() * configuration.rate());
+        }
+
+        const std::int64_t duration = configuration.duration();
+        return duration > 0 ? std::min(position, duration) : position;
+    }
+
+    // Position in nanoseconds as of now, e.g. after a seek landed
+    void update(std::int64_t position)
+    {
+        {
+            std::lock_guard<std::mutex> lg(guard);
+            base = position;
+            base_time = Clock::now();
+            valid = true;
+        }
+
+        property.set(position);
+    }
+
+    // Forces a resync on the next read, e.g. after playback paused
+    void invalidate()
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        valid = false;
+    }
+
+    const core::Property<std::int64_t>& local() const
+    {
+        return property;
+    }
+
+private:
+    Configuration configuration;
+
+    std::mutex guard;
+    std::int64_t base;
+    Clock::time_point base_time;
+    bool valid;
+
+    core::Property<std::int64_t> property;
+};
+}
+}
+}
+
+#endif // CORE_UBUNTU_MEDIA_PROPERTY_CACHE_H_
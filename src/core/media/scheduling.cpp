@@ -0,0 +1,332 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scheduling.h"
+
+#include "logger.h"
+#include "metrics.h"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace media = core::ubuntu::media;
+namespace scheduling = core::ubuntu::media::scheduling;
+
+namespace
+{
+const std::map<std::string, scheduling::Class>& classes()
+{
+    static const std::map<std::string, scheduling::Class> lut
+    {
+        {"alarm", scheduling::Class::alarm},
+        {"alert", scheduling::Class::alert},
+        {"multimedia", scheduling::Class::multimedia},
+        {"phone", scheduling::Class::phone},
+        {"background", scheduling::Class::background}
+    };
+    return lut;
+}
+
+std::string name_of(scheduling::Class c)
+{
+    for (const auto& pair : classes())
+        if (pair.second == c)
+            return pair.first;
+    return std::string{};
+}
+
+std::vector<std::string> split(const std::string& s, char delimiter)
+{
+    std::vector<std::string> result;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, delimiter))
+        if (not item.empty())
+            result.push_back(item);
+    return result;
+}
+
+bool to_int(const std::string& s, int& value)
+{
+    if (s.empty())
+        return false;
+
+    char* end = nullptr;
+    value = std::strtol(s.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+// "nice:<n>", "fifo:<priority>", "rr:<priority>", "idle" or "cpus:<first>[-<last>]"
+bool parse_setting(const std::string& setting, scheduling::Policy& policy)
+{
+    if (setting == "idle")
+    {
+        policy.scheduler = scheduling::Policy::Scheduler::idle;
+        return true;
+    }
+
+    const auto colon = setting.find(':');
+    if (colon == std::string::npos)
+        return false;
+
+    const auto key = setting.substr(0, colon);
+    const auto value = setting.substr(colon + 1);
+
+    if (key == "cpus")
+    {
+        const auto dash = value.find('-');
+        int first, last;
+        if (not to_int(value.substr(0, dash), first))
+            return false;
+        if (dash == std::string::npos)
+            last = first;
+        else if (not to_int(value.substr(dash + 1), last))
+            return false;
+
+        if (first < 0 || last < first || last >= CPU_SETSIZE)
+            return false;
+        for (int cpu = first; cpu <= last; cpu++)
+            policy.cpus.push_back(cpu);
+        return true;
+    }
+
+    int n;
+    if (not to_int(value, n))
+        return false;
+
+    if (key == "nice")
+    {
+        policy.nice = n;
+    } else if (key == "fifo" || key == "rr")
+    {
+        policy.scheduler = key == "fifo" ? scheduling::Policy::Scheduler::fifo : scheduling::Policy::Scheduler::rr;
+        policy.rt_priority = n;
+    } else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// How the process was scheduled before any policy was applied
+struct Baseline
+{
+    Baseline()
+    {
+        const pid_t pid = ::getpid();
+        nice = ::getpriority(PRIO_PROCESS, pid);
+        CPU_ZERO(&cpus);
+        if (::sched_getaffinity(pid, sizeof(cpus), &cpus) != 0)
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                CPU_SET(cpu, &cpus);
+    }
+
+    int nice;
+    cpu_set_t cpus;
+};
+
+const Baseline& baseline()
+{
+    static const Baseline instance;
+    return instance;
+}
+
+bool set_scheduler(pid_t tid, int policy, int priority)
+{
+    sched_param param;
+    param.sched_priority = priority;
+    return ::sched_setscheduler(tid, policy, &param) == 0;
+}
+
+bool set_affinity(pid_t tid, const std::vector<int>& cpus)
+{
+    if (cpus.empty())
+        return ::sched_setaffinity(tid, sizeof(baseline().cpus), &baseline().cpus) == 0;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus)
+        CPU_SET(cpu, &set);
+    return ::sched_setaffinity(tid, sizeof(set), &set) == 0;
+}
+}
+
+scheduling::Class scheduling::class_for_role(media::Player::AudioStreamRole role)
+{
+    switch (role)
+    {
+    case media::Player::AudioStreamRole::alarm:
+        return Class::alarm;
+    case media::Player::AudioStreamRole::alert:
+        return Class::alert;
+    case media::Player::AudioStreamRole::phone:
+        return Class::phone;
+    case media::Player::AudioStreamRole::multimedia:
+    default:
+        return Class::multimedia;
+    }
+}
+
+scheduling::Table scheduling::default_table()
+{
+    return Table
+    {
+        {Class::alarm, Policy{Policy::Scheduler::other, 0, -10, {}}},
+        {Class::alert, Policy{Policy::Scheduler::other, 0, -5, {}}},
+        {Class::multimedia, Policy{Policy::Scheduler::other, 0, 0, {}}},
+        {Class::phone, Policy{Policy::Scheduler::rr, 10, -15, {}}},
+        {Class::background, Policy{Policy::Scheduler::idle, 0, 19, {}}}
+    };
+}
+
+bool scheduling::parse(const std::string& spec, scheduling::Table& table)
+{
+    auto result = table;
+
+    for (const auto& entry : split(spec, ';'))
+    {
+        const auto equals = entry.find('=');
+        if (equals == std::string::npos)
+            return false;
+
+        auto it = classes().find(entry.substr(0, equals));
+        if (it == classes().end())
+            return false;
+
+        // Settings given for a class replace its defaults entirely
+        Policy policy{Policy::Scheduler::other, 0, 0, {}};
+        for (const auto& setting : split(entry.substr(equals + 1), ','))
+            if (not parse_setting(setting, policy))
+                return false;
+
+        result[it->second] = policy;
+    }
+
+    table = result;
+    return true;
+}
+
+const scheduling::Policy& scheduling::policy_for(scheduling::Class c)
+{
+    static const Table table = []()
+    {
+        auto table = default_table();
+        if (auto spec = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_SCHEDULING_POLICY"))
+        {
+            if (not parse(spec, table))
+                MH_WARNING("Ignoring malformed scheduling policy: " << spec);
+        }
+        return table;
+    }();
+
+    return table.at(c);
+}
+
+pid_t scheduling::current_thread()
+{
+    return static_cast<pid_t>(::syscall(SYS_gettid));
+}
+
+bool scheduling::apply(scheduling::Class c, pid_t tid)
+{
+    static auto& applied = metrics::counter("scheduling.applied");
+    static auto& denied = metrics::counter("scheduling.denied");
+    static std::array<std::atomic<bool>, 5> reported{};
+
+    const auto& policy = policy_for(c);
+    bool permitted = true;
+
+    switch (policy.scheduler)
+    {
+    case Policy::Scheduler::fifo:
+    case Policy::Scheduler::rr:
+        if (set_scheduler(tid, policy.scheduler == Policy::Scheduler::fifo ? SCHED_FIFO : SCHED_RR, policy.rt_priority))
+            break;
+        // Not permitted, fall back to the nice level
+        permitted = false;
+        set_scheduler(tid, SCHED_OTHER, 0);
+        if (::setpriority(PRIO_PROCESS, tid, policy.nice) != 0)
+            permitted = false;
+        break;
+    case Policy::Scheduler::idle:
+        // The nice level only matters if the thread ever leaves SCHED_IDLE
+        ::setpriority(PRIO_PROCESS, tid, policy.nice);
+        if (not set_scheduler(tid, SCHED_IDLE, 0))
+            permitted = false;
+        break;
+    case Policy::Scheduler::other:
+        if (not set_scheduler(tid, SCHED_OTHER, 0))
+            permitted = false;
+        if (::setpriority(PRIO_PROCESS, tid, policy.nice) != 0)
+            permitted = false;
+        break;
+    }
+
+    if (not set_affinity(tid, policy.cpus))
+        permitted = false;
+
+    applied.increment();
+    if (not permitted)
+    {
+        denied.increment();
+        // Once per class, the process' limits don't change
+        if (not reported[static_cast<std::size_t>(c)].exchange(true))
+            MH_INFO("Scheduling policy for " << name_of(c) << " threads not fully permitted, check RLIMIT_RTPRIO and RLIMIT_NICE");
+    }
+
+    return permitted;
+}
+
+bool scheduling::reset(pid_t tid)
+{
+    bool permitted = set_scheduler(tid, SCHED_OTHER, 0);
+    if (::setpriority(PRIO_PROCESS, tid, baseline().nice) != 0)
+        permitted = false;
+    if (not set_affinity(tid, {}))
+        permitted = false;
+
+    return permitted;
+}
+
+bool scheduling::reversible(scheduling::Class c)
+{
+    static std::array<std::once_flag, 5> probed;
+    static std::array<bool, 5> results{};
+
+    const auto i = static_cast<std::size_t>(c);
+    std::call_once(probed[i], [c, i]()
+    {
+        // The limits of the process decide, the same for all of its threads
+        std::thread probe([c, i]()
+        {
+            apply(c);
+            results[i] = reset();
+        });
+        probe.join();
+    });
+
+    return results[i];
+}
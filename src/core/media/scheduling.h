@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_UBUNTU_MEDIA_SCHEDULING_H_
+#define CORE_UBUNTU_MEDIA_SCHEDULING_H_
+
+#include <core/media/player.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+namespace scheduling
+{
+// What a thread works on. The streaming threads of a player follow its audio
+// stream role, metadata extraction and cover art are background work.
+enum class Class
+{
+    alarm,
+    alert,
+    multimedia,
+    phone,
+    background
+};
+
+struct Policy
+{
+    enum class Scheduler
+    {
+        other,
+        fifo,
+        rr,
+        idle
+    };
+
+    Scheduler scheduler;
+    // Only used with fifo and rr
+    int rt_priority;
+    // Also the fallback if fifo or rr are not permitted
+    int nice;
+    // Empty for all cpus the process may run on
+    std::vector<int> cpus;
+};
+
+typedef std::map<Class, Policy> Table;
+
+Class class_for_role(Player::AudioStreamRole role);
+
+// The built-in policies:
+//   phone      rr:10, falling back to nice:-15
+//   alarm      nice:-10
+//   alert      nice:-5
+//   multimedia nice:0
+//   background idle
+Table default_table();
+
+// Overrides the policies of table as given by spec, e.g.
+//   "phone=fifo:20;multimedia=nice:-5,cpus:0-1,cpus:4;background=idle"
+// Returns false and leaves table untouched on syntax errors.
+bool parse(const std::string& spec, Table& table);
+
+// The defaults with CORE_UBUNTU_MEDIA_SERVICE_SCHEDULING_POLICY applied
+const Policy& policy_for(Class c);
+
+// Id of the calling thread
+pid_t current_thread();
+
+// Applies the policy of the class to the thread, 0 being the calling thread.
+// Returns false if parts of the policy weren't permitted, e.g. realtime
+// scheduling or negative nice levels without CAP_SYS_NICE.
+bool apply(Class c, pid_t tid = 0);
+
+// Puts the thread back to the scheduling of the process.
+// Returns false if not permitted, e.g. after a nice level was raised.
+bool reset(pid_t tid = 0);
+
+// Whether reset() succeeds after apply(c). Not the case for background work
+// unless RLIMIT_NICE or CAP_SYS_NICE allow to lower the nice level again.
+// Probed once per class on a thread of its own.
+bool reversible(Class c);
+}
+}
+}
+}
+
+#endif // CORE_UBUNTU_MEDIA_SCHEDULING_H_
@@ -22,9 +22,11 @@
 
 #include <hybris/media/media_codec_layer.h>
 
+#include "core/media/logger.h"
 #include "core/media/service_implementation.h"
+#include "core/media/gstreamer/preload.h"
 
-#include <iostream>
+#include <thread>
 
 namespace media = core::ubuntu::media;
 
@@ -34,10 +36,16 @@ int main()
 {
     // Init hybris-level DecodingService
     decoding_service_init();
-    cout << "Starting DecodingService..." << endl;
+    MH_INFO("Starting DecodingService...");
+
+    // Warm up the plugins needed for playback while nothing else is going on
+    std::thread preloader([]() { gstreamer::preload(gstreamer::preload_elements()); });
 
     auto service = std::make_shared<media::ServiceImplementation>();
     service->run();
 
+    if (preloader.joinable())
+        preloader.join();
+
     return 0;
 }
@@ -18,13 +18,41 @@
 
 #include <core/media/service.h>
 
+#include "logger.h"
 #include "service_stub.h"
 
 namespace media = core::ubuntu::media;
 
 const std::shared_ptr<media::Service> media::Service::Client::instance()
 {
-    std::cout << "Creating a new static Service instance" << std::endl;
+    MH_DEBUG("Creating a new static Service instance");
     static std::shared_ptr<media::Service> instance{new media::ServiceStub()};
     return instance;
 }
+
+std::future<std::shared_ptr<media::Player>> media::Service::create_session_async(const media::Player::Configuration& config)
+{
+    std::promise<std::shared_ptr<media::Player>> promise;
+    try
+    {
+        promise.set_value(create_session(config));
+    } catch (...)
+    {
+        promise.set_exception(std::current_exception());
+    }
+    return promise.get_future();
+}
+
+std::future<void> media::Service::pause_other_sessions_async(media::Player::PlayerKey key)
+{
+    std::promise<void> promise;
+    try
+    {
+        pause_other_sessions(key);
+        promise.set_value();
+    } catch (...)
+    {
+        promise.set_exception(std::current_exception());
+    }
+    return promise.get_future();
+}
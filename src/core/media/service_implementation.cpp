@@ -24,17 +24,29 @@
 
 #include "indicator_power_service.h"
 #include "call-monitor/call_monitor.h"
+#include "logger.h"
+#include "metrics.h"
 #include "player_configuration.h"
 #include "player_implementation.h"
+#include "trace.h"
 
 #include <boost/asio.hpp>
 
 #include <string>
 #include <cstdint>
 #include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include <pulse/pulseaudio.h>
 
@@ -51,16 +63,30 @@ using namespace std;
 
 struct media::ServiceImplementation::Private
 {
+    // Sessions idle for longer than this release their pipeline, 0 disables hibernation
+    static std::chrono::seconds hibernation_timeout()
+    {
+        const char* value = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_HIBERNATION_TIMEOUT_S");
+        return std::chrono::seconds{value != nullptr ? std::atoi(value) : 300};
+    }
+
     Private()
         : resume_key(std::numeric_limits<std::uint32_t>::max()),
           keep_alive(io_service),
+          hibernation_timer(io_service),
+          metrics_dump_timer(io_service),
           disp_cookie(0),
           pulse_mainloop_api(nullptr),
+          pulse_mainloop(nullptr),
           pulse_context(nullptr),
           headphones_connected(false),
           a2dp_connected(false),
           primary_idx(-1),
-          call_monitor(new CallMonitor)
+          introspection_timer(nullptr),
+          pending_events(0),
+          fanout_running(false),
+          urgent_fanouts_waiting(0),
+          fanout_workers_stopped(false)
     {
         bus = std::shared_ptr<dbus::Bus>(new dbus::Bus(core::dbus::WellKnownBus::session));
         bus->install_executor(dbus::asio::make_executor(bus, io_service));
@@ -69,8 +95,51 @@ struct media::ServiceImplementation::Private
             bus->run();
         }));
 
-        // Spawn pulse watchdog
-        pulse_mainloop = nullptr;
+        schedule_metrics_dump();
+
+#if 0
+        observer = android_media_recorder_observer_new();
+        android_media_recorder_observer_set_cb(observer, &Private::media_recording_started_callback, this);
+#endif
+    }
+
+    ~Private()
+    {
+        if (subsystems_worker.joinable())
+            subsystems_worker.join();
+
+        hibernation_timer.cancel();
+        metrics_dump_timer.cancel();
+        release_pulse_context();
+
+        if (pulse_mainloop != nullptr)
+        {
+            pa_threaded_mainloop_stop(pulse_mainloop);
+            pa_threaded_mainloop_free(pulse_mainloop);
+            pulse_mainloop = nullptr;
+        }
+
+        bus->stop();
+
+        if (worker.joinable())
+            worker.join();
+
+        if (pulse_worker.joinable())
+            pulse_worker.join();
+
+        {
+            std::lock_guard<std::mutex> lg(fanout_jobs_guard);
+            fanout_workers_stopped = true;
+        }
+        fanout_jobs_available.notify_all();
+        for (auto& t : fanout_workers)
+            t.join();
+    }
+
+    // The subsystems below are not needed to serve the first requests. They are
+    // brought up from subsystems_worker after the service is on the bus.
+    void start_pulse_watchdog()
+    {
         pulse_worker = std::move(std::thread([this]()
         {
             std::unique_lock<std::mutex> lk(pulse_mutex);
@@ -100,6 +169,7 @@ struct media::ServiceImplementation::Private
                                 pa_operation_unref(o);
                             }
 
+                            cancel_introspection_pass();
                             pa_context_set_state_callback(pulse_context, NULL, NULL);
                             pa_context_set_subscribe_callback(pulse_context, NULL, NULL);
                             pa_context_disconnect(pulse_context);
@@ -115,7 +185,7 @@ struct media::ServiceImplementation::Private
 
                         if (pa_threaded_mainloop_start(pulse_mainloop) != 0)
                         {
-                            std::cerr << "Unable to start pulseaudio mainloop, audio output detection will not function" << std::endl;
+                            MH_ERROR("Unable to start pulseaudio mainloop, audio output detection will not function");
                             pa_threaded_mainloop_free(pulse_mainloop);
                             pulse_mainloop = nullptr;
                         }
@@ -129,50 +199,70 @@ struct media::ServiceImplementation::Private
                     return false;
                 });
         }));
+    }
 
+    void connect_to_indicator_power()
+    {
         // Connect the property change signal that will allow media-hub to take appropriate action
         // when the battery level reaches critical
         auto stub_service = dbus::Service::use_service(bus, "com.canonical.indicator.power");
-        indicator_power_session = stub_service->object_for_path(dbus::types::ObjectPath("/com/canonical/indicator/power/Battery"));
-        power_level = indicator_power_session->get_property<core::IndicatorPower::PowerLevel>();
-        is_warning = indicator_power_session->get_property<core::IndicatorPower::IsWarning>();
+        auto session = stub_service->object_for_path(dbus::types::ObjectPath("/com/canonical/indicator/power/Battery"));
+        auto level = session->get_property<core::IndicatorPower::PowerLevel>();
+        auto warning = session->get_property<core::IndicatorPower::IsWarning>();
+
+        std::lock_guard<std::mutex> lg(subsystems_guard);
+        indicator_power_session = session;
+        power_level = level;
+        is_warning = warning;
+    }
 
+    void connect_to_unity_screen()
+    {
         // Obtain session with Unity.Screen so that we request state when doing recording
         auto bus = std::shared_ptr<dbus::Bus>(new dbus::Bus(core::dbus::WellKnownBus::system));
         bus->install_executor(dbus::asio::make_executor(bus));
 
         auto uscreen_stub_service = dbus::Service::use_service(bus, dbus::traits::Service<core::UScreen>::interface_name());
-        uscreen_session = uscreen_stub_service->object_for_path(dbus::types::ObjectPath("/com/canonical/Unity/Screen"));
+        auto session = uscreen_stub_service->object_for_path(dbus::types::ObjectPath("/com/canonical/Unity/Screen"));
 
-#if 0
-        observer = android_media_recorder_observer_new();
-        android_media_recorder_observer_set_cb(observer, &Private::media_recording_started_callback, this);
-#endif
+        std::lock_guard<std::mutex> lg(subsystems_guard);
+        uscreen_session = session;
     }
 
-    ~Private()
+    // The Unity screen session, null until subsystems_worker published it
+    std::shared_ptr<dbus::Object> unity_screen()
     {
-        release_pulse_context();
+        std::lock_guard<std::mutex> lg(subsystems_guard);
+        return uscreen_session;
+    }
 
-        if (pulse_mainloop != nullptr)
-        {
-            pa_threaded_mainloop_stop(pulse_mainloop);
-            pa_threaded_mainloop_free(pulse_mainloop);
-            pulse_mainloop = nullptr;
-        }
+    // Periodically writes all metrics to CORE_UBUNTU_MEDIA_SERVICE_METRICS_FILE
+    // if set, every CORE_UBUNTU_MEDIA_SERVICE_METRICS_INTERVAL_S seconds.
+    void schedule_metrics_dump()
+    {
+        static const char* path = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_METRICS_FILE");
+        if (path == nullptr)
+            return;
 
-        bus->stop();
+        static const char* interval = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_METRICS_INTERVAL_S");
+        metrics_dump_timer.expires_from_now(
+                    boost::posix_time::seconds(interval != nullptr ? std::max(1, std::atoi(interval)) : 10));
+        metrics_dump_timer.async_wait([this](const boost::system::error_code& ec)
+        {
+            if (ec == boost::asio::error::operation_aborted)
+                return;
 
-        if (worker.joinable())
-            worker.join();
+            if (!metrics::Registry::instance().dump_to_file(path))
+                MH_WARNING("Failed to dump metrics to " << path);
 
-        if (pulse_worker.joinable())
-            pulse_worker.join();
+            schedule_metrics_dump();
+        });
     }
 
     void media_recording_started(bool started)
     {
-        if (uscreen_session == nullptr)
+        auto uscreen = unity_screen();
+        if (uscreen == nullptr)
             return;
 
         if (started)
@@ -183,7 +273,7 @@ struct media::ServiceImplementation::Private
             // Make sure we pause all playback sessions so that it doesn't interfere with recorded audio
             pause_playback();
 
-            auto result = uscreen_session->invoke_method_synchronously<core::UScreen::keepDisplayOn, int>();
+            auto result = uscreen->invoke_method_synchronously<core::UScreen::keepDisplayOn, int>();
             if (result.is_error())
                 throw std::runtime_error(result.error().print());
             disp_cookie = result.value();
@@ -192,8 +282,8 @@ struct media::ServiceImplementation::Private
         {
             if (disp_cookie != -1)
             {
-                timeout(4000, true, [this](){
-                    this->uscreen_session->invoke_method_synchronously<core::UScreen::removeDisplayOnRequest, void>(this->disp_cookie);
+                timeout(4000, true, [this, uscreen](){
+                    uscreen->invoke_method_synchronously<core::UScreen::removeDisplayOnRequest, void>(this->disp_cookie);
                     this->disp_cookie = -1;
                 });
             }
@@ -239,21 +329,31 @@ struct media::ServiceImplementation::Private
                 [](pa_context *context, const pa_card_info *info, int eol, void *userdata)
                 {
                     (void) context;
-                    (void) eol;
 
-                    if (info == nullptr || userdata == nullptr)
+                    if (userdata == nullptr)
                         return;
 
                     Private *p = reinterpret_cast<Private*>(userdata);
+
+                    // The card is the last thing an introspection pass looks at
+                    if (eol)
+                    {
+                        p->finish_introspection_pass();
+                        return;
+                    }
+
+                    if (info == nullptr)
+                        return;
+
                     if (p->is_port_available(info->ports, info->n_ports, "output-wired"))
                     {
                         if (!p->headphones_connected)
-                            std::cout << "Wired headphones connected" << std::endl;
+                            MH_INFO("Wired headphones connected");
                         p->headphones_connected = true;
                     }
                     else if (p->headphones_connected == true)
                     {
-                        std::cout << "Wired headphones disconnected" << std::endl;
+                        MH_INFO("Wired headphones disconnected");
                         p->headphones_connected = false;
                         p->pause_playback_if_necessary(std::get<0>(p->active_sink));
                     }
@@ -288,9 +388,9 @@ struct media::ServiceImplementation::Private
                     Private *p = reinterpret_cast<Private*>(userdata); 
                     std::tuple<uint32_t, uint32_t, std::string> new_sink(std::make_tuple(i->index, i->card, i->name));
 
-                    printf("pulsesink: active_sink=('%s',%d,%d) -> ('%s',%d,%d)\n",
-                        std::get<2>(p->active_sink).c_str(), std::get<0>(p->active_sink),
-                        std::get<1>(p->active_sink), i->name, i->index, i->card);
+                    MH_DEBUG("pulsesink: active_sink=('" << std::get<2>(p->active_sink) << "',"
+                             << std::get<0>(p->active_sink) << "," << std::get<1>(p->active_sink) << ") -> ('"
+                             << i->name << "'," << i->index << "," << i->card << ")");
 
                     p->pause_playback_if_necessary(i->index);
                     p->active_sink = new_sink;
@@ -307,7 +407,8 @@ struct media::ServiceImplementation::Private
                     (void) context;
 
                     Private *p = reinterpret_cast<Private*>(userdata);
-                    if (i->default_sink_name != std::get<2>(p->active_sink))
+                    const std::string default_sink{i->default_sink_name != nullptr ? i->default_sink_name : ""};
+                    if (default_sink != std::get<2>(p->active_sink))
                         p->set_active_sink(i->default_sink_name);
                     p->update_wired_output();
                 }, this);
@@ -315,6 +416,91 @@ struct media::ServiceImplementation::Private
         (void) o;
     }
 
+    // Bluetooth connects and port switches produce bursts of sink and card
+    // events. Events are coalesced until none arrived for the debounce
+    // interval, or the burst got too long, then a single introspection pass
+    // refreshes the default sink and the ports of the primary card. Must be
+    // called with the mainloop locked.
+    void schedule_introspection_pass()
+    {
+        static const pa_usec_t debounce = []()
+        {
+            const char* value = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_PULSE_DEBOUNCE_MS");
+            return static_cast<pa_usec_t>(value != nullptr ? std::max(0, std::atoi(value)) : 50) * PA_USEC_PER_MSEC;
+        }();
+        static const pa_usec_t max_delay = 4 * debounce;
+
+        static metrics::Counter& events = metrics::counter("pulse.events");
+        events.increment();
+        pending_events++;
+
+        timeval now;
+        pa_gettimeofday(&now);
+
+        timeval when = now;
+        pa_timeval_add(&when, debounce);
+
+        if (introspection_timer == nullptr)
+        {
+            burst_start = now;
+            introspection_timer = pulse_mainloop_api->time_new(pulse_mainloop_api, &when,
+                    [](pa_mainloop_api *api, pa_time_event *e, const struct timeval *tv, void *userdata)
+                    {
+                        (void) tv;
+
+                        Private *p = reinterpret_cast<Private*>(userdata);
+                        api->time_free(e);
+                        p->introspection_timer = nullptr;
+                        p->start_introspection_pass();
+                    }, this);
+        }
+        else if (pa_timeval_diff(&now, &burst_start) < max_delay)
+        {
+            pulse_mainloop_api->time_restart(introspection_timer, &when);
+        }
+    }
+
+    void start_introspection_pass()
+    {
+        static metrics::Counter& passes = metrics::counter("pulse.introspection_passes");
+        static metrics::Histogram& events_per_pass = metrics::histogram("pulse.events_per_pass");
+
+        if (pulse_context == nullptr)
+            return;
+
+        passes.increment();
+        events_per_pass.record(pending_events);
+        pending_events = 0;
+
+        pass_started = std::chrono::steady_clock::now();
+        update_active_sink();
+    }
+
+    void finish_introspection_pass()
+    {
+        static metrics::Histogram& pass_duration = metrics::histogram("pulse.introspection_pass_us");
+
+        if (pass_started == std::chrono::steady_clock::time_point{})
+            return;
+
+        pass_duration.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now() - pass_started).count());
+        pass_started = std::chrono::steady_clock::time_point{};
+    }
+
+    // Must be called with the mainloop locked
+    void cancel_introspection_pass()
+    {
+        if (introspection_timer != nullptr)
+        {
+            pulse_mainloop_api->time_free(introspection_timer);
+            introspection_timer = nullptr;
+        }
+
+        pending_events = 0;
+        pass_started = std::chrono::steady_clock::time_point{};
+    }
+
     void create_pulse_context()
     {
         if (pulse_context != nullptr)
@@ -339,7 +525,7 @@ struct media::ServiceImplementation::Private
 
         if (pulse_context == nullptr)
         {
-            std::cerr << "Unable to create new pulseaudio context" << std::endl;
+            MH_ERROR("Unable to create new pulseaudio context");
             pa_threaded_mainloop_unlock(pulse_mainloop);
             return;
         }
@@ -357,7 +543,7 @@ struct media::ServiceImplementation::Private
                     break;
 
                 case PA_CONTEXT_READY:
-                    std::cout << "Pulseaudio connection established." << std::endl;
+                    MH_INFO("Pulseaudio connection established.");
                     keep_going = false;
                     break;
 
@@ -368,7 +554,7 @@ struct media::ServiceImplementation::Private
                     break;
 
                 default:
-                    std::cerr << "Pulseaudio connection failure: " << pa_strerror(pa_context_errno(pulse_context));
+                    MH_ERROR("Pulseaudio connection failure: " << pa_strerror(pa_context_errno(pulse_context)));
                     keep_going = false;
                     ok = false;
             }
@@ -423,16 +609,24 @@ struct media::ServiceImplementation::Private
                             return;
 
                         Private *p = reinterpret_cast<Private*>(userdata);
-                        if ((t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK) == PA_SUBSCRIPTION_EVENT_SINK)
+                        switch (t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK)
                         {
-                            p->update_active_sink(); 
+                            case PA_SUBSCRIPTION_EVENT_SINK:
+                            case PA_SUBSCRIPTION_EVENT_CARD:
+                            case PA_SUBSCRIPTION_EVENT_SERVER:
+                                p->schedule_introspection_pass();
+                                break;
+                            default:
+                                break;
                         }
                     }, this);
-            pa_context_subscribe(pulse_context, PA_SUBSCRIPTION_MASK_SINK, nullptr, this);
+            pa_context_subscribe(pulse_context,
+                    static_cast<pa_subscription_mask_t>(PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_CARD | PA_SUBSCRIPTION_MASK_SERVER),
+                    nullptr, this);
         }
         else
         {
-            std::cerr << "Connection to pulseaudio failed or was dropped." << std::endl;
+            MH_ERROR("Connection to pulseaudio failed or was dropped.");
             pa_context_unref(pulse_context);
             pulse_context = nullptr;
         }
@@ -445,6 +639,7 @@ struct media::ServiceImplementation::Private
         if (pulse_context != nullptr)
         {
             pa_threaded_mainloop_lock(pulse_mainloop);
+            cancel_introspection_pass();
             pa_context_disconnect(pulse_context);
             pa_context_unref(pulse_context);
             pa_threaded_mainloop_unlock(pulse_mainloop);
@@ -456,14 +651,20 @@ struct media::ServiceImplementation::Private
     // when the battery level reached 10% or 5%
     media::Player::PlayerKey resume_key;
     std::thread worker;
+    std::thread subsystems_worker;
     dbus::Bus::Ptr bus;
     boost::asio::io_service io_service;
     boost::asio::io_service::work keep_alive;
+    boost::asio::deadline_timer hibernation_timer;
+    boost::asio::deadline_timer metrics_dump_timer;
     std::shared_ptr<dbus::Object> indicator_power_session;
     std::shared_ptr<core::dbus::Property<core::IndicatorPower::PowerLevel>> power_level;
     std::shared_ptr<core::dbus::Property<core::IndicatorPower::IsWarning>> is_warning;
     int disp_cookie;
     std::shared_ptr<dbus::Object> uscreen_session;
+    // Guards the members above and call_monitor, which subsystems_worker
+    // publishes while requests and pulse callbacks are already served.
+    std::mutex subsystems_guard;
 #if 0
     MediaRecorderObserver *observer;
 #endif
@@ -480,17 +681,131 @@ struct media::ServiceImplementation::Private
     std::tuple<int, int, std::string> active_sink;
     int primary_idx;
 
+    pa_time_event *introspection_timer;
+    timeval burst_start;
+    std::uint64_t pending_events;
+    std::chrono::steady_clock::time_point pass_started;
+
     // Gets signaled when both the headphone jack is removed or an A2DP device is
     // disconnected and playback needs pausing. Also gets signaled when recording
     // begins.
     core::Signal<void> pause_playback;
     std::unique_ptr<CallMonitor> call_monitor;
     std::list<media::Player::PlayerKey> paused_sessions;
+
+    // Pause fan-outs run one at a time, urgent ones go first
+    struct FanOutTurn
+    {
+        FanOutTurn(Private& owner, bool urgent) : p(owner)
+        {
+            std::unique_lock<std::mutex> lk(p.fanout_guard);
+            if (urgent)
+                p.urgent_fanouts_waiting++;
+
+            p.fanout_idle.wait(lk, [this, urgent]()
+            {
+                return !p.fanout_running && (urgent || p.urgent_fanouts_waiting == 0);
+            });
+
+            if (urgent)
+                p.urgent_fanouts_waiting--;
+            p.fanout_running = true;
+        }
+
+        ~FanOutTurn()
+        {
+            std::lock_guard<std::mutex> lg(p.fanout_guard);
+            p.fanout_running = false;
+            p.fanout_idle.notify_all();
+        }
+
+        Private& p;
+    };
+    std::mutex fanout_guard;
+    std::condition_variable fanout_idle;
+    bool fanout_running;
+    unsigned int urgent_fanouts_waiting;
+
+    // Runs f on one of the fan-out workers. Workers are started on demand,
+    // up to max_fanout_workers, and kept for the following fan-outs.
+    std::future<void> dispatch_fanout_job(std::function<void()> f, std::size_t fanout_size)
+    {
+        static constexpr std::size_t max_fanout_workers{4};
+
+        std::packaged_task<void()> job(f);
+        auto result = job.get_future();
+        {
+            std::lock_guard<std::mutex> lg(fanout_jobs_guard);
+            fanout_jobs.push_back(std::move(job));
+            if (fanout_workers.size() < std::min(fanout_size, max_fanout_workers))
+                fanout_workers.emplace_back([this]() { run_fanout_worker(); });
+        }
+        fanout_jobs_available.notify_one();
+
+        return result;
+    }
+
+    void run_fanout_worker()
+    {
+        std::unique_lock<std::mutex> lk(fanout_jobs_guard);
+        while (true)
+        {
+            fanout_jobs_available.wait(lk, [this]() { return fanout_workers_stopped || !fanout_jobs.empty(); });
+            if (fanout_workers_stopped)
+                return;
+
+            auto job = std::move(fanout_jobs.front());
+            fanout_jobs.pop_front();
+
+            lk.unlock();
+            job();
+            lk.lock();
+        }
+    }
+
+    std::mutex fanout_jobs_guard;
+    std::condition_variable fanout_jobs_available;
+    std::deque<std::packaged_task<void()>> fanout_jobs;
+    std::vector<std::thread> fanout_workers;
+    bool fanout_workers_stopped;
+    std::once_flag hibernation_scan_started;
 };
 
 media::ServiceImplementation::ServiceImplementation() : d(new Private())
 {
-    d->power_level->changed().connect([this](const core::IndicatorPower::PowerLevel::ValueType &level)
+    d->pause_playback.connect([this]()
+    {
+        MH_INFO("Got pause_playback signal, pausing all multimedia sessions");
+        pause_all_multimedia_sessions();
+    });
+
+    // Our bus name is already taken by the skeleton, bring up everything else
+    // in parallel to serving the first requests.
+    d->subsystems_worker = std::thread([this]() { initialize_subsystems(); });
+}
+
+media::ServiceImplementation::~ServiceImplementation()
+{
+    if (d->subsystems_worker.joinable())
+        d->subsystems_worker.join();
+}
+
+void media::ServiceImplementation::initialize_subsystems()
+{
+    MH_TRACE_SCOPE("service", "initialize_subsystems");
+
+    d->start_pulse_watchdog();
+    d->connect_to_indicator_power();
+
+    std::shared_ptr<core::dbus::Property<core::IndicatorPower::PowerLevel>> power_level;
+    std::shared_ptr<core::dbus::Property<core::IndicatorPower::IsWarning>> is_warning;
+    {
+        std::lock_guard<std::mutex> lg(d->subsystems_guard);
+        power_level = d->power_level;
+        is_warning = d->is_warning;
+    }
+
+    power_level->changed().connect([this](const core::IndicatorPower::PowerLevel::ValueType &level)
     {
         // When the battery level hits 10% or 5%, pause all multimedia sessions.
         // Playback will resume when the user clears the presented notification.
@@ -498,7 +813,7 @@ media::ServiceImplementation::ServiceImplementation() : d(new Private())
             pause_all_multimedia_sessions();
     });
 
-    d->is_warning->changed().connect([this](const core::IndicatorPower::IsWarning::ValueType &notifying)
+    is_warning->changed().connect([this](const core::IndicatorPower::IsWarning::ValueType &notifying)
     {
         // If the low battery level notification is no longer being displayed,
         // resume what the user was previously playing
@@ -506,29 +821,62 @@ media::ServiceImplementation::ServiceImplementation() : d(new Private())
             resume_multimedia_session();
     });
 
-    d->pause_playback.connect([this]()
-    {
-        std::cout << "Got pause_playback signal, pausing all multimedia sessions" << std::endl;
-        pause_all_multimedia_sessions();
-    });
-
-    d->call_monitor->on_change([this](CallMonitor::State state) {
+    // Fully set up before publishing, nothing else touches it until then
+    std::unique_ptr<CallMonitor> call_monitor{new CallMonitor};
+    call_monitor->on_change([this](CallMonitor::State state) {
         switch (state) {
         case CallMonitor::OffHook:
-            std::cout << "Got call started signal, pausing all multimedia sessions" << std::endl;
-            pause_all_multimedia_sessions();
+            MH_INFO("Got call started signal, pausing all multimedia sessions");
+            pause_all_multimedia_sessions(true);
             break;
         case CallMonitor::OnHook:
-            std::cout << "Got call ended signal, resuming paused multimedia sessions" << std::endl;
+            MH_INFO("Got call ended signal, resuming paused multimedia sessions");
             // Don't auto-resume any paused video playback sessions
             resume_paused_multimedia_sessions(false);
             break;
         }
     });
+
+    {
+        std::lock_guard<std::mutex> lg(d->subsystems_guard);
+        d->call_monitor = std::move(call_monitor);
+    }
+
+    d->connect_to_unity_screen();
+
+    const auto elapsed = metrics::time_since_process_start();
+    metrics::gauge("startup.subsystems_ready_us").set(elapsed.count());
+    MH_INFO("Subsystems ready " << elapsed.count() / 1000 << "ms after start");
 }
 
-media::ServiceImplementation::~ServiceImplementation()
+void media::ServiceImplementation::schedule_hibernation_scan()
 {
+    const auto idle_time = Private::hibernation_timeout();
+    if (idle_time.count() <= 0)
+        return;
+
+    // Scanning at a fraction of the timeout bounds how late a session gets hibernated
+    d->hibernation_timer.expires_from_now(boost::posix_time::seconds(std::max<long>(1, idle_time.count() / 4)));
+
+    std::weak_ptr<media::ServiceImplementation> weak_self{std::static_pointer_cast<media::ServiceImplementation>(shared_from_this())};
+    d->hibernation_timer.async_wait([weak_self, idle_time](const boost::system::error_code& ec)
+    {
+        if (ec == boost::asio::error::operation_aborted)
+            return;
+
+        auto self = weak_self.lock();
+        if (not self)
+            return;
+
+        self->enumerate_players([idle_time](const media::Player::PlayerKey& key, const std::shared_ptr<media::Player>& player)
+        {
+            auto impl = std::dynamic_pointer_cast<media::PlayerImplementation>(player);
+            if (impl and impl->hibernate_if_idle_for(idle_time))
+                MH_DEBUG("Hibernated idle Player with key: " << key);
+        });
+
+        self->schedule_hibernation_scan();
+    });
 }
 
 std::shared_ptr<media::Player> media::ServiceImplementation::create_session(
@@ -537,6 +885,10 @@ std::shared_ptr<media::Player> media::ServiceImplementation::create_session(
     auto player = std::make_shared<media::PlayerImplementation>(
             conf.identity, conf.bus, conf.session, shared_from_this(), conf.key);
 
+    // Arm the idle scan with the first session, shared_from_this() isn't
+    // available in the constructor
+    std::call_once(d->hibernation_scan_started, [this]() { schedule_hibernation_scan(); });
+
     auto key = conf.key;
     player->on_client_disconnected().connect([this, key]()
     {
@@ -574,17 +926,20 @@ void media::ServiceImplementation::pause_other_sessions(media::Player::PlayerKey
 {
     if (not has_player_for_key(key))
     {
-        cerr << "Could not find Player by key: " << key << endl;
+        MH_WARNING("Could not find Player by key: " << key);
         return;
     }
 
     auto current_player = player_for_key(key);
 
+    Private::FanOutTurn turn(*d, false);
+
     // We immediately make the player known as new current player.
     if (current_player->audio_stream_role() == media::Player::multimedia)
         set_current_player_for_key(key);
 
-    enumerate_players([current_player, key](const media::Player::PlayerKey& other_key, const std::shared_ptr<media::Player>& other_player)
+    std::vector<std::shared_ptr<media::Player>> to_pause;
+    enumerate_players([current_player, key, &to_pause](const media::Player::PlayerKey& other_key, const std::shared_ptr<media::Player>& other_player)
     {
         // Only pause a Player if all of the following criteria are met:
         // 1) currently playing
@@ -596,35 +951,83 @@ void media::ServiceImplementation::pause_other_sessions(media::Player::PlayerKey
             current_player->audio_stream_role() == media::Player::multimedia &&
             other_player->audio_stream_role() == media::Player::multimedia)
         {
-            cout << "Pausing Player with key: " << other_key << endl;
-            other_player->pause();
+            MH_INFO("Pausing Player with key: " << other_key);
+            to_pause.push_back(other_player);
         }
     });
+
+    pause_players(to_pause);
 }
 
-void media::ServiceImplementation::pause_all_multimedia_sessions()
+void media::ServiceImplementation::pause_all_multimedia_sessions(bool urgent)
 {
-    enumerate_players([this](const media::Player::PlayerKey& key, const std::shared_ptr<media::Player>& player)
+    MH_TRACE_SCOPE("service", urgent ? "pause_all.urgent" : "pause_all");
+    // Also serializes access to paused_sessions
+    Private::FanOutTurn turn(*d, urgent);
+
+    std::vector<std::shared_ptr<media::Player>> to_pause;
+    enumerate_players([this, &to_pause](const media::Player::PlayerKey& key, const std::shared_ptr<media::Player>& player)
                       {
                           if (player->playback_status() == Player::playing
                               && player->audio_stream_role() == media::Player::multimedia)
                           {
                               d->paused_sessions.push_back(key);
-                              std::cout << "Pausing Player with key: " << key << std::endl;
-                              player->pause();
+                              MH_INFO("Pausing Player with key: " << key);
+                              to_pause.push_back(player);
                           }
                       });
+
+    pause_players(to_pause);
+}
+
+void media::ServiceImplementation::pause_players(const std::vector<std::shared_ptr<media::Player>>& players)
+{
+    static metrics::Histogram& fanout_duration = metrics::histogram("service.pause_fanout_us");
+    static metrics::Histogram& fanout_size = metrics::histogram("service.pause_fanout_sessions");
+
+    if (players.empty())
+        return;
+
+    MH_TRACE_SCOPE("service", "pause_fanout");
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Each pause blocks until its pipeline transitioned, hand them all to the
+    // fan-out workers so we wait for the slowest rather than the sum
+    std::vector<std::future<void>> pending;
+    pending.reserve(players.size());
+    for (const auto& player : players)
+        pending.push_back(d->dispatch_fanout_job([player]() { player->pause(); }, players.size()));
+
+    for (auto& f : pending)
+    {
+        try
+        {
+            f.get();
+        } catch (const std::exception& e)
+        {
+            MH_WARNING("Failed to pause Player: " << e.what());
+        }
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+    fanout_duration.record(elapsed.count());
+    fanout_size.record(players.size());
+    MH_DEBUG("Paused " << players.size() << " sessions in " << elapsed.count() / 1000 << "ms");
 }
 
 void media::ServiceImplementation::resume_paused_multimedia_sessions(bool resume_video_sessions)
 {
+    Private::FanOutTurn turn(*d, false);
+
     std::for_each(d->paused_sessions.begin(), d->paused_sessions.end(), [this, resume_video_sessions](const media::Player::PlayerKey& key) {
             auto player = player_for_key(key);
             // Only resume video playback if explicitly desired
             if (resume_video_sessions || player->is_audio_source())
                 player->play();
             else
-                std::cout << "Not auto-resuming video playback session." << std::endl;
+                MH_INFO("Not auto-resuming video playback session.");
         });
 
     d->paused_sessions.clear();
@@ -639,7 +1042,7 @@ void media::ServiceImplementation::resume_multimedia_session()
 
     if (player->playback_status() == Player::paused)
     {
-        cout << "Resuming playback of Player with key: " << d->resume_key << endl;
+        MH_INFO("Resuming playback of Player with key: " << d->resume_key);
         player->play();
         d->resume_key = std::numeric_limits<std::uint32_t>::max();
     }
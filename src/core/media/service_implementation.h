@@ -21,6 +21,9 @@
 
 #include "service_skeleton.h"
 
+#include <memory>
+#include <vector>
+
 namespace core
 {
 namespace ubuntu
@@ -42,9 +45,17 @@ public:
     void pause_other_sessions(Player::PlayerKey key);
 
 private:
-    void pause_all_multimedia_sessions();
+    // Brings up pulse, power, screen and call monitoring off the startup path
+    void initialize_subsystems();
+    // Urgent requests, e.g. for an incoming call, are served before other pending ones
+    void pause_all_multimedia_sessions(bool urgent = false);
+    // Pauses all given players concurrently, returns when all of them are paused.
+    // The caller holds the fan-out turn.
+    void pause_players(const std::vector<std::shared_ptr<Player>>& players);
     void resume_paused_multimedia_sessions(bool resume_video_sessions = true);
     void resume_multimedia_session();
+    // Periodically hibernates sessions that have been idle for too long
+    void schedule_hibernation_scan();
 
     struct Private;
     std::shared_ptr<Private> d;
@@ -19,7 +19,11 @@
 
 #include "service_skeleton.h"
 
+#include <core/media/track_list.h>
+
 #include "apparmor.h"
+#include "logger.h"
+#include "metrics.h"
 
 #include "mpris/media_player2.h"
 #include "mpris/metadata.h"
@@ -28,7 +32,11 @@
 #include "mpris/service.h"
 
 #include "player_configuration.h"
+#include "player_implementation.h"
+#include "playlist_store.h"
+#include "session_journal.h"
 #include "the_session_bus.h"
+#include "trace.h"
 #include "xesam.h"
 
 #include <core/dbus/message.h>
@@ -37,9 +45,14 @@
 
 #include <core/posix/this_process.h>
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <map>
+#include <mutex>
 #include <regex>
 #include <sstream>
+#include <tuple>
 
 namespace dbus = core::dbus;
 namespace media = core::ubuntu::media;
@@ -56,8 +69,18 @@ struct media::ServiceSkeleton::Private
           object(impl->access_service()->add_object_for_path(
                      dbus::traits::Service<media::Service>::object_path())),
           dbus_stub(impl->access_bus()),
+          next_session_key(0),
           exported(impl->access_bus(), resolver)
     {
+        // Sessions are only revived once a client asks for them
+        for (const auto& session : journal.sessions())
+        {
+            restorable[session.key] = session;
+            if (not session.name.empty())
+                fixed_session_store[session.name] = session.key;
+            next_session_key = std::max<unsigned int>(next_session_key, session.key + 1);
+        }
+
         object->install_method_handler<mpris::Service::CreateSession>(
                     std::bind(
                         &Private::handle_create_session,
@@ -74,17 +97,35 @@ struct media::ServiceSkeleton::Private
                         this,
                         std::placeholders::_1));
         object->install_method_handler<mpris::Service::PauseOtherSessions>(
-                    std::bind(
+                    metrics::timed("dbus.Service.PauseOtherSessions_us", std::bind(
                         &Private::handle_pause_other_sessions,
                         this,
+                        std::placeholders::_1)));
+        object->install_method_handler<mpris::Service::SavePlaylist>(
+                    metrics::timed("dbus.Service.SavePlaylist_us", std::bind(
+                        &Private::handle_save_playlist,
+                        this,
+                        std::placeholders::_1)));
+        object->install_method_handler<mpris::Service::Stats::GetMetrics>(
+                    std::bind(
+                        &Private::handle_get_metrics,
+                        this,
+                        std::placeholders::_1));
+        object->install_method_handler<mpris::Service::Stats::SetTracing>(
+                    std::bind(
+                        &Private::handle_set_tracing,
+                        this,
+                        std::placeholders::_1));
+        object->install_method_handler<mpris::Service::Stats::DumpTrace>(
+                    std::bind(
+                        &Private::handle_dump_trace,
+                        this,
                         std::placeholders::_1));
     }
 
     std::pair<std::string, media::Player::PlayerKey> create_session_info()
     {
-        static unsigned int session_counter = 0;
-
-        unsigned int current_session = session_counter++;
+        unsigned int current_session = next_session_key++;
 
         std::stringstream ss;
         ss << "/core/ubuntu/media/Service/sessions/" << current_session;
@@ -94,13 +135,19 @@ struct media::ServiceSkeleton::Private
 
     void handle_create_session(const core::dbus::Message::Ptr& msg)
     {
+        MH_TRACE_SCOPE("dbus", "Service.CreateSession");
+        const auto received = std::chrono::steady_clock::now();
         auto  session_info = create_session_info();
 
         dbus::types::ObjectPath op{session_info.first};
         media::Player::PlayerKey key{session_info.second};
 
-        dbus_stub.get_connection_app_armor_security_async(msg->sender(), [this, msg, op, key](const std::string& profile)
+        dbus_stub.get_connection_app_armor_security_async(msg->sender(), [this, msg, op, key, received](const std::string& profile)
         {
+            // Covers the access check, the reply is sent from here
+            static auto& latency = metrics::histogram("dbus.Service.CreateSession_us");
+            metrics::ScopedTimer timer{latency, received};
+
             media::Player::Configuration config
             {
                 profile,
@@ -120,11 +167,19 @@ struct media::ServiceSkeleton::Private
                 if (!inserted)
                     throw std::runtime_error("Problem persisting session in session store.");
 
+                watch_session(key, std::string{}, session);
 
                 auto reply = dbus::Message::make_method_return(msg);
                 reply->writer() << op;
 
                 impl->access_bus()->send(reply);
+
+                std::call_once(first_session_served, []()
+                {
+                    const auto elapsed = metrics::time_since_process_start();
+                    metrics::gauge("startup.first_create_session_us").set(elapsed.count());
+                    MH_INFO("First session served " << elapsed.count() / 1000 << "ms after start");
+                });
             } catch(const std::runtime_error& e)
             {
                 auto reply = dbus::Message::make_error(
@@ -138,8 +193,13 @@ struct media::ServiceSkeleton::Private
 
     void handle_create_fixed_session(const core::dbus::Message::Ptr& msg)
     {
-        dbus_stub.get_connection_app_armor_security_async(msg->sender(), [this, msg](const std::string& profile)
+        MH_TRACE_SCOPE("dbus", "Service.CreateFixedSession");
+        const auto received = std::chrono::steady_clock::now();
+        dbus_stub.get_connection_app_armor_security_async(msg->sender(), [this, msg, received](const std::string& profile)
         {
+            static auto& latency = metrics::histogram("dbus.Service.CreateFixedSession_us");
+            metrics::ScopedTimer timer{latency, received};
+
             try
             {
                 std::string name;
@@ -171,6 +231,7 @@ struct media::ServiceSkeleton::Private
                         throw std::runtime_error("Problem persisting session in session store.");
 
                     fixed_session_store.insert(std::make_pair(name, key));
+                    watch_session(key, name, session);
 
                     auto reply = dbus::Message::make_method_return(msg);
                     reply->writer() << op;
@@ -180,7 +241,7 @@ struct media::ServiceSkeleton::Private
                 else {
                     // Resume previous session
                     auto key = fixed_session_store[name];
-                    if (session_store.count(key) == 0) {
+                    if (session_store.count(key) == 0 && not restore_session(key, profile)) {
                         auto reply = dbus::Message::make_error(
                                     msg,
                                     mpris::Service::Errors::CreatingFixedSession::name(),
@@ -211,14 +272,19 @@ struct media::ServiceSkeleton::Private
 
     void handle_resume_session(const core::dbus::Message::Ptr& msg)
     {
-        dbus_stub.get_connection_app_armor_security_async(msg->sender(), [this, msg](const std::string&)
+        MH_TRACE_SCOPE("dbus", "Service.ResumeSession");
+        const auto received = std::chrono::steady_clock::now();
+        dbus_stub.get_connection_app_armor_security_async(msg->sender(), [this, msg, received](const std::string& profile)
         {
+            static auto& latency = metrics::histogram("dbus.Service.ResumeSession_us");
+            metrics::ScopedTimer timer{latency, received};
+
             try
             {
                 Player::PlayerKey key;
                 msg->reader() >> key;
 
-                if (session_store.count(key) == 0) {
+                if (session_store.count(key) == 0 && not restore_session(key, profile)) {
                     auto reply = dbus::Message::make_error(
                                 msg,
                                 mpris::Service::Errors::ResumingSession::name(),
@@ -246,9 +312,143 @@ struct media::ServiceSkeleton::Private
         });
     }
 
+    // Checkpoints the session to the journal whenever it changes while resumable
+    void watch_session(media::Player::PlayerKey key, const std::string& name, const std::shared_ptr<media::Player>& session)
+    {
+        std::weak_ptr<media::Player> weak_session{session};
+
+        // Invoked on whichever thread reports the change, the D-Bus thread
+        // as well as streaming threads and the fan-out workers. The track
+        // list hands out a consistent copy of its uris, the journal's writer
+        // only ever gets to see that copy.
+        auto checkpoint = [this, weak_session, key, name]()
+        {
+            auto player = std::dynamic_pointer_cast<media::PlayerImplementation>(weak_session.lock());
+            if (not player || player->lifetime().get() != media::Player::Lifetime::resumable)
+                return;
+
+            try
+            {
+                media::SessionJournal::Session s;
+                s.key = key;
+                s.name = name;
+                s.uri = player->uri();
+                // The engine reports nanoseconds
+                s.position = std::chrono::microseconds{player->position().get() / 1000};
+                s.tracks = player->track_uris();
+                s.role = player->audio_stream_role().get();
+                s.volume = player->volume().get();
+                journal.checkpoint(s);
+            } catch (const std::exception& e)
+            {
+                MH_WARNING("Not checkpointing session " << key << ": " << e.what());
+            }
+        };
+
+        auto& connections = session_connections[key];
+        connections.clear();
+
+        connections.emplace_back(session->lifetime().changed().connect([this, key, checkpoint](media::Player::Lifetime lifetime)
+        {
+            if (lifetime == media::Player::Lifetime::resumable)
+                checkpoint();
+            else
+                journal.forget(key);
+        }));
+        connections.emplace_back(session->playback_status_changed().connect([checkpoint](media::Player::PlaybackStatus)
+        {
+            checkpoint();
+        }));
+        connections.emplace_back(session->seeked_to().connect([checkpoint](int64_t)
+        {
+            checkpoint();
+        }));
+        connections.emplace_back(session->volume().changed().connect([checkpoint](media::Player::Volume)
+        {
+            checkpoint();
+        }));
+        connections.emplace_back(session->audio_stream_role().changed().connect([checkpoint](media::Player::AudioStreamRole)
+        {
+            checkpoint();
+        }));
+
+        auto track_list = session->track_list();
+        connections.emplace_back(track_list->on_track_list_replaced().connect([checkpoint]()
+        {
+            checkpoint();
+        }));
+        connections.emplace_back(track_list->on_track_added().connect([checkpoint](const media::Track::Id&)
+        {
+            checkpoint();
+        }));
+        connections.emplace_back(track_list->on_track_removed().connect([checkpoint](const media::Track::Id&)
+        {
+            checkpoint();
+        }));
+        connections.emplace_back(track_list->on_track_changed().connect([checkpoint](const media::Track::Id&)
+        {
+            checkpoint();
+        }));
+
+        checkpoint();
+    }
+
+    // Brings back a session recorded in the journal under its previous key.
+    // The pipeline is only built once the client starts playback.
+    bool restore_session(media::Player::PlayerKey key, const std::string& profile)
+    {
+        auto it = restorable.find(key);
+        if (it == restorable.end())
+            return false;
+
+        MH_TRACE_SCOPE("service", "restore_session");
+
+        const auto checkpoint = it->second;
+        restorable.erase(it);
+
+        std::stringstream ss;
+        ss << "/core/ubuntu/media/Service/sessions/" << key;
+        dbus::types::ObjectPath op{ss.str()};
+
+        media::Player::Configuration config
+        {
+            profile,
+            key,
+            impl->access_bus(),
+            impl->access_service()->add_object_for_path(op)
+        };
+
+        auto session = impl->create_session(config);
+        session->lifetime().set(media::Player::Lifetime::resumable);
+        session->audio_stream_role().set(checkpoint.role);
+        session->volume().set(checkpoint.volume);
+
+        if (not checkpoint.tracks.empty())
+            session->track_list()->add_tracks_with_uri_at(checkpoint.tracks, media::TrackList::after_empty_track());
+
+        auto player = std::dynamic_pointer_cast<media::PlayerImplementation>(session);
+        if (player && not checkpoint.uri.empty())
+            player->restore_uri(checkpoint.uri, checkpoint.position);
+
+        bool inserted = false;
+        std::tie(std::ignore, inserted)
+                = session_store.insert(std::make_pair(key, session));
+
+        if (!inserted)
+            throw std::runtime_error("Problem persisting session in session store.");
+
+        watch_session(key, checkpoint.name, session);
+
+        metrics::counter("service.sessions_restored").increment();
+        MH_DEBUG("Restored session " << key << " at " << checkpoint.uri);
+
+        return true;
+    }
+
     void handle_pause_other_sessions(const core::dbus::Message::Ptr& msg)
     {
-        std::cout << __PRETTY_FUNCTION__ << std::endl;
+        MH_TRACE_SCOPE("dbus", "Service.PauseOtherSessions");
+        MH_DEBUG(__PRETTY_FUNCTION__);
         Player::PlayerKey key;
         msg->reader() >> key;
         impl->pause_other_sessions(key);
@@ -257,6 +457,79 @@ struct media::ServiceSkeleton::Private
         impl->access_bus()->send(reply);
     }
 
+    void handle_save_playlist(const core::dbus::Message::Ptr& msg)
+    {
+        MH_TRACE_SCOPE("dbus", "Service.SavePlaylist");
+        Player::PlayerKey key; std::string name;
+        msg->reader() >> key >> name;
+
+        std::vector<media::Track::UriType> uris;
+        auto it = session_store.find(key);
+        if (it != session_store.end())
+        {
+            if (auto player = std::dynamic_pointer_cast<media::PlayerImplementation>(it->second))
+                uris = player->track_uris();
+        }
+
+        if (uris.empty())
+        {
+            auto reply = dbus::Message::make_error(
+                        msg,
+                        mpris::Service::Errors::SavingPlaylist::name(),
+                        "No such session or no tracks to save");
+            impl->access_bus()->send(reply);
+            return;
+        }
+
+        try
+        {
+            auto id = exported.playlist_store.create(name, uris);
+            exported.playlists.properties.playlist_count->set(exported.playlist_store.count());
+
+            auto reply = dbus::Message::make_method_return(msg);
+            reply->writer() << Exported::path_for_playlist(id);
+            impl->access_bus()->send(reply);
+        } catch (const std::runtime_error& e)
+        {
+            MH_WARNING("Could not save playlist " << name << ": " << e.what());
+            auto reply = dbus::Message::make_error(
+                        msg,
+                        mpris::Service::Errors::SavingPlaylist::name(),
+                        e.what());
+            impl->access_bus()->send(reply);
+        }
+    }
+
+    void handle_get_metrics(const core::dbus::Message::Ptr& msg)
+    {
+        auto reply = dbus::Message::make_method_return(msg);
+        reply->writer() << metrics::Registry::instance().snapshot();
+        impl->access_bus()->send(reply);
+    }
+
+    // Enabling starts a new capture. Replies whether trace points are
+    // compiled in at all.
+    void handle_set_tracing(const core::dbus::Message::Ptr& msg)
+    {
+        bool enabled;
+        msg->reader() >> enabled;
+        // Every capture starts out empty
+        if (enabled && !media::trace::is_enabled())
+            media::trace::clear();
+        media::trace::set_enabled(enabled);
+
+        auto reply = dbus::Message::make_method_return(msg);
+        reply->writer() << media::trace::is_available();
+        impl->access_bus()->send(reply);
+    }
+
+    void handle_dump_trace(const core::dbus::Message::Ptr& msg)
+    {
+        auto reply = dbus::Message::make_method_return(msg);
+        reply->writer() << media::trace::to_chrome_json();
+        impl->access_bus()->send(reply);
+    }
+
     media::ServiceSkeleton* impl;
     dbus::Object::Ptr object;
 
@@ -265,6 +538,14 @@ struct media::ServiceSkeleton::Private
     // We track all running player instances.
     std::map<media::Player::PlayerKey, std::shared_ptr<media::Player>> session_store;
     std::map<std::string, media::Player::PlayerKey> fixed_session_store;
+    std::once_flag first_session_served;
+    // Resumable sessions survive restarts of the service via the journal.
+    // Declared after the session store, such that pending checkpoints are
+    // written while the players are still around.
+    media::SessionJournal journal;
+    std::map<media::Player::PlayerKey, media::SessionJournal::Session> restorable;
+    std::map<media::Player::PlayerKey, std::vector<core::ScopedConnection>> session_connections;
+    std::atomic<unsigned int> next_session_key;
     // We expose the entire service as an MPRIS player.
     struct Exported
     {
@@ -398,6 +679,117 @@ struct media::ServiceSkeleton::Private
                 Exported::bus->send(core::dbus::Message::make_method_return(msg));
             };
             object->install_method_handler<mpris::Player::PlayPause>(play_pause);
+
+            // Setup method handlers for mpris::Playlists methods.
+            playlists.properties.orderings->set(
+            {
+                mpris::Playlists::Orderings::alphabetical,
+                mpris::Playlists::Orderings::creation_date,
+                mpris::Playlists::Orderings::modified_date,
+                mpris::Playlists::Orderings::last_play_date
+            });
+            playlists.properties.playlist_count->set(playlist_store.count());
+
+            auto get_playlists = [this](const core::dbus::Message::Ptr& msg)
+            {
+                MH_TRACE_SCOPE("dbus", "Playlists.GetPlaylists");
+                std::uint32_t index, max_count; std::string order; bool reverse;
+                msg->reader() >> index >> max_count >> order >> reverse;
+
+                std::vector<mpris::Playlists::Playlist> result;
+                for (const auto& p : playlist_store.playlists(index, max_count, ordering_for(order), reverse))
+                    result.push_back(mpris::Playlists::Playlist{std::make_tuple(path_for_playlist(p.id), p.name, p.icon)});
+
+                auto reply = core::dbus::Message::make_method_return(msg);
+                reply->writer() << result;
+                Exported::bus->send(reply);
+            };
+            object->install_method_handler<mpris::Playlists::Methods::GetPlaylists>(get_playlists);
+
+            auto activate_playlist = [this](const core::dbus::Message::Ptr& msg)
+            {
+                MH_TRACE_SCOPE("dbus", "Playlists.ActivatePlaylist");
+                dbus::types::ObjectPath path; msg->reader() >> path;
+
+                media::PlaylistStore::Id id{0};
+                std::vector<media::Track::UriType> uris;
+                try
+                {
+                    if (playlist_for_path(path, id))
+                        uris = playlist_store.tracks(id);
+                } catch (const std::runtime_error& e)
+                {
+                    MH_WARNING("Could not read playlist " << path.as_string() << ": " << e.what());
+                    Exported::bus->send(core::dbus::Message::make_error(
+                                            msg,
+                                            mpris::Playlists::Errors::Failed::name(),
+                                            e.what()));
+                    return;
+                }
+
+                auto sp = current_player.lock();
+                if (not sp || uris.empty())
+                {
+                    Exported::bus->send(core::dbus::Message::make_error(
+                                            msg,
+                                            mpris::Playlists::Errors::UnknownPlaylist::name(),
+                                            "No such playlist or no player to activate it on: " + path.as_string()));
+                    return;
+                }
+
+                // The first track becomes the current one, such that playback
+                // continues from there. The rest goes in as one bulk insertion,
+                // meta data is extracted as tracks are queried.
+                auto track_list = sp->track_list();
+                track_list->add_track_with_uri_at(uris.front(), media::TrackList::after_empty_track(), true);
+                track_list->add_tracks_with_uri_at(
+                            std::vector<media::Track::UriType>(std::next(uris.begin()), uris.end()),
+                            media::TrackList::after_empty_track());
+                sp->open_uri(uris.front());
+                sp->play();
+
+                // Playback has started, only the last play date is lost
+                try
+                {
+                    playlist_store.mark_played(id);
+                } catch (const std::runtime_error& e)
+                {
+                    MH_WARNING("Could not mark playlist " << path.as_string() << " as played: " << e.what());
+                }
+
+                Exported::bus->send(core::dbus::Message::make_method_return(msg));
+            };
+            object->install_method_handler<mpris::Playlists::Methods::ActivatePlaylist>(activate_playlist);
+        }
+
+        static media::PlaylistStore::Ordering ordering_for(const std::string& order)
+        {
+            if (order == mpris::Playlists::Orderings::creation_date)
+                return media::PlaylistStore::Ordering::creation_date;
+            if (order == mpris::Playlists::Orderings::modified_date)
+                return media::PlaylistStore::Ordering::modified_date;
+            if (order == mpris::Playlists::Orderings::last_play_date)
+                return media::PlaylistStore::Ordering::last_play_date;
+
+            return media::PlaylistStore::Ordering::alphabetical;
+        }
+
+        static dbus::types::ObjectPath path_for_playlist(media::PlaylistStore::Id id)
+        {
+            return dbus::types::ObjectPath{"/core/ubuntu/media/Service/playlists/" + std::to_string(id)};
+        }
+
+        static bool playlist_for_path(const dbus::types::ObjectPath& path, media::PlaylistStore::Id& id)
+        {
+            static const std::regex re{"^/core/ubuntu/media/Service/playlists/([0-9]+)$"};
+
+            std::smatch match;
+            const auto s = path.as_string();
+            if (not std::regex_match(s, match, re))
+                return false;
+
+            id = std::stoull(match[1].str());
+            return true;
         }
 
         void set_current_player(const std::shared_ptr<media::Player>& cp)
@@ -438,36 +830,85 @@ struct media::ServiceSkeleton::Private
 
             connections.meta_data_changed = cp->meta_data_for_current_track().changed().connect([this](const core::ubuntu::media::Track::MetaData& md)
             {
-                mpris::Player::Dictionary dict;
-
-                bool has_title = md.count(xesam::Title::name) > 0;
-                bool has_album_name = md.count(xesam::Album::name) > 0;
-                bool has_artist_name = md.count(xesam::Artist::name) > 0;
-
-                if (has_title)
-                    dict[xesam::Title::name] = dbus::types::Variant::encode(md.get(xesam::Title::name));
-                if (has_album_name)
-                    dict[xesam::Album::name] = dbus::types::Variant::encode(md.get(xesam::Album::name));
-                if (has_artist_name)
-                    dict[xesam::Artist::name] = dbus::types::Variant::encode(md.get(xesam::Artist::name));
-
-                dict[mpris::metadata::ArtUrl::name] = dbus::types::Variant::encode(
-                            cover_art_resolver(
-                                has_title ? md.get(xesam::Title::name) : "",
-                                has_album_name ? md.get(xesam::Album::name) : "",
-                                has_artist_name ? md.get(xesam::Artist::name) : ""));
-
-                mpris::Player::Dictionary wrap;
-                wrap[mpris::Player::Properties::Metadata::name()] = dbus::types::Variant::encode(dict);
-
-                player.signals.properties_changed->emit(
-                            std::make_tuple(
-                                dbus::traits::Service<mpris::Player::Properties::Metadata::Interface>::interface_name(),
-                                wrap,
-                                std::vector<std::string>()));
+                on_meta_data_changed(md);
             });
         }
 
+        // Tag messages arrive many times per track, only changes of what
+        // MPRIS clients actually see are emitted.
+        void on_meta_data_changed(const core::ubuntu::media::Track::MetaData& md)
+        {
+            static auto& emitted = metrics::counter("exported.metadata_emitted");
+            static auto& skipped = metrics::counter("exported.metadata_skipped");
+
+            const std::string title = md.count(xesam::Title::name) > 0 ? md.get(xesam::Title::name) : "";
+            const std::string album = md.count(xesam::Album::name) > 0 ? md.get(xesam::Album::name) : "";
+            const std::string artist = md.count(xesam::Artist::name) > 0 ? md.get(xesam::Artist::name) : "";
+
+            std::map<std::string, std::string> visible;
+            if (md.count(xesam::Title::name) > 0)
+                visible[xesam::Title::name] = title;
+            if (md.count(xesam::Album::name) > 0)
+                visible[xesam::Album::name] = album;
+            if (md.count(xesam::Artist::name) > 0)
+                visible[xesam::Artist::name] = artist;
+
+            {
+                std::lock_guard<std::mutex> lg(metadata.guard);
+
+                // Art found during extraction wins, the resolver only ever
+                // consults memory so this handler never blocks.
+                if (md.count(mpris::metadata::ArtUrl::name) > 0)
+                    visible[mpris::metadata::ArtUrl::name] = md.get(mpris::metadata::ArtUrl::name);
+                else
+                    visible[mpris::metadata::ArtUrl::name] = resolve_cover_art(title, album, artist);
+
+                if (visible == metadata.last_emitted)
+                {
+                    skipped.increment();
+                    return;
+                }
+
+                metadata.last_emitted = visible;
+            }
+
+            mpris::Player::Dictionary dict;
+            for (const auto& pair : visible)
+                dict[pair.first] = dbus::types::Variant::encode(pair.second);
+
+            mpris::Player::Dictionary wrap;
+            wrap[mpris::Player::Properties::Metadata::name()] = dbus::types::Variant::encode(dict);
+
+            player.signals.properties_changed->emit(
+                        std::make_tuple(
+                            dbus::traits::Service<mpris::Player::Properties::Metadata::Interface>::interface_name(),
+                            wrap,
+                            std::vector<std::string>()));
+            emitted.increment();
+        }
+
+        // Memoizes cover_art_resolver per (title, album, artist), expects
+        // metadata.guard to be held. The missing art placeholder is handed
+        // out while the real art is still being looked for, and is asked
+        // for again the next time.
+        std::string resolve_cover_art(const std::string& title, const std::string& album, const std::string& artist)
+        {
+            static constexpr std::size_t max_resolved_cover_art{128};
+
+            const auto key = std::make_tuple(title, album, artist);
+            auto it = metadata.resolved_cover_art.find(key);
+            if (it != metadata.resolved_cover_art.end())
+                return it->second;
+
+            if (metadata.resolved_cover_art.size() >= max_resolved_cover_art)
+                metadata.resolved_cover_art.clear();
+
+            auto url = cover_art_resolver(title, album, artist);
+            if (url != missing_cover_art(title, album, artist))
+                metadata.resolved_cover_art[key] = url;
+            return url;
+        }
+
         void unset_current_player()
         {
             current_player.reset();
@@ -480,6 +921,13 @@ struct media::ServiceSkeleton::Private
             connections.loop_status_changed.disconnect();
             connections.meta_data_changed.disconnect();
 
+            // A new player announces its meta data afresh.
+            {
+                std::lock_guard<std::mutex> lg(metadata.guard);
+                metadata.last_emitted.clear();
+                metadata.resolved_cover_art.clear();
+            }
+
             // And announce that we cannot be controlled anymore.
             player.properties.can_control->set(false);
         }
@@ -497,9 +945,19 @@ struct media::ServiceSkeleton::Private
         mpris::MediaPlayer2::Skeleton media_player;
         mpris::Player::Skeleton player;
         mpris::Playlists::Skeleton playlists;
+        // Backs the Playlists interface
+        media::PlaylistStore playlist_store;
 
         // Helper to resolve (title, artist, album) tuples to cover art.
         media::CoverArtResolver cover_art_resolver;
+        media::CoverArtResolver missing_cover_art{media::always_missing_cover_art_resolver()};
+        // What we last told MPRIS clients about the current track.
+        struct
+        {
+            std::mutex guard;
+            std::map<std::string, std::string> last_emitted;
+            std::map<std::tuple<std::string, std::string, std::string>, std::string> resolved_cover_art;
+        } metadata;
         // The actual player instance.
         std::weak_ptr<media::Player> current_player;
         // We track event connections.
@@ -537,6 +995,10 @@ media::ServiceSkeleton::ServiceSkeleton(const media::CoverArtResolver& resolver)
     : dbus::Skeleton<media::Service>(the_session_bus()),
       d(new Private(this, resolver))
 {
+    // Both the service and the mpris names have been requested at this point
+    const auto elapsed = metrics::time_since_process_start();
+    metrics::gauge("startup.bus_name_acquired_us").set(elapsed.count());
+    MH_INFO("Bus name acquired " << elapsed.count() / 1000 << "ms after start");
 }
 
 media::ServiceSkeleton::~ServiceSkeleton()
@@ -574,6 +1036,8 @@ void media::ServiceSkeleton::remove_player_for_key(const media::Player::PlayerKe
 
     auto player = player_for_key(key);
 
+    d->session_connections.erase(key);
+    d->journal.forget(key);
     d->session_store.erase(key);
     d->exported.unset_if_current(player);
     // All non-durable fixed sessions are also removed
@@ -48,7 +48,7 @@ public:
         )
     > PlayerEnumerator;
 
-    ServiceSkeleton(const CoverArtResolver& cover_art_resolver = always_missing_cover_art_resolver());
+    ServiceSkeleton(const CoverArtResolver& cover_art_resolver = cached_cover_art_resolver());
     ~ServiceSkeleton();
 
     // We keep track of all known player sessions here and render them accessible via
@@ -19,11 +19,15 @@
 #include "service_stub.h"
 #include "service_traits.h"
 
+#include "logger.h"
 #include "player_stub.h"
 #include "the_session_bus.h"
 
 #include "mpris/service.h"
 
+#include <future>
+#include <stdexcept>
+
 namespace dbus = core::dbus;
 namespace media = core::ubuntu::media;
 
@@ -70,6 +74,34 @@ std::shared_ptr<media::Player> media::ServiceStub::create_session(const media::P
     });
 }
 
+std::future<std::shared_ptr<media::Player>> media::ServiceStub::create_session_async(const media::Player::Configuration&)
+{
+    auto promise = std::make_shared<std::promise<dbus::types::ObjectPath>>();
+    std::shared_future<dbus::types::ObjectPath> path{promise->get_future()};
+
+    d->object->invoke_method_asynchronously_with_callback<mpris::Service::CreateSession, dbus::types::ObjectPath>(
+                [promise](const dbus::Result<dbus::types::ObjectPath>& result)
+                {
+                    if (result.is_error())
+                        promise->set_exception(std::make_exception_ptr(
+                                std::runtime_error("Problem creating session: " + result.error().print())));
+                    else
+                        promise->set_value(result.value());
+                });
+
+    // Setting up the stub does blocking calls, which must not happen on the
+    // bus thread delivering the reply. It is done by whoever waits instead.
+    auto self = std::static_pointer_cast<media::ServiceStub>(shared_from_this());
+    return std::async(std::launch::deferred, [self, path]()
+    {
+        return std::shared_ptr<media::Player>(new media::PlayerStub
+        {
+            self,
+            self->access_service()->object_for_path(path.get())
+        });
+    });
+}
+
 std::shared_ptr<media::Player> media::ServiceStub::create_fixed_session(const std::string& name, const media::Player::Configuration&)
 {
     auto op = d->object->invoke_method_synchronously<mpris::Service::CreateFixedSession,
@@ -102,10 +134,28 @@ std::shared_ptr<media::Player> media::ServiceStub::resume_session(media::Player:
 
 void media::ServiceStub::pause_other_sessions(media::Player::PlayerKey key)
 {
-    std::cout << __PRETTY_FUNCTION__ << std::endl;
+    MH_DEBUG(__PRETTY_FUNCTION__);
     auto op = d->object->invoke_method_synchronously<mpris::Service::PauseOtherSessions,
          void>(key);
 
     if (op.is_error())
         throw std::runtime_error("Problem pausing other sessions: " + op.error());
 }
+
+std::future<void> media::ServiceStub::pause_other_sessions_async(media::Player::PlayerKey key)
+{
+    MH_DEBUG(__PRETTY_FUNCTION__);
+    auto promise = std::make_shared<std::promise<void>>();
+
+    d->object->invoke_method_asynchronously_with_callback<mpris::Service::PauseOtherSessions, void>(
+                [promise](const dbus::Result<void>& result)
+                {
+                    if (result.is_error())
+                        promise->set_exception(std::make_exception_ptr(
+                                std::runtime_error("Problem pausing other sessions: " + result.error().print())));
+                    else
+                        promise->set_value();
+                }, key);
+
+    return promise->get_future();
+}
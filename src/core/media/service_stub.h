@@ -44,6 +44,9 @@ class ServiceStub : public core::dbus::Stub<core::ubuntu::media::Service>
     std::shared_ptr<Player> resume_session(Player::PlayerKey key);
     void pause_other_sessions(Player::PlayerKey key);
 
+    std::future<std::shared_ptr<Player>> create_session_async(const Player::Configuration&);
+    std::future<void> pause_other_sessions_async(Player::PlayerKey key);
+
   private:
     struct Private;
     std::unique_ptr<Private> d;
@@ -0,0 +1,311 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "session_journal.h"
+
+#include "logger.h"
+#include "metrics.h"
+
+#include <boost/filesystem.hpp>
+
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace media = core::ubuntu::media;
+
+namespace
+{
+// "MHSJ" followed by the format version
+constexpr std::uint32_t magic{0x4d48534a};
+constexpr std::uint32_t version{1};
+
+template<typename T>
+void write(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void write(std::ostream& out, const std::string& value)
+{
+    write(out, static_cast<std::uint32_t>(value.size()));
+    out.write(value.data(), value.size());
+}
+
+template<typename T>
+void read(std::istream& in, T& value)
+{
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(value)))
+        throw std::runtime_error("Truncated session journal");
+}
+
+void read(std::istream& in, std::string& value)
+{
+    std::uint32_t size; read(in, size);
+    value.resize(size);
+    if (!in.read(&value[0], size))
+        throw std::runtime_error("Truncated session journal");
+}
+}
+
+struct media::SessionJournal::Private
+{
+    typedef std::map<Player::PlayerKey, Session> Sessions;
+
+    Private(const std::string& path, const std::chrono::milliseconds& interval)
+        : path(path),
+          interval(interval),
+          stopping(false),
+          writes(metrics::counter("journal.writes")),
+          failures(metrics::counter("journal.write_failures")),
+          latency(metrics::histogram("journal.write_us"))
+    {
+    }
+
+    void load()
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return;
+
+        std::uint32_t m, v; read(in, m); read(in, v);
+        if (m != magic || v != version)
+            throw std::runtime_error("Unknown session journal format");
+
+        std::uint32_t count; read(in, count);
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            Session s;
+            std::int64_t position;
+            std::int32_t role;
+            std::uint32_t track_count;
+
+            read(in, s.key);
+            read(in, position);
+            read(in, role);
+            read(in, s.volume);
+            read(in, s.name);
+            read(in, s.uri);
+            read(in, track_count);
+
+            s.position = std::chrono::microseconds{position};
+            s.role = static_cast<Player::AudioStreamRole>(role);
+            s.tracks.resize(track_count);
+            for (auto& uri : s.tracks)
+                read(in, uri);
+
+            sessions[s.key] = std::move(s);
+        }
+    }
+
+    // Written next to the journal and renamed over it, such that a crash
+    // never leaves a partial journal behind.
+    void save(const Sessions& snapshot) const
+    {
+        boost::filesystem::create_directories(boost::filesystem::path{path}.parent_path());
+
+        const auto tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            write(out, magic);
+            write(out, version);
+            write(out, static_cast<std::uint32_t>(snapshot.size()));
+
+            for (const auto& pair : snapshot)
+            {
+                const auto& s = pair.second;
+                write(out, s.key);
+                write(out, static_cast<std::int64_t>(s.position.count()));
+                write(out, static_cast<std::int32_t>(s.role));
+                write(out, s.volume);
+                write(out, s.name);
+                write(out, s.uri);
+                write(out, static_cast<std::uint32_t>(s.tracks.size()));
+                for (const auto& uri : s.tracks)
+                    write(out, uri);
+            }
+
+            if (!out.flush())
+                throw std::runtime_error("Problem writing session journal");
+        }
+
+        boost::filesystem::rename(tmp, path);
+    }
+
+    // Takes over the changed sessions and writes the result
+    void write_pending()
+    {
+        std::lock_guard<std::mutex> wl(write_guard);
+
+        Sessions snapshot;
+        {
+            std::lock_guard<std::mutex> lg(guard);
+            if (dirty.empty() && forgotten.empty())
+                return;
+
+            for (auto& pair : dirty)
+                sessions[pair.first] = std::move(pair.second);
+            dirty.clear();
+            forgotten.clear();
+
+            snapshot = sessions;
+        }
+
+        metrics::ScopedTimer timer{latency};
+
+        try
+        {
+            save(snapshot);
+            writes.increment();
+        } catch (const std::exception& e)
+        {
+            failures.increment();
+            MH_WARNING("Failed to write session journal " << path << ": " << e.what());
+        }
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> ul(guard);
+        while (true)
+        {
+            wakeup.wait(ul, [this]() { return stopping || not dirty.empty() || not forgotten.empty(); });
+            if (stopping)
+                break;
+
+            // Everything changing within the interval goes out with one write
+            wakeup.wait_for(ul, interval, [this]() { return stopping; });
+            if (stopping)
+                break;
+
+            ul.unlock();
+            write_pending();
+            ul.lock();
+        }
+    }
+
+    const std::string path;
+    const std::chrono::milliseconds interval;
+
+    mutable std::mutex guard;
+    std::condition_variable wakeup;
+    bool stopping;
+    Sessions sessions;
+    // The latest state of sessions changed since the last write
+    Sessions dirty;
+    std::set<Player::PlayerKey> forgotten;
+
+    // Serializes the writer thread and explicit flushes
+    std::mutex write_guard;
+    std::thread writer;
+
+    metrics::Counter& writes;
+    metrics::Counter& failures;
+    metrics::Histogram& latency;
+};
+
+std::string media::SessionJournal::default_path()
+{
+    if (auto path = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_SESSION_JOURNAL"))
+        return path;
+
+    if (auto xdg = ::getenv("XDG_DATA_HOME"))
+        return std::string{xdg} + "/media-hub/sessions";
+
+    auto home = ::getenv("HOME");
+    return std::string{home ? home : "/tmp"} + "/.local/share/media-hub/sessions";
+}
+
+std::chrono::milliseconds media::SessionJournal::default_interval()
+{
+    const char* value = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_CHECKPOINT_INTERVAL_MS");
+    return std::chrono::milliseconds{value != nullptr ? std::atoi(value) : 2000};
+}
+
+media::SessionJournal::SessionJournal(const std::string& path, const std::chrono::milliseconds& interval)
+    : d(new Private(path, interval))
+{
+    try
+    {
+        d->load();
+    } catch (const std::exception& e)
+    {
+        MH_WARNING("Ignoring session journal " << path << ": " << e.what());
+        d->sessions.clear();
+    }
+
+    d->writer = std::thread([this]() { d->run(); });
+}
+
+media::SessionJournal::~SessionJournal()
+{
+    {
+        std::lock_guard<std::mutex> lg(d->guard);
+        d->stopping = true;
+    }
+    d->wakeup.notify_all();
+
+    if (d->writer.joinable())
+        d->writer.join();
+
+    d->write_pending();
+}
+
+std::vector<media::SessionJournal::Session> media::SessionJournal::sessions() const
+{
+    std::lock_guard<std::mutex> lg(d->guard);
+
+    std::vector<Session> result;
+    result.reserve(d->sessions.size());
+    for (const auto& pair : d->sessions)
+        result.push_back(pair.second);
+
+    return result;
+}
+
+void media::SessionJournal::checkpoint(const media::SessionJournal::Session& session)
+{
+    {
+        std::lock_guard<std::mutex> lg(d->guard);
+        d->dirty[session.key] = session;
+        d->forgotten.erase(session.key);
+    }
+    d->wakeup.notify_all();
+}
+
+void media::SessionJournal::forget(media::Player::PlayerKey key)
+{
+    {
+        std::lock_guard<std::mutex> lg(d->guard);
+        const bool known = d->sessions.erase(key) > 0;
+        const bool changed = d->dirty.erase(key) > 0;
+        if (not known && not changed)
+            return;
+        d->forgotten.insert(key);
+    }
+    d->wakeup.notify_all();
+}
+
+void media::SessionJournal::flush()
+{
+    d->write_pending();
+}
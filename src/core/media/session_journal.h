@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CORE_UBUNTU_MEDIA_SESSION_JOURNAL_H_
+#define CORE_UBUNTU_MEDIA_SESSION_JOURNAL_H_
+
+#include <core/media/player.h>
+#include <core/media/track.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+// Persists the state of resumable sessions across restarts of the service.
+//
+// Callers hand over the state of a session whenever it changes. A writer
+// thread picks up the latest state of all changed sessions at most once per
+// interval and replaces the journal with a compact binary snapshot, such that
+// a burst of changes, e.g. enqueueing an album track by track, costs a single
+// write.
+class SessionJournal
+{
+public:
+    struct Session
+    {
+        Player::PlayerKey key;
+        // The name the session was created with via CreateFixedSession
+        std::string name;
+        Track::UriType uri;
+        std::chrono::microseconds position;
+        std::vector<Track::UriType> tracks;
+        Player::AudioStreamRole role;
+        Player::Volume volume;
+    };
+
+    // CORE_UBUNTU_MEDIA_SERVICE_SESSION_JOURNAL if set, otherwise
+    // $XDG_DATA_HOME/media-hub/sessions.
+    static std::string default_path();
+    // CORE_UBUNTU_MEDIA_SERVICE_CHECKPOINT_INTERVAL_MS, 2 seconds by default.
+    static std::chrono::milliseconds default_interval();
+
+    // Loads the sessions recorded in the journal at path.
+    explicit SessionJournal(
+            const std::string& path = default_path(),
+            const std::chrono::milliseconds& interval = default_interval());
+    SessionJournal(const SessionJournal&) = delete;
+    // Writes out pending changes.
+    ~SessionJournal();
+
+    SessionJournal& operator=(const SessionJournal&) = delete;
+
+    // All sessions known to the journal, in order of their keys.
+    std::vector<Session> sessions() const;
+
+    // Records the state of a session, replacing the one recorded before.
+    // The writer thread only ever sees this copy, never the session itself.
+    void checkpoint(const Session& session);
+    // Drops the session from the journal.
+    void forget(Player::PlayerKey key);
+    // Samples all changed sessions and writes the journal right away.
+    void flush();
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+}
+}
+}
+
+#endif // CORE_UBUNTU_MEDIA_SESSION_JOURNAL_H_
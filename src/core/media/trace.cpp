@@ -0,0 +1,308 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace trace = core::ubuntu::media::trace;
+
+namespace
+{
+struct Event
+{
+    const char* category;
+    const char* name;
+    char phase;
+    std::uint64_t ts;
+    std::uint64_t dur;
+};
+
+// Only the owning thread writes to a ring. The lock is uncontended
+// except for the rare moment the trace is dumped or cleared.
+struct Ring
+{
+    Ring() : tid(::syscall(SYS_gettid)), next(0), wrapped(false)
+    {
+        events.resize(trace::ring_capacity);
+    }
+
+    void push(const Event& event)
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        events[next] = event;
+        if (++next == events.size())
+        {
+            next = 0;
+            wrapped = true;
+        }
+    }
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        next = 0;
+        wrapped = false;
+    }
+
+    long tid;
+    std::mutex guard;
+    std::vector<Event> events;
+    std::size_t next;
+    bool wrapped;
+};
+
+// Rings outlive their threads, such that the events of exited threads
+// still end up in the trace. The ring of an exited thread is kept intact
+// until its events were dumped or cleared, then it is handed to the next
+// thread that starts tracing. At most max_retired_rings are kept around,
+// the oldest ones are dropped first.
+struct Rings
+{
+    // Never destroyed, threads might exit after static destruction
+    static Rings& instance()
+    {
+        static auto rings = new Rings();
+        return *rings;
+    }
+
+    std::shared_ptr<Ring> acquire()
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        std::shared_ptr<Ring> ring;
+        if (!spare.empty())
+        {
+            ring = spare.back();
+            spare.pop_back();
+            ring->reset();
+            std::lock_guard<std::mutex> rlg(ring->guard);
+            ring->tid = ::syscall(SYS_gettid);
+        }
+        else
+            ring = std::make_shared<Ring>();
+
+        rings.push_back(ring);
+        return ring;
+    }
+
+    void retire(const std::shared_ptr<Ring>& ring)
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        retired.push_back(ring);
+        if (retired.size() > trace::max_retired_rings)
+        {
+            recycle(retired.front());
+            retired.erase(retired.begin());
+        }
+    }
+
+    // All rings, the ones of exited threads are also put into exited
+    std::vector<std::shared_ptr<Ring>> all(std::vector<std::shared_ptr<Ring>>& exited)
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        exited = retired;
+        return rings;
+    }
+
+    // The events of the given rings of exited threads made it into a dump
+    void release(const std::vector<std::shared_ptr<Ring>>& dumped)
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        for (const auto& ring : dumped)
+        {
+            auto it = std::find(retired.begin(), retired.end(), ring);
+            if (it == retired.end())
+                continue;
+            retired.erase(it);
+            recycle(ring);
+        }
+    }
+
+    // Rings of exited threads are released, the others emptied
+    void clear()
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        for (const auto& ring : retired)
+            recycle(ring);
+        retired.clear();
+
+        for (const auto& ring : rings)
+            ring->reset();
+    }
+
+    // Takes a ring of an exited thread out of the trace. Must be called
+    // with guard held.
+    void recycle(const std::shared_ptr<Ring>& ring)
+    {
+        rings.erase(std::remove(rings.begin(), rings.end(), ring), rings.end());
+        if (spare.size() < trace::max_retired_rings)
+            spare.push_back(ring);
+    }
+
+    std::mutex guard;
+    // Rings in the trace, of running and exited threads
+    std::vector<std::shared_ptr<Ring>> rings;
+    // Rings of exited threads still in the trace, oldest first
+    std::vector<std::shared_ptr<Ring>> retired;
+    // Rings of exited threads out of the trace, ready for reuse
+    std::vector<std::shared_ptr<Ring>> spare;
+};
+
+// Hands the ring back once the thread exits
+struct ThreadRing
+{
+    ThreadRing() : ring(Rings::instance().acquire())
+    {
+    }
+
+    ~ThreadRing()
+    {
+        Rings::instance().retire(ring);
+    }
+
+    std::shared_ptr<Ring> ring;
+};
+
+Ring& this_thread_ring()
+{
+    static thread_local ThreadRing thread_ring;
+    return *thread_ring.ring;
+}
+
+void write_escaped(std::ostream& out, const char* s)
+{
+    out << '"';
+    for (; *s; ++s)
+    {
+        switch (*s)
+        {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        default:
+            if (static_cast<unsigned char>(*s) < 0x20)
+                out << ' ';
+            else
+                out << *s;
+        }
+    }
+    out << '"';
+}
+}
+
+std::atomic<bool> trace::detail::enabled{std::getenv("CORE_UBUNTU_MEDIA_SERVICE_TRACING") != nullptr};
+
+void trace::set_enabled(bool value)
+{
+    detail::enabled.store(value, std::memory_order_relaxed);
+}
+
+bool trace::is_available()
+{
+#if defined(MEDIA_HUB_ENABLE_TRACING)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void trace::complete(const char* category, const char* name, std::uint64_t start, std::uint64_t end)
+{
+    this_thread_ring().push(Event{category, name, 'X', start, end - start});
+}
+
+void trace::instant(const char* category, const char* name)
+{
+    this_thread_ring().push(Event{category, name, 'i', now(), 0});
+}
+
+void trace::clear()
+{
+    Rings::instance().clear();
+}
+
+std::string trace::to_chrome_json()
+{
+    const auto pid = ::getpid();
+
+    std::stringstream out;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    std::vector<std::shared_ptr<Ring>> exited;
+    const auto rings = Rings::instance().all(exited);
+
+    bool first = true;
+    for (const auto& ring : rings)
+    {
+        std::lock_guard<std::mutex> lg(ring->guard);
+
+        const std::size_t begin = ring->wrapped ? ring->next : 0;
+        const std::size_t count = ring->wrapped ? ring->events.size() : ring->next;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const auto& event = ring->events[(begin + i) % ring->events.size()];
+
+            if (!first)
+                out << ',';
+            first = false;
+
+            out << "{\"name\":";
+            write_escaped(out, event.name);
+            out << ",\"cat\":";
+            write_escaped(out, event.category);
+            out << ",\"ph\":\"" << event.phase << "\""
+                << ",\"ts\":" << event.ts;
+            if (event.phase == 'X')
+                out << ",\"dur\":" << event.dur;
+            else
+                out << ",\"s\":\"t\"";
+            out << ",\"pid\":" << pid << ",\"tid\":" << ring->tid << "}";
+        }
+    }
+
+    out << "]}";
+
+    // Exited threads won't add anything, their rings are free for reuse
+    Rings::instance().release(exited);
+    return out.str();
+}
+
+bool trace::dump_to_file(const std::string& path)
+{
+    const std::string tmp_path{path + ".tmp"};
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        if (!out)
+            return false;
+
+        out << to_chrome_json();
+
+        if (!out)
+            return false;
+    }
+
+    return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_UBUNTU_MEDIA_TRACE_H_
+#define CORE_UBUNTU_MEDIA_TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+namespace trace
+{
+// Every thread records into its own ring of this many events,
+// once full the oldest events are overwritten.
+static constexpr std::size_t ring_capacity = 16384;
+
+// The events of exited threads are kept until dumped or cleared, for
+// at most this many threads. Those of the earliest exited go first.
+static constexpr std::size_t max_retired_rings = 32;
+
+namespace detail
+{
+extern std::atomic<bool> enabled;
+}
+
+// Tracing starts out enabled if CORE_UBUNTU_MEDIA_SERVICE_TRACING is set
+inline bool is_enabled()
+{
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+void set_enabled(bool enabled);
+
+// Whether trace points were compiled in, see MEDIA_HUB_ENABLE_TRACING
+bool is_available();
+
+// Microseconds on the monotonic clock, the time base of all events
+inline std::uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Category and name have to outlive the trace, i.e. be string literals
+// or otherwise statically allocated.
+void complete(const char* category, const char* name, std::uint64_t start, std::uint64_t end);
+void instant(const char* category, const char* name);
+
+// Drops all recorded events
+void clear();
+
+// Serializes all recorded events in the Chrome trace event format,
+// ready to be loaded into chrome://tracing or Perfetto.
+std::string to_chrome_json();
+
+bool dump_to_file(const std::string& path);
+
+// Records the lifetime of the instance as a complete event
+class Scope
+{
+public:
+    Scope(const char* category, const char* name)
+        : category(category),
+          name(name),
+          start(is_enabled() ? now() : 0)
+    {
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    ~Scope()
+    {
+        if (start != 0)
+            complete(category, name, start, now());
+    }
+
+private:
+    const char* category;
+    const char* name;
+    std::uint64_t start;
+};
+}
+}
+}
+}
+
+#define MH_TRACE_CONCAT_IMPL(a, b) a##b
+#define MH_TRACE_CONCAT(a, b) MH_TRACE_CONCAT_IMPL(a, b)
+
+#if defined(MEDIA_HUB_ENABLE_TRACING)
+#define MH_TRACE_SCOPE(category, name) \
+    core::ubuntu::media::trace::Scope MH_TRACE_CONCAT(mh_trace_scope_, __LINE__){category, name}
+#define MH_TRACE_INSTANT(category, name) \
+    do { if (core::ubuntu::media::trace::is_enabled()) core::ubuntu::media::trace::instant(category, name); } while(0)
+#else
+#define MH_TRACE_SCOPE(category, name) static_cast<void>(0)
+#define MH_TRACE_INSTANT(category, name) static_cast<void>(0)
+#endif
+
+#endif // CORE_UBUNTU_MEDIA_TRACE_H_
@@ -30,6 +30,12 @@ media::TrackList::TrackList()
 {
 }
 
+void media::TrackList::add_tracks_with_uri_at(const std::vector<media::Track::UriType>& uris, const media::Track::Id& position)
+{
+    for (const auto& uri : uris)
+        add_track_with_uri_at(uri, position, false);
+}
+
 media::TrackList::~TrackList()
 {
 }
@@ -22,6 +22,14 @@
 #include "track_list_implementation.h"
 
 #include "engine.h"
+#include "logger.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <vector>
 
 namespace dbus = core::dbus;
 namespace media = core::ubuntu::media;
@@ -30,8 +38,20 @@ struct media::TrackListImplementation::Private
 {
     typedef std::map<Track::Id, std::tuple<Track::UriType, Track::MetaData>> MetaDataCache;
 
+    Track::Id next_track_id()
+    {
+        static size_t track_counter = 0;
+
+        std::stringstream ss; ss << path.as_string() << "/" << track_counter++;
+        return Track::Id{ss.str()};
+    }
+
     dbus::types::ObjectPath path;
+    // Guards edits of the list and the cache, signals are emitted without it
+    mutable std::mutex guard;
     MetaDataCache meta_data_cache;
+    // Tracks added in bulk, their meta data is extracted when first queried
+    std::set<Track::Id> unextracted;
     std::shared_ptr<media::Engine::MetaDataExtractor> extractor;
 };
 
@@ -39,7 +59,7 @@ media::TrackListImplementation::TrackListImplementation(
         const dbus::types::ObjectPath& op,
         const std::shared_ptr<media::Engine::MetaDataExtractor>& extractor)
     : media::TrackListSkeleton(op),
-      d(new Private{op, Private::MetaDataCache{}, extractor})
+      d(new Private{op, {}, Private::MetaDataCache{}, std::set<Track::Id>{}, extractor})
 {
     can_edit_tracks().set(true);
 }
@@ -50,6 +70,7 @@ media::TrackListImplementation::~TrackListImplementation()
 
 media::Track::UriType media::TrackListImplementation::query_uri_for_track(const media::Track::Id& id)
 {
+    std::lock_guard<std::mutex> lg(d->guard);
     auto it = d->meta_data_cache.find(id);
 
     if (it == d->meta_data_cache.end())
@@ -60,12 +81,51 @@ media::Track::UriType media::TrackListImplementation::query_uri_for_track(const
 
 media::Track::MetaData media::TrackListImplementation::query_meta_data_for_track(const media::Track::Id& id)
 {
+    Track::UriType uri;
+    {
+        std::lock_guard<std::mutex> lg(d->guard);
+        auto it = d->meta_data_cache.find(id);
+
+        if (it == d->meta_data_cache.end())
+            return Track::MetaData{};
+
+        if (d->unextracted.erase(id) == 0)
+            return std::get<1>(it->second);
+
+        uri = std::get<0>(it->second);
+    }
+
+    // Extraction takes a while, the list stays editable meanwhile
+    Track::MetaData md;
+    try
+    {
+        md = d->extractor->meta_data_for_track_with_uri(uri);
+    } catch (const std::exception& e)
+    {
+        MH_WARNING("Could not extract meta data for " << uri << ": " << e.what());
+    }
+
+    std::lock_guard<std::mutex> lg(d->guard);
     auto it = d->meta_data_cache.find(id);
+    if (it != d->meta_data_cache.end())
+        std::get<1>(it->second) = md;
 
-    if (it == d->meta_data_cache.end())
-        return Track::MetaData{};
+    return md;
+}
 
-    return std::get<1>(it->second);
+std::vector<media::Track::UriType> media::TrackListImplementation::uris() const
+{
+    std::lock_guard<std::mutex> lg(d->guard);
+
+    std::vector<Track::UriType> result;
+    result.reserve(tracks().get().size());
+    for (const auto& id : tracks().get())
+    {
+        auto it = d->meta_data_cache.find(id);
+        result.push_back(it == d->meta_data_cache.end() ? Track::UriType{} : std::get<0>(it->second));
+    }
+
+    return result;
 }
 
 void media::TrackListImplementation::add_track_with_uri_at(
@@ -73,30 +133,29 @@ void media::TrackListImplementation::add_track_with_uri_at(
         const media::Track::Id& position,
         bool make_current)
 {
-    static size_t track_counter = 0;
+    MH_TRACE_SCOPE("tracklist", "add_track_with_uri_at");
 
-    std::stringstream ss; ss << d->path.as_string() << "/" << track_counter++;
-    Track::Id id{ss.str()};
+    const auto md = d->extractor->meta_data_for_track_with_uri(uri);
 
-    auto result = tracks().update([this, id, position, make_current](TrackList::Container& container)
+    Track::Id id;
+    bool result = false;
     {
-        auto it = std::find(container.begin(), container.end(), position);
-        container.insert(it, id);
-        return true;
-    });
+        std::lock_guard<std::mutex> lg(d->guard);
+        id = d->next_track_id();
 
-    if (result)
-    {
-        if (d->meta_data_cache.count(id) == 0)
-        {
-            d->meta_data_cache[id] = std::make_tuple(
-                        uri,
-                        d->extractor->meta_data_for_track_with_uri(uri));
-        } else
+        result = tracks().update([this, id, position, make_current](TrackList::Container& container)
         {
-            std::get<0>(d->meta_data_cache[id]) = uri;
-        }
+            auto it = std::find(container.begin(), container.end(), position);
+            container.insert(it, id);
+            return true;
+        });
 
+        if (result)
+            d->meta_data_cache[id] = std::make_tuple(uri, md);
+    }
+
+    if (result)
+    {
         if (make_current)
             go_to(id);
 
@@ -104,24 +163,67 @@ void media::TrackListImplementation::add_track_with_uri_at(
     }
 }
 
-void media::TrackListImplementation::remove_track(const media::Track::Id& id)
+void media::TrackListImplementation::add_tracks_with_uri_at(
+        const std::vector<media::Track::UriType>& uris,
+        const media::Track::Id& position)
 {
-    auto result = tracks().update([id](TrackList::Container& container)
+    MH_TRACE_SCOPE("tracklist", "add_tracks_with_uri_at");
+
+    if (uris.empty())
+        return;
+
+    bool result = false;
     {
-        container.erase(std::find(container.begin(), container.end(), id));
-        return true;
-    });
+        std::lock_guard<std::mutex> lg(d->guard);
+
+        std::vector<Track::Id> ids;
+        ids.reserve(uris.size());
+        for (const auto& uri : uris)
+        {
+            ids.push_back(d->next_track_id());
+            d->meta_data_cache[ids.back()] = std::make_tuple(uri, Track::MetaData{});
+            d->unextracted.insert(ids.back());
+        }
+
+        result = tracks().update([&ids, position](TrackList::Container& container)
+        {
+            auto it = std::find(container.begin(), container.end(), position);
+            container.insert(it, ids.begin(), ids.end());
+            return true;
+        });
+    }
 
+    // A single replacement rather than one signal per track
     if (result)
+        on_track_list_replaced()();
+}
+
+void media::TrackListImplementation::remove_track(const media::Track::Id& id)
+{
+    MH_TRACE_SCOPE("tracklist", "remove_track");
+
+    bool result = false;
     {
-        d->meta_data_cache.erase(id);
+        std::lock_guard<std::mutex> lg(d->guard);
+        result = tracks().update([id](TrackList::Container& container)
+        {
+            container.erase(std::find(container.begin(), container.end(), id));
+            return true;
+        });
 
-        on_track_removed()(id);
+        if (result)
+        {
+            d->meta_data_cache.erase(id);
+            d->unextracted.erase(id);
+        }
     }
 
+    if (result)
+        on_track_removed()(id);
+
 }
 
 void media::TrackListImplementation::go_to(const media::Track::Id& track)
 {
-    (void) track;
+    set_current_track(track);
 }
@@ -38,8 +38,12 @@ public:
 
     Track::UriType query_uri_for_track(const Track::Id& id);
     Track::MetaData query_meta_data_for_track(const Track::Id& id);
+    // The uris of all tracks in order, consistent even while the list is
+    // being edited on another thread.
+    std::vector<Track::UriType> uris() const;
 
     void add_track_with_uri_at(const Track::UriType& uri, const Track::Id& position, bool make_current);
+    void add_tracks_with_uri_at(const std::vector<Track::UriType>& uris, const Track::Id& position);
     void remove_track(const Track::Id& id);
 
     void go_to(const Track::Id& track);
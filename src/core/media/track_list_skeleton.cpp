@@ -25,9 +25,12 @@
 #include "property_stub.h"
 #include "track_list_traits.h"
 #include "the_session_bus.h"
+#include "trace.h"
 
+#include "mpris/metadata.h"
 #include "mpris/track_list.h"
 
+#include <core/dbus/interfaces/properties.h>
 #include <core/dbus/object.h>
 #include <core/dbus/property.h>
 #include <core/dbus/types/object_path.h>
@@ -35,6 +38,9 @@
 #include <core/dbus/types/stl/map.h>
 #include <core/dbus/types/stl/vector.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <limits>
 
 namespace dbus = core::dbus;
@@ -47,14 +53,100 @@ struct media::TrackListSkeleton::Private
         : impl(impl),
           object(object),
           can_edit_tracks(object->get_property<mpris::TrackList::Properties::CanEditTracks>()),
-          tracks(object->get_property<mpris::TrackList::Properties::Tracks>()),
-          current_track(tracks->get().begin()),
-          empty_iterator(tracks->get().begin())
+          remote_tracks(object->get_property<mpris::TrackList::Properties::Tracks>()),
+          signals
+          {
+              object->get_signal<mpris::TrackList::Signals::TrackListReplaced>(),
+              object->get_signal<mpris::TrackList::Signals::TrackAdded>(),
+              object->get_signal<mpris::TrackList::Signals::TrackRemoved>(),
+              object->get_signal<mpris::TrackList::Signals::TrackMetadataChanged>(),
+              object->get_signal<core::dbus::interfaces::Properties::Signals::PropertiesChanged>()
+          }
     {
+        // The list lives locally and is only marshalled when a client asks for
+        // it, edits travel as the signals below.
+        remote_tracks->install([this]()
+        {
+            return tracks.get();
+        });
+
+        // Mirror every local change on the bus, clients keep incremental
+        // copies of the list instead of re-reading Tracks.
+        on_track_list_replaced.connect([this]()
+        {
+            std::vector<dbus::types::ObjectPath> paths;
+            for (const auto& id : tracks.get())
+                paths.push_back(dbus::types::ObjectPath{id});
+
+            // The current track is known to the player, not to the list.
+            signals.track_list_replaced->emit(std::make_tuple(
+                        paths,
+                        dbus::types::ObjectPath{TrackList::after_empty_track()}));
+            invalidate_tracks();
+        });
+
+        on_track_added.connect([this](const Track::Id& id)
+        {
+            signals.track_added->emit(std::make_tuple(
+                        dictionary_for_track(id),
+                        dbus::types::ObjectPath{track_before(id)}));
+            invalidate_tracks();
+        });
+
+        on_track_removed.connect([this](const Track::Id& id)
+        {
+            signals.track_removed->emit(dbus::types::ObjectPath{id});
+            invalidate_tracks();
+        });
+
+        on_track_changed.connect([this](const Track::Id& id)
+        {
+            signals.track_metadata_changed->emit(std::make_tuple(
+                        dictionary_for_track(id),
+                        dbus::types::ObjectPath{id}));
+        });
+    }
+
+    // Generic property watchers still learn that Tracks changed, the value
+    // itself is only sent when they read it.
+    void invalidate_tracks()
+    {
+        static const std::map<std::string, dbus::types::Variant> the_empty_dictionary;
+        static const std::vector<std::string> the_invalidated_properties
+        {
+            mpris::TrackList::Properties::Tracks::name()
+        };
+
+        signals.properties_changed->emit(std::make_tuple(
+                        dbus::traits::Service<TrackList>::interface_name(),
+                        the_empty_dictionary,
+                        the_invalidated_properties));
+    }
+
+    std::map<std::string, dbus::types::Variant> dictionary_for_track(const Track::Id& id)
+    {
+        std::map<std::string, dbus::types::Variant> dict;
+        for (const auto& pair : *impl->query_meta_data_for_track(id))
+            dict[pair.first] = dbus::types::Variant::encode(pair.second);
+
+        dict[mpris::metadata::TrackId::name] = dbus::types::Variant::encode(dbus::types::ObjectPath{id});
+        return dict;
+    }
+
+    // The id of the track preceding id, or the empty track if id comes first.
+    Track::Id track_before(const Track::Id& id)
+    {
+        const auto& container = tracks.get();
+        auto it = std::find(container.begin(), container.end(), id);
+        if (it == container.begin() || it == container.end())
+            return TrackList::after_empty_track();
+
+        return *std::prev(it);
     }
 
     void handle_get_tracks_metadata(const core::dbus::Message::Ptr& msg)
     {
+        MH_TRACE_SCOPE("dbus", "TrackList.GetTracksMetadata");
         media::Track::Id track;
         msg->reader() >> track;
 
@@ -65,8 +157,24 @@ struct media::TrackListSkeleton::Private
         impl->access_bus()->send(reply);
     }
 
+    void handle_get_tracks(const core::dbus::Message::Ptr& msg)
+    {
+        MH_TRACE_SCOPE("dbus", "TrackList.GetTracks");
+        std::uint32_t offset, max;
+        msg->reader() >> offset >> max;
+
+        const auto& container = tracks.get();
+        const auto first = std::min<std::size_t>(offset, container.size());
+        const auto last = std::min<std::size_t>(first + max, container.size());
+
+        auto reply = dbus::Message::make_method_return(msg);
+        reply->writer() << TrackList::Container(container.begin() + first, container.begin() + last);
+        impl->access_bus()->send(reply);
+    }
+
     void handle_add_track_with_uri_at(const core::dbus::Message::Ptr& msg)
     {
+        MH_TRACE_SCOPE("dbus", "TrackList.AddTrack");
         Track::UriType uri; media::Track::Id after; bool make_current;
         msg->reader() >> uri >> after >> make_current;
 
@@ -78,6 +186,7 @@ struct media::TrackListSkeleton::Private
 
     void handle_remove_track(const core::dbus::Message::Ptr& msg)
     {
+        MH_TRACE_SCOPE("dbus", "TrackList.RemoveTrack");
         media::Track::Id track;
         msg->reader() >> track;
 
@@ -89,6 +198,7 @@ struct media::TrackListSkeleton::Private
 
     void handle_go_to(const core::dbus::Message::Ptr& msg)
     {
+        MH_TRACE_SCOPE("dbus", "TrackList.GoTo");
         media::Track::Id track;
         msg->reader() >> track;
 
@@ -102,9 +212,25 @@ struct media::TrackListSkeleton::Private
     dbus::Object::Ptr object;
 
     std::shared_ptr<core::dbus::Property<mpris::TrackList::Properties::CanEditTracks>> can_edit_tracks;
-    std::shared_ptr<core::dbus::Property<mpris::TrackList::Properties::Tracks>> tracks;
-    TrackList::ConstIterator current_track;
-    TrackList::ConstIterator empty_iterator;
+    std::shared_ptr<core::dbus::Property<mpris::TrackList::Properties::Tracks>> remote_tracks;
+    core::Property<TrackList::Container> tracks;
+    // Kept by id, iterators into the list don't survive edits
+    Track::Id current_track;
+
+    struct Signals
+    {
+        typedef core::dbus::Signal<mpris::TrackList::Signals::TrackListReplaced, mpris::TrackList::Signals::TrackListReplaced::ArgumentType> DBusTrackListReplacedSignal;
+        typedef core::dbus::Signal<mpris::TrackList::Signals::TrackAdded, mpris::TrackList::Signals::TrackAdded::ArgumentType> DBusTrackAddedSignal;
+        typedef core::dbus::Signal<mpris::TrackList::Signals::TrackRemoved, mpris::TrackList::Signals::TrackRemoved::ArgumentType> DBusTrackRemovedSignal;
+        typedef core::dbus::Signal<mpris::TrackList::Signals::TrackMetadataChanged, mpris::TrackList::Signals::TrackMetadataChanged::ArgumentType> DBusTrackMetadataChangedSignal;
+        typedef core::dbus::Signal<core::dbus::interfaces::Properties::Signals::PropertiesChanged, core::dbus::interfaces::Properties::Signals::PropertiesChanged::ArgumentType> DBusPropertiesChangedSignal;
+
+        std::shared_ptr<DBusTrackListReplacedSignal> track_list_replaced;
+        std::shared_ptr<DBusTrackAddedSignal> track_added;
+        std::shared_ptr<DBusTrackRemovedSignal> track_removed;
+        std::shared_ptr<DBusTrackMetadataChangedSignal> track_metadata_changed;
+        std::shared_ptr<DBusPropertiesChangedSignal> properties_changed;
+    } signals;
 
     core::Signal<void> on_track_list_replaced;
     core::Signal<Track::Id> on_track_added;
@@ -122,6 +248,11 @@ media::TrackListSkeleton::TrackListSkeleton(
                   std::ref(d),
                   std::placeholders::_1));
 
+    d->object->install_method_handler<mpris::TrackList::GetTracks>(
+        std::bind(&Private::handle_get_tracks,
+                  std::ref(d),
+                  std::placeholders::_1));
+
     d->object->install_method_handler<mpris::TrackList::AddTrack>(
         std::bind(&Private::handle_add_track_with_uri_at,
                   std::ref(d),
@@ -144,22 +275,31 @@ media::TrackListSkeleton::~TrackListSkeleton()
 
 bool media::TrackListSkeleton::has_next() const
 {
-    return d->current_track != d->tracks->get().end();
+    const auto& tracks = d->tracks.get();
+    auto it = std::find(tracks.begin(), tracks.end(), d->current_track);
+    // Without a current track, the first one is the one playing
+    if (it == tracks.end())
+        it = tracks.begin();
+
+    return it != tracks.end() && std::next(it) != tracks.end();
 }
 
 const media::Track::Id& media::TrackListSkeleton::next()
 {
-    if (d->tracks->get().empty())
-        return *(d->current_track);
+    if (!has_next())
+        return d->current_track;
 
-    if (d->tracks->get().size() && (d->current_track == d->empty_iterator))
-    {        
-        d->current_track = d->tracks->get().begin();
-        return *(d->current_track = std::next(d->current_track));
-    }
+    const auto& tracks = d->tracks.get();
+    auto it = std::find(tracks.begin(), tracks.end(), d->current_track);
+    if (it == tracks.end())
+        it = tracks.begin();
 
-    d->current_track = std::next(d->current_track);
-    return *(d->current_track);
+    return d->current_track = *std::next(it);
+}
+
+void media::TrackListSkeleton::set_current_track(const media::Track::Id& id)
+{
+    d->current_track = id;
 }
 
 const core::Property<bool>& media::TrackListSkeleton::can_edit_tracks() const
@@ -174,12 +314,12 @@ core::Property<bool>& media::TrackListSkeleton::can_edit_tracks()
 
 core::Property<media::TrackList::Container>& media::TrackListSkeleton::tracks()
 {
-    return *d->tracks;
+    return d->tracks;
 }
 
 const core::Property<media::TrackList::Container>& media::TrackListSkeleton::tracks() const
 {
-    return *d->tracks;
+    return d->tracks;
 }
 
 const core::Signal<void>& media::TrackListSkeleton::on_track_list_replaced() const
@@ -39,6 +39,8 @@ public:
 
     bool has_next() const;
     const Track::Id& next();
+    // The track playing, next() continues after it
+    void set_current_track(const Track::Id& id);
 
     const core::Property<bool>& can_edit_tracks() const;
     const core::Property<Container>& tracks() const;
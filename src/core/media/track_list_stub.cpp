@@ -21,10 +21,12 @@
 #include <core/media/player.h>
 #include <core/media/track_list.h>
 
+#include "logger.h"
 #include "property_stub.h"
 #include "track_list_traits.h"
 #include "the_session_bus.h"
 
+#include "mpris/metadata.h"
 #include "mpris/track_list.h"
 
 #include <core/dbus/property.h>
@@ -33,7 +35,14 @@
 #include <core/dbus/types/stl/map.h>
 #include <core/dbus/types/stl/vector.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
 #include <limits>
+#include <mutex>
+#include <vector>
 
 namespace dbus = core::dbus;
 namespace media = core::ubuntu::media;
@@ -48,8 +57,159 @@ struct media::TrackListStub::Private
           parent(parent),
           object(impl->access_service()->object_for_path(op)),
           can_edit_tracks(object->get_property<mpris::TrackList::Properties::CanEditTracks>()),
-          tracks(object->get_property<mpris::TrackList::Properties::Tracks>())
+          signals
+          {
+              object->get_signal<mpris::TrackList::Signals::TrackListReplaced>(),
+              object->get_signal<mpris::TrackList::Signals::TrackAdded>(),
+              object->get_signal<mpris::TrackList::Signals::TrackRemoved>(),
+              object->get_signal<mpris::TrackList::Signals::TrackMetadataChanged>()
+          }
     {
+        signals.track_list_replaced->connect([this](const mpris::TrackList::Signals::TrackListReplaced::ArgumentType& args)
+        {
+            MH_TRACE("TrackListReplaced signal arrived via the bus.");
+            TrackList::Container replacement;
+            for (const auto& path : std::get<0>(args))
+                replacement.push_back(path.as_string());
+
+            replace(replacement);
+            on_track_list_replaced();
+        });
+
+        signals.track_added->connect([this](const mpris::TrackList::Signals::TrackAdded::ArgumentType& args)
+        {
+            MH_TRACE("TrackAdded signal arrived via the bus.");
+            Track::Id id;
+            if (!track_id_from_dictionary(std::get<0>(args), id))
+                return;
+
+            const Track::Id after = std::get<1>(args).as_string();
+            apply([id, after](TrackList::Container& container)
+            {
+                if (std::find(container.begin(), container.end(), id) != container.end())
+                    return false;
+
+                auto it = container.begin();
+                if (after != TrackList::after_empty_track())
+                {
+                    it = std::find(container.begin(), container.end(), after);
+                    if (it != container.end())
+                        it = std::next(it);
+                }
+
+                container.insert(it, id);
+                return true;
+            });
+            on_track_added(id);
+        });
+
+        signals.track_removed->connect([this](const dbus::types::ObjectPath& path)
+        {
+            MH_TRACE("TrackRemoved signal arrived via the bus.");
+            const Track::Id id = path.as_string();
+            apply([id](TrackList::Container& container)
+            {
+                auto it = std::find(container.begin(), container.end(), id);
+                if (it == container.end())
+                    return false;
+
+                container.erase(it);
+                return true;
+            });
+            on_track_removed(id);
+        });
+
+        signals.track_metadata_changed->connect([this](const mpris::TrackList::Signals::TrackMetadataChanged::ArgumentType& args)
+        {
+            MH_TRACE("TrackMetadataChanged signal arrived via the bus.");
+            on_track_changed(std::get<1>(args).as_string());
+        });
+    }
+
+    // Edits are idempotent, an edit that already is part of a fetched page
+    // leaves the mirror alone. Before the first fetch there is nothing to
+    // edit, the fetch returns the list with the edit applied.
+    void apply(const std::function<bool(TrackList::Container&)>& edit)
+    {
+        std::lock_guard<std::mutex> lg(mirror.guard);
+        if (!mirror.synced)
+        {
+            if (mirror.fetching > 0)
+                mirror.pending.push_back(edit);
+            return;
+        }
+
+        mirror.tracks.update(edit);
+    }
+
+    // A replacement carries the whole list, no need to fetch it anymore
+    void replace(const TrackList::Container& replacement)
+    {
+        std::lock_guard<std::mutex> lg(mirror.guard);
+        mirror.pending.clear();
+        mirror.synced = true;
+        mirror.tracks.set(replacement);
+    }
+
+    // Fetches the remote list page by page the first time it is needed.
+    // Edits that arrive meanwhile are queued and replayed on the result.
+    void sync_tracks()
+    {
+        if (mirror.synced)
+            return;
+
+        static constexpr std::uint32_t page_size{1024};
+
+        {
+            std::lock_guard<std::mutex> lg(mirror.guard);
+            mirror.fetching++;
+        }
+
+        TrackList::Container container;
+        try
+        {
+            for (;;)
+            {
+                auto op = object->invoke_method_synchronously<
+                        mpris::TrackList::GetTracks,
+                        TrackList::Container>(static_cast<std::uint32_t>(container.size()), page_size);
+
+                if (op.is_error())
+                    throw std::runtime_error("Problem querying tracks: " + op.error());
+
+                container.insert(container.end(), op.value().begin(), op.value().end());
+                if (op.value().size() < page_size)
+                    break;
+            }
+        } catch (...)
+        {
+            std::lock_guard<std::mutex> lg(mirror.guard);
+            if (--mirror.fetching == 0)
+                mirror.pending.clear();
+            throw;
+        }
+
+        std::lock_guard<std::mutex> lg(mirror.guard);
+        mirror.fetching--;
+        if (mirror.synced)
+            return;
+
+        for (const auto& edit : mirror.pending)
+            edit(container);
+        mirror.pending.clear();
+
+        mirror.synced = true;
+        mirror.tracks.set(container);
+    }
+
+    static bool track_id_from_dictionary(const std::map<std::string, dbus::types::Variant>& dict, Track::Id& id)
+    {
+        auto it = dict.find(mpris::metadata::TrackId::name);
+        if (it == dict.end())
+            return false;
+
+        id = it->second.as<mpris::metadata::TrackId::ValueType>().as_string();
+        return true;
     }
 
     TrackListStub* impl;
@@ -57,7 +217,31 @@ struct media::TrackListStub::Private
     dbus::Object::Ptr object;
 
     std::shared_ptr<core::dbus::Property<mpris::TrackList::Properties::CanEditTracks>> can_edit_tracks;
-    std::shared_ptr<core::dbus::Property<mpris::TrackList::Properties::Tracks>> tracks;
+
+    // Local copy of the remote list, so edits on the server never resend
+    // the whole Tracks property.
+    struct Mirror
+    {
+        std::mutex guard;
+        std::atomic<bool> synced{false};
+        // Fetches in flight, edits arriving meanwhile are queued in pending
+        unsigned int fetching{0};
+        std::vector<std::function<bool(TrackList::Container&)>> pending;
+        core::Property<TrackList::Container> tracks;
+    } mirror;
+
+    struct Signals
+    {
+        typedef core::dbus::Signal<mpris::TrackList::Signals::TrackListReplaced, mpris::TrackList::Signals::TrackListReplaced::ArgumentType> DBusTrackListReplacedSignal;
+        typedef core::dbus::Signal<mpris::TrackList::Signals::TrackAdded, mpris::TrackList::Signals::TrackAdded::ArgumentType> DBusTrackAddedSignal;
+        typedef core::dbus::Signal<mpris::TrackList::Signals::TrackRemoved, mpris::TrackList::Signals::TrackRemoved::ArgumentType> DBusTrackRemovedSignal;
+        typedef core::dbus::Signal<mpris::TrackList::Signals::TrackMetadataChanged, mpris::TrackList::Signals::TrackMetadataChanged::ArgumentType> DBusTrackMetadataChangedSignal;
+
+        std::shared_ptr<DBusTrackListReplacedSignal> track_list_replaced;
+        std::shared_ptr<DBusTrackAddedSignal> track_added;
+        std::shared_ptr<DBusTrackRemovedSignal> track_removed;
+        std::shared_ptr<DBusTrackMetadataChangedSignal> track_metadata_changed;
+    } signals;
 
     core::Signal<void> on_track_list_replaced;
     core::Signal<Track::Id> on_track_added;
@@ -84,7 +268,8 @@ const core::Property<bool>& media::TrackListStub::can_edit_tracks() const
 
 const core::Property<media::TrackList::Container>& media::TrackListStub::tracks() const
 {
-    return *d->tracks;
+    d->sync_tracks();
+    return d->mirror.tracks;
 }
 
 media::Track::MetaData media::TrackListStub::query_meta_data_for_track(const media::Track::Id& id)
@@ -31,7 +31,10 @@
 
 #include <gtest/gtest.h>
 
+#include <boost/filesystem.hpp>
+
 #include <cstdio>
+#include <cstdlib>
 
 #include <condition_variable>
 #include <functional>
@@ -41,6 +44,29 @@ namespace media = core::ubuntu::media;
 
 namespace
 {
+// Keeps the services started below away from the session journal,
+// playlists and cover art of the user running the tests.
+struct ScopedServiceState
+{
+    ScopedServiceState()
+        : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("media-hub-service-%%%%-%%%%"))
+    {
+        ::setenv("CORE_UBUNTU_MEDIA_SERVICE_SESSION_JOURNAL", (path / "sessions").string().c_str(), 1);
+        ::setenv("CORE_UBUNTU_MEDIA_SERVICE_PLAYLIST_DIR", (path / "playlists").string().c_str(), 1);
+        ::setenv("CORE_UBUNTU_MEDIA_SERVICE_COVER_ART_CACHE_DIR", (path / "art").string().c_str(), 1);
+    }
+
+    ~ScopedServiceState()
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(path, ec);
+    }
+
+    boost::filesystem::path path;
+};
+
+const ScopedServiceState service_state;
+
 struct SigTermCatcher
 {
     inline SigTermCatcher()
@@ -239,6 +265,68 @@ TEST(MusicService, DISABLED_remotely_querying_track_meta_data_works)
               core::testing::fork_and_run(service, client));
 }
 
+TEST(MusicService, DISABLED_track_list_changes_are_signalled_to_clients)
+{
+    const std::string test_file{"/tmp/test.ogg"};
+    std::remove(test_file.c_str());
+    ASSERT_TRUE(test::copy_test_ogg_file_to(test_file));
+
+    core::testing::CrossProcessSync sync_service_start;
+
+    auto service = [this, &sync_service_start]()
+    {
+        SigTermCatcher sc;
+
+        auto service = std::make_shared<media::ServiceImplementation>();
+        std::thread t([&service](){service->run();});
+
+        sync_service_start.try_signal_ready_for(std::chrono::milliseconds{500});
+
+        sc.wait_for_signal(); service->stop();
+
+        if (t.joinable())
+            t.join();
+
+        return ::testing::Test::HasFailure() ? core::posix::exit::Status::failure : core::posix::exit::Status::success;
+    };
+
+    auto client = [this, &sync_service_start]()
+    {
+        sync_service_start.wait_for_signal_ready_for(std::chrono::milliseconds{500});
+
+        static const media::Track::UriType uri{"file:///tmp/test.ogg"};
+
+        auto service = media::Service::Client::instance();
+        auto session = service->create_session(media::Player::Client::default_configuration());
+        auto track_list = session->track_list();
+
+        core::testing::WaitableStateTransition<media::Track::Id> added(media::TrackList::after_empty_track());
+        core::testing::WaitableStateTransition<media::Track::Id> removed(media::TrackList::after_empty_track());
+
+        track_list->on_track_added().connect(
+            std::bind(&core::testing::WaitableStateTransition<media::Track::Id>::trigger,
+                      std::ref(added),
+                      std::placeholders::_1));
+        track_list->on_track_removed().connect(
+            std::bind(&core::testing::WaitableStateTransition<media::Track::Id>::trigger,
+                      std::ref(removed),
+                      std::placeholders::_1));
+
+        track_list->add_track_with_uri_at(uri, media::TrackList::after_empty_track(), false);
+
+        auto id = track_list->tracks()->front();
+        EXPECT_TRUE(added.wait_for_state_for(id, std::chrono::milliseconds{1000}));
+
+        track_list->remove_track(id);
+        EXPECT_TRUE(removed.wait_for_state_for(id, std::chrono::milliseconds{1000}));
+
+        return ::testing::Test::HasFailure() ? core::posix::exit::Status::failure : core::posix::exit::Status::success;
+    };
+
+    EXPECT_EQ(core::testing::ForkAndRunResult::empty,
+              core::testing::fork_and_run(service, client));
+}
+
 TEST(MusicService, DISABLED_play_pause_seek_after_open_uri_works)
 {
     const std::string test_file{"/tmp/test.mp3"};
@@ -0,0 +1,82 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <core/media/player.h>
+
+#include "core/media/codec.h"
+
+#include <core/dbus/message.h>
+#include <core/dbus/types/object_path.h>
+
+#include <benchmark/benchmark.h>
+
+namespace dbus = core::dbus;
+namespace media = core::ubuntu::media;
+
+namespace
+{
+// Messages are only built and parsed locally, no bus connection is needed
+dbus::Message::Ptr make_message()
+{
+    return dbus::Message::make_method_call(
+                "core.ubuntu.media.Service",
+                dbus::types::ObjectPath{"/core/ubuntu/media/Service/sessions/0"},
+                "org.mpris.MediaPlayer2.Player",
+                "Benchmark");
+}
+
+void encode_player_properties(const dbus::Message::Ptr& msg)
+{
+    msg->writer()
+            << media::Player::PlaybackStatus::playing
+            << media::Player::LoopStatus::none
+            << media::Player::AudioStreamRole::multimedia
+            << media::Player::Orientation::rotate0
+            << media::Player::Lifetime::normal
+            << media::Player::Error::no_error;
+}
+}
+
+static void BM_codec_encode_player_properties(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        auto msg = make_message();
+        encode_player_properties(msg);
+        benchmark::DoNotOptimize(msg);
+    }
+}
+BENCHMARK(BM_codec_encode_player_properties);
+
+static void BM_codec_decode_player_properties(benchmark::State& state)
+{
+    auto msg = make_message();
+    encode_player_properties(msg);
+
+    while (state.KeepRunning())
+    {
+        media::Player::PlaybackStatus status;
+        media::Player::LoopStatus loop_status;
+        media::Player::AudioStreamRole role;
+        media::Player::Orientation orientation;
+        media::Player::Lifetime lifetime;
+        media::Player::Error error;
+
+        msg->reader() >> status >> loop_status >> role >> orientation >> lifetime >> error;
+        benchmark::DoNotOptimize(error);
+    }
+}
+BENCHMARK(BM_codec_decode_player_properties);
@@ -0,0 +1,198 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/gstreamer/bus.h"
+#include "core/media/gstreamer/meta_data_extractor.h"
+#include "core/media/gstreamer/task_pool.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+namespace
+{
+struct Init
+{
+    Init() : source(nullptr)
+    {
+        gst_init(nullptr, nullptr);
+        source = gst_element_factory_make("fakesink", "sink");
+    }
+
+    ~Init()
+    {
+        gst_object_unref(source);
+    }
+
+    GstElement* source;
+};
+
+GstObject* source()
+{
+    static Init init;
+    return GST_OBJECT(init.source);
+}
+
+GError* make_error()
+{
+    return g_error_new_literal(GST_CORE_ERROR, GST_CORE_ERROR_FAILED, "Synthetic failure");
+}
+
+// A tag list as posted by id3demux for a fully tagged mp3
+GstTagList* make_tag_list()
+{
+    return gst_tag_list_new(
+                GST_TAG_TITLE, "Test Title",
+                GST_TAG_ARTIST, "Test Artist",
+                GST_TAG_ALBUM, "Test Album",
+                GST_TAG_ALBUM_ARTIST, "Test Album Artist",
+                GST_TAG_GENRE, "Rock",
+                GST_TAG_COMMENT, "A comment that is a bit longer than the other values",
+                GST_TAG_COMPOSER, "Test Composer",
+                GST_TAG_TRACK_NUMBER, 7u,
+                GST_TAG_ALBUM_VOLUME_NUMBER, 1u,
+                GST_TAG_BITRATE, 128000u,
+                GST_TAG_DURATION, G_GUINT64_CONSTANT(180000000000),
+                GST_TAG_AUDIO_CODEC, "MPEG-1 Layer 3 (MP3)",
+                nullptr);
+}
+
+GstMessage* make_eos() { return gst_message_new_eos(source()); }
+GstMessage* make_error_message() { GError* e = make_error(); auto m = gst_message_new_error(source(), e, "debug details"); g_error_free(e); return m; }
+GstMessage* make_warning() { GError* e = make_error(); auto m = gst_message_new_warning(source(), e, "debug details"); g_error_free(e); return m; }
+GstMessage* make_info() { GError* e = make_error(); auto m = gst_message_new_info(source(), e, "debug details"); g_error_free(e); return m; }
+GstMessage* make_tag() { return gst_message_new_tag(source(), make_tag_list()); }
+GstMessage* make_buffering() { return gst_message_new_buffering(source(), 42); }
+GstMessage* make_state_changed() { return gst_message_new_state_changed(source(), GST_STATE_READY, GST_STATE_PAUSED, GST_STATE_PLAYING); }
+GstMessage* make_async_done() { return gst_message_new_async_done(source(), GST_CLOCK_TIME_NONE); }
+GstMessage* make_qos() { return gst_message_new_qos(source(), FALSE, 1000, 1000, 1000, 20); }
+GstMessage* make_duration_changed() { return gst_message_new_duration_changed(source()); }
+
+std::size_t thread_count()
+{
+    std::size_t count = 0;
+    if (auto dir = ::opendir("/proc/self/task"))
+    {
+        while (auto entry = ::readdir(dir))
+            if (entry->d_name[0] != '.')
+                count++;
+        ::closedir(dir);
+    }
+    return count;
+}
+
+std::size_t rss_kb()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+        if (line.compare(0, 6, "VmRSS:") == 0)
+            return std::strtoull(line.c_str() + 6, nullptr, 10);
+    return 0;
+}
+}
+
+// Constructing a Bus::Message parses the type specific payload,
+// this happens for every message on the streaming thread.
+static void BM_bus_message(benchmark::State& state, GstMessage* (*make)())
+{
+    GstMessage* msg = make();
+
+    while (state.KeepRunning())
+    {
+        gstreamer::Bus::Message message(msg);
+        if (message.cleanup)
+            message.cleanup();
+        benchmark::DoNotOptimize(message.detail);
+    }
+
+    gst_message_unref(msg);
+}
+BENCHMARK_CAPTURE(BM_bus_message, eos, make_eos);
+BENCHMARK_CAPTURE(BM_bus_message, error, make_error_message);
+BENCHMARK_CAPTURE(BM_bus_message, warning, make_warning);
+BENCHMARK_CAPTURE(BM_bus_message, info, make_info);
+BENCHMARK_CAPTURE(BM_bus_message, tag, make_tag);
+BENCHMARK_CAPTURE(BM_bus_message, buffering, make_buffering);
+BENCHMARK_CAPTURE(BM_bus_message, state_changed, make_state_changed);
+BENCHMARK_CAPTURE(BM_bus_message, async_done, make_async_done);
+BENCHMARK_CAPTURE(BM_bus_message, qos, make_qos);
+BENCHMARK_CAPTURE(BM_bus_message, duration_changed, make_duration_changed);
+
+static void BM_meta_data_extractor_on_tag_available(benchmark::State& state)
+{
+    gstreamer::Bus::Message::Detail::Tag tag;
+    tag.tag_list = make_tag_list();
+
+    while (state.KeepRunning())
+    {
+        core::ubuntu::media::Track::MetaData md;
+        gstreamer::MetaDataExtractor::on_tag_available(tag, md);
+        benchmark::DoNotOptimize(md);
+    }
+
+    gst_tag_list_unref(tag.tag_list);
+}
+BENCHMARK(BM_meta_data_extractor_on_tag_available);
+
+// Brings up state.range(0) pipelines with two streaming tasks each, the source
+// and the queue, and tears them down again. Compares the GStreamer default
+// task pool against the shared one, the label reports the threads and memory
+// of the process while all pipelines stream.
+static void BM_streaming_pipelines(benchmark::State& state, bool shared)
+{
+    source();
+    GstTaskPool* pool = shared ? gstreamer::shared_task_pool(core::ubuntu::media::scheduling::Class::multimedia) : nullptr;
+
+    std::size_t threads = 0, rss = 0;
+    while (state.KeepRunning())
+    {
+        std::vector<GstElement*> pipelines;
+        std::vector<std::unique_ptr<gstreamer::Bus>> buses;
+
+        for (int i = 0; i < state.range(0); i++)
+        {
+            auto pipeline = gst_parse_launch("audiotestsrc ! queue ! fakesink sync=true", nullptr);
+            buses.emplace_back(new gstreamer::Bus(gst_element_get_bus(pipeline)));
+            buses.back()->use_task_pool(pool);
+            gst_element_set_state(pipeline, GST_STATE_PLAYING);
+            pipelines.push_back(pipeline);
+        }
+
+        for (auto pipeline : pipelines)
+            gst_element_get_state(pipeline, nullptr, nullptr, GST_CLOCK_TIME_NONE);
+
+        threads = thread_count();
+        rss = rss_kb();
+
+        for (auto pipeline : pipelines)
+        {
+            gst_element_set_state(pipeline, GST_STATE_NULL);
+            gst_object_unref(pipeline);
+        }
+    }
+
+    state.SetLabel("threads=" + std::to_string(threads) + " rss_kb=" + std::to_string(rss));
+}
+BENCHMARK_CAPTURE(BM_streaming_pipelines, default_pool, false)->Arg(8)->Arg(32);
+BENCHMARK_CAPTURE(BM_streaming_pipelines, shared_pool, true)->Arg(8)->Arg(32);
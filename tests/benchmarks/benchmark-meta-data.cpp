@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <core/media/track.h>
+
+#include "core/media/xesam.h"
+
+#include <benchmark/benchmark.h>
+
+namespace media = core::ubuntu::media;
+
+namespace
+{
+// Roughly what the metadata extractor produces for a tagged mp3
+media::Track::MetaData make_meta_data()
+{
+    media::Track::MetaData md;
+    md.set(xesam::Album::name, "Test Album");
+    md.set(xesam::AlbumArtist::name, "Test Album Artist");
+    md.set(xesam::Artist::name, "Test Artist");
+    md.set(xesam::Comment::name, "A comment that is a bit longer than the other values");
+    md.set(xesam::Composer::name, "Test Composer");
+    md.set(xesam::DiscNumber::name, "1");
+    md.set(xesam::Genre::name, "Rock");
+    md.set(xesam::Title::name, "Test Title");
+    md.set(xesam::TrackNumber::name, "7");
+    md.set(xesam::UserRating::name, "0.5");
+    md.set("audio-codec", "MPEG-1 Layer 3 (MP3)");
+    md.set("bitrate", "128000");
+    return md;
+}
+}
+
+static void BM_meta_data_copy(benchmark::State& state)
+{
+    const auto md = make_meta_data();
+    while (state.KeepRunning())
+    {
+        media::Track::MetaData copy{md};
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK(BM_meta_data_copy);
+
+static void BM_meta_data_get(benchmark::State& state)
+{
+    const auto md = make_meta_data();
+    while (state.KeepRunning())
+    {
+        if (md.count(xesam::Title::name) > 0)
+            benchmark::DoNotOptimize(md.get(xesam::Title::name));
+    }
+}
+BENCHMARK(BM_meta_data_get);
+
+static void BM_meta_data_set(benchmark::State& state)
+{
+    auto md = make_meta_data();
+    const std::string title{"Another Title"};
+    while (state.KeepRunning())
+    {
+        md.set(xesam::Title::name, title);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_meta_data_set);
+
+static void BM_meta_data_compare(benchmark::State& state)
+{
+    const auto lhs = make_meta_data();
+    const auto rhs = make_meta_data();
+    while (state.KeepRunning())
+        benchmark::DoNotOptimize(lhs != rhs);
+}
+BENCHMARK(BM_meta_data_compare);
@@ -0,0 +1,155 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmarks of TrackListImplementation. The list exports itself on the
+// session bus, these are built as media-hub-bus-benchmarks and have to be
+// run with one, e.g. under dbus-run-session.
+
+#include <core/media/track_list.h>
+
+#include "core/media/track_list_implementation.h"
+
+#include "track_list_fixtures.h"
+
+#include <core/dbus/types/object_path.h>
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+
+namespace dbus = core::dbus;
+namespace media = core::ubuntu::media;
+
+namespace
+{
+// A TrackListImplementation holding n tracks. Every instance exports itself
+// on the session bus.
+std::shared_ptr<media::TrackListImplementation> make_track_list(benchmark::State& state, std::size_t n)
+{
+    static std::size_t instances = 0;
+
+    std::shared_ptr<media::TrackListImplementation> track_list;
+    try
+    {
+        track_list = std::make_shared<media::TrackListImplementation>(
+                    dbus::types::ObjectPath{"/core/ubuntu/media/Benchmark/TrackList/" + std::to_string(instances++)},
+                    std::make_shared<benchmarks::FixedMetaDataExtractor>());
+    } catch (const std::exception& e)
+    {
+        state.SkipWithError(e.what());
+        return nullptr;
+    }
+
+    track_list->add_tracks_with_uri_at(benchmarks::make_uris(0, n), media::TrackList::after_empty_track());
+    return track_list;
+}
+}
+
+// Inserts a track in front of the one in the middle of the list, extracting
+// its meta data and announcing it on the bus
+static void BM_track_list_add_track(benchmark::State& state)
+{
+    auto track_list = make_track_list(state, state.range(0));
+    if (!track_list)
+        return;
+
+    const auto position = track_list->tracks().get()[state.range(0) / 2];
+    const auto uri = benchmarks::make_uris(state.range(0), 1).front();
+
+    media::Track::Id added;
+    core::ScopedConnection connection
+    {
+        track_list->on_track_added().connect([&added](const media::Track::Id& id)
+        {
+            added = id;
+        })
+    };
+
+    while (state.KeepRunning())
+    {
+        track_list->add_track_with_uri_at(uri, position, false);
+
+        state.PauseTiming();
+        track_list->remove_track(added);
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_track_list_add_track)->Arg(10)->Arg(1000)->Arg(100000);
+
+// Removes the track in the middle of the list
+static void BM_track_list_remove_track(benchmark::State& state)
+{
+    auto track_list = make_track_list(state, state.range(0));
+    if (!track_list)
+        return;
+
+    const auto uri = benchmarks::make_uris(state.range(0), 1).front();
+
+    const std::size_t middle = state.range(0) / 2;
+
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        track_list->add_track_with_uri_at(uri, track_list->tracks().get()[middle], false);
+        const auto id = track_list->tracks().get()[middle];
+        state.ResumeTiming();
+
+        track_list->remove_track(id);
+    }
+}
+BENCHMARK(BM_track_list_remove_track)->Arg(10)->Arg(1000)->Arg(100000);
+
+// Enqueues an album in one go, meta data is only extracted when first queried
+static void BM_track_list_add_tracks(benchmark::State& state)
+{
+    auto track_list = make_track_list(state, state.range(0));
+    if (!track_list)
+        return;
+
+    const auto uris = benchmarks::make_uris(state.range(0), benchmarks::album_size);
+
+    while (state.KeepRunning())
+    {
+        track_list->add_tracks_with_uri_at(uris, media::TrackList::after_empty_track());
+
+        state.PauseTiming();
+        const auto tracks = track_list->tracks().get();
+        for (auto it = tracks.end() - benchmarks::album_size; it != tracks.end(); ++it)
+            track_list->remove_track(*it);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * benchmarks::album_size);
+}
+BENCHMARK(BM_track_list_add_tracks)->Arg(10)->Arg(1000)->Arg(100000);
+
+// Looks up every track the way the player does when advancing to it
+static void BM_track_list_query_uri(benchmark::State& state)
+{
+    auto track_list = make_track_list(state, state.range(0));
+    if (!track_list)
+        return;
+
+    const auto tracks = track_list->tracks().get();
+
+    while (state.KeepRunning())
+    {
+        for (const auto& id : tracks)
+            benchmark::DoNotOptimize(track_list->query_uri_for_track(id));
+    }
+    state.SetItemsProcessed(state.iterations() * tracks.size());
+}
+BENCHMARK(BM_track_list_query_uri)->Arg(10)->Arg(1000)->Arg(100000);
@@ -0,0 +1,166 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <core/media/track_list.h>
+
+#include "core/media/mpris/metadata.h"
+
+#include "track_list_fixtures.h"
+
+#include <core/dbus/message.h>
+#include <core/dbus/types/object_path.h>
+#include <core/dbus/types/variant.h>
+#include <core/dbus/types/stl/map.h>
+#include <core/dbus/types/stl/string.h>
+#include <core/dbus/types/stl/vector.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace dbus = core::dbus;
+namespace media = core::ubuntu::media;
+
+namespace
+{
+media::Track::Id make_id(std::size_t i)
+{
+    std::stringstream ss; ss << "/core/ubuntu/media/Service/sessions/0/TrackList/" << i;
+    return ss.str();
+}
+
+media::TrackList::Container make_tracks(std::size_t n)
+{
+    media::TrackList::Container tracks;
+    tracks.reserve(n);
+    for (std::size_t i = 0; i < n; i++)
+        tracks.push_back(make_id(i));
+    return tracks;
+}
+
+dbus::Message::Ptr make_signal()
+{
+    return dbus::Message::make_signal(
+                "/core/ubuntu/media/Service/sessions/0/TrackList",
+                "core.ubuntu.media.Service.Player.TrackList",
+                "Benchmark");
+}
+
+std::size_t align(std::size_t offset, std::size_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Size of a string or object path in a D-Bus body: aligned length, payload, NUL
+std::size_t wire_size(std::size_t offset, const std::string& s)
+{
+    return align(offset, 4) + 4 + s.size() + 1;
+}
+
+std::size_t wire_size(const media::TrackList::Container& tracks)
+{
+    std::size_t offset = 4;
+    for (const auto& id : tracks)
+        offset = wire_size(offset, id);
+    return offset;
+}
+
+// a{sv} with the meta data of the track and its mpris:trackid, followed by
+// the path of the preceding track. Every value is a string or object path,
+// each with a one letter signature.
+std::size_t wire_size_of_track_added(
+        const std::map<std::string, std::string>& meta_data,
+        const media::Track::Id& after)
+{
+    std::size_t offset = 4;
+    for (const auto& pair : meta_data)
+    {
+        offset = align(offset, 8);
+        offset = wire_size(offset, pair.first);
+        offset += 3;
+        offset = wire_size(offset, pair.second);
+    }
+    return wire_size(offset, after);
+}
+}
+
+// Appends an album to a queue of the given size the way the Tracks property
+// used to publish it, the whole list is marshalled after every single add.
+static void BM_track_list_enqueue_album_full_resend(benchmark::State& state)
+{
+    const auto queue = make_tracks(state.range(0));
+
+    std::size_t bytes = 0;
+    while (state.KeepRunning())
+    {
+        auto tracks = queue;
+        bytes = 0;
+        for (std::size_t i = 0; i < benchmarks::album_size; i++)
+        {
+            tracks.push_back(make_id(queue.size() + i));
+
+            auto msg = make_signal();
+            msg->writer() << tracks;
+            benchmark::DoNotOptimize(msg);
+            bytes += wire_size(tracks);
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetLabel("bytes_on_bus=" + std::to_string(bytes));
+}
+BENCHMARK(BM_track_list_enqueue_album_full_resend)->Arg(10)->Arg(1000)->Arg(50000);
+
+// The same enqueue published as one TrackAdded signal per track, which
+// carries the meta data of the track the full resend leaves to GetTracksMetadata.
+static void BM_track_list_enqueue_album_diff(benchmark::State& state)
+{
+    const auto queue = make_tracks(state.range(0));
+    const auto uris = benchmarks::make_uris(queue.size(), benchmarks::album_size);
+
+    std::size_t bytes = 0;
+    while (state.KeepRunning())
+    {
+        auto tracks = queue;
+        bytes = 0;
+        for (std::size_t i = 0; i < benchmarks::album_size; i++)
+        {
+            const auto after = tracks.back();
+            tracks.push_back(make_id(queue.size() + i));
+
+            auto meta_data = *benchmarks::FixedMetaDataExtractor().meta_data_for_track_with_uri(uris[i]);
+            std::map<std::string, dbus::types::Variant> dict;
+            for (const auto& pair : meta_data)
+                dict[pair.first] = dbus::types::Variant::encode(pair.second);
+
+            meta_data[mpris::metadata::TrackId::name] = tracks.back();
+            dict[mpris::metadata::TrackId::name] = dbus::types::Variant::encode(dbus::types::ObjectPath{tracks.back()});
+
+            auto msg = make_signal();
+            msg->writer() << dict << dbus::types::ObjectPath{after};
+            benchmark::DoNotOptimize(msg);
+            bytes += wire_size_of_track_added(meta_data, after);
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetLabel("bytes_on_bus=" + std::to_string(bytes));
+}
+BENCHMARK(BM_track_list_enqueue_album_diff)->Arg(10)->Arg(1000)->Arg(50000);
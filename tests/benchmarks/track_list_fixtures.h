@@ -0,0 +1,59 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEDIA_HUB_BENCHMARKS_TRACK_LIST_FIXTURES_H_
+#define MEDIA_HUB_BENCHMARKS_TRACK_LIST_FIXTURES_H_
+
+#include <core/media/track.h>
+
+#include "core/media/engine.h"
+#include "core/media/xesam.h"
+#include "core/media/mpris/metadata.h"
+
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+inline std::vector<core::ubuntu::media::Track::UriType> make_uris(std::size_t first, std::size_t n)
+{
+    std::vector<core::ubuntu::media::Track::UriType> uris;
+    uris.reserve(n);
+    for (std::size_t i = first; i < first + n; i++)
+        uris.push_back("file:///home/phablet/Music/" + std::to_string(i) + ".ogg");
+    return uris;
+}
+
+// Meta data as extracted for a typical album track, without the pipeline
+struct FixedMetaDataExtractor : public core::ubuntu::media::Engine::MetaDataExtractor
+{
+    core::ubuntu::media::Track::MetaData meta_data_for_track_with_uri(const core::ubuntu::media::Track::UriType& uri)
+    {
+        core::ubuntu::media::Track::MetaData md;
+        md.set(xesam::Url::name, uri);
+        md.set(xesam::Title::name, "Benchmark Track");
+        md.set(xesam::Artist::name, "Benchmark Artist");
+        md.set(xesam::Album::name, "Benchmark Album");
+        md.set(mpris::metadata::ArtUrl::name, "file:///usr/lib/media-hub/missing-album-art.png");
+        return md;
+    }
+};
+
+// Tracks on a typical album
+constexpr std::size_t album_size{12};
+}
+
+#endif // MEDIA_HUB_BENCHMARKS_TRACK_LIST_FIXTURES_H_
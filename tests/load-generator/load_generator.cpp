@@ -0,0 +1,354 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <core/media/player.h>
+#include <core/media/service.h>
+
+#include "core/media/metrics.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace media = core::ubuntu::media;
+namespace metrics = core::ubuntu::media::metrics;
+namespace po = boost::program_options;
+
+// Starts media-hub-server on a private session bus, spawns a number of client
+// processes that exercise sessions in a loop and reports per method throughput
+// and latency together with the server's CPU and memory usage.
+namespace
+{
+struct Options
+{
+    unsigned int clients;
+    std::chrono::seconds duration;
+    std::string server;
+    std::string uri;
+    std::string sink;
+    // Property reads per loop iteration, as a UI polling the player would do
+    unsigned int property_reads;
+    bool property_cache;
+};
+
+pid_t spawn(const std::vector<std::string>& args)
+{
+    auto pid = ::fork();
+    if (pid < 0)
+        throw std::runtime_error(std::string{"Failed to fork: "} + std::strerror(errno));
+
+    if (pid == 0)
+    {
+        std::vector<char*> argv;
+        for (const auto& arg : args)
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+
+        ::execvp(argv[0], argv.data());
+        std::cerr << "Failed to execute " << args[0] << ": " << std::strerror(errno) << std::endl;
+        ::_exit(EXIT_FAILURE);
+    }
+
+    return pid;
+}
+
+// Launches a dbus-daemon and returns the address of the bus
+std::string start_private_session_bus(pid_t& pid)
+{
+    int fds[2];
+    if (::pipe(fds) < 0)
+        throw std::runtime_error(std::string{"Failed to create pipe: "} + std::strerror(errno));
+
+    pid = spawn({"dbus-daemon", "--session", "--nofork", "--print-address=" + std::to_string(fds[1])});
+    ::close(fds[1]);
+
+    std::string address; char c;
+    while (::read(fds[0], &c, 1) == 1 && c != '\n')
+        address.push_back(c);
+    ::close(fds[0]);
+
+    if (address.empty())
+        throw std::runtime_error("Failed to start a private session bus");
+
+    return address;
+}
+
+struct ProcessStats
+{
+    // utime + stime in clock ticks
+    std::uint64_t cpu_ticks;
+    std::uint64_t rss_kb;
+};
+
+ProcessStats stats_for(pid_t pid)
+{
+    ProcessStats result{0, 0};
+
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string line;
+    if (std::getline(stat, line))
+    {
+        // Skip pid and comm, the latter might contain spaces
+        std::istringstream ss(line.substr(line.rfind(')') + 2));
+        std::string field;
+        for (int i = 3; i <= 13; i++)
+            ss >> field;
+        std::uint64_t utime = 0, stime = 0;
+        ss >> utime >> stime;
+        result.cpu_ticks = utime + stime;
+    }
+
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+            result.rss_kb = std::strtoull(line.c_str() + 6, nullptr, 10);
+    }
+
+    return result;
+}
+
+// Runs in a forked child, writes "method latency_us" lines to path.
+// A latency of -1 marks a failed call.
+int run_client(unsigned int index, const Options& options, const std::string& path)
+{
+    std::ofstream out(path);
+
+    auto record = [&out](const char* method, const std::function<void()>& f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        try
+        {
+            f();
+            out << method << " " << std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start).count() << "\n";
+            return true;
+        } catch (const std::exception&)
+        {
+            out << method << " -1\n";
+            return false;
+        }
+    };
+
+    auto service = media::Service::Client::instance();
+
+    // The server might still be starting up
+    std::shared_ptr<media::Player> player;
+    const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    while (!player && std::chrono::steady_clock::now() < give_up)
+    {
+        try
+        {
+            auto start = std::chrono::steady_clock::now();
+            player = service->create_session(media::Player::Client::default_configuration());
+            out << "CreateSession " << std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start).count() << "\n";
+        } catch (const std::exception&)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        }
+    }
+
+    if (!player)
+        return EXIT_FAILURE;
+
+    if (!record("OpenUri", [&]() { if (!player->open_uri(options.uri)) throw std::runtime_error("OpenUri failed"); }))
+        return EXIT_FAILURE;
+
+    std::mt19937 rng(index);
+    std::uniform_int_distribution<int> seek_target_ms(0, 1000);
+
+    const auto deadline = std::chrono::steady_clock::now() + options.duration;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        record("Play", [&]() { player->play(); });
+        record("Position", [&]() { (void) player->position().get(); });
+        record("Seek", [&]() { player->seek_to(std::chrono::milliseconds{seek_target_ms(rng)}); });
+        record("Position", [&]() { (void) player->position().get(); });
+        record("Pause", [&]() { player->pause(); });
+        record("Position", [&]() { (void) player->position().get(); });
+
+        for (unsigned int i = 0; i < options.property_reads; i++)
+        {
+            record("Read.Position", [&]() { (void) player->position().get(); });
+            record("Read.PlaybackStatus", [&]() { (void) player->playback_status().get(); });
+            record("Read.IsVideoSource", [&]() { (void) player->is_video_source().get(); });
+        }
+    }
+
+    record("Stop", [&]() { player->stop(); });
+    return EXIT_SUCCESS;
+}
+
+void report(const boost::filesystem::path& results, unsigned int clients, double wall_s)
+{
+    std::map<std::string, metrics::Histogram*> histograms;
+    std::map<std::string, std::uint64_t> failures;
+
+    for (unsigned int i = 0; i < clients; i++)
+    {
+        std::ifstream in((results / std::to_string(i)).string());
+        std::string method; long long latency;
+        while (in >> method >> latency)
+        {
+            if (latency < 0)
+            {
+                failures[method]++;
+                continue;
+            }
+
+            auto& h = histograms[method];
+            if (!h)
+                h = &metrics::histogram("loadgen." + method);
+            h->record(latency);
+        }
+    }
+
+    std::printf("%-20s %10s %10s %10s %10s %10s %10s\n", "method", "calls", "calls/s", "p50_us", "p99_us", "max_us", "failures");
+    for (const auto& pair : histograms)
+    {
+        auto s = pair.second->summary();
+        std::printf("%-20s %10llu %10.1f %10llu %10llu %10llu %10llu\n",
+                    pair.first.c_str(),
+                    static_cast<unsigned long long>(s.count),
+                    s.count / wall_s,
+                    static_cast<unsigned long long>(s.p50),
+                    static_cast<unsigned long long>(s.p99),
+                    static_cast<unsigned long long>(s.max),
+                    static_cast<unsigned long long>(failures[pair.first]));
+    }
+}
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    unsigned int duration_s;
+
+    po::options_description desc("media-hub load generator");
+    desc.add_options()
+        ("help", "produce help message")
+        ("clients", po::value<unsigned int>(&options.clients)->default_value(10), "number of client processes")
+        ("duration", po::value<unsigned int>(&duration_s)->default_value(30), "seconds every client keeps issuing calls")
+        ("server", po::value<std::string>(&options.server)->default_value(MEDIA_HUB_SERVER_EXECUTABLE), "media-hub-server executable")
+        ("uri", po::value<std::string>(&options.uri)->default_value(MEDIA_HUB_LOAD_GENERATOR_URI), "uri every session plays")
+        ("sink", po::value<std::string>(&options.sink)->default_value("fakesink"), "audio and video sink used by the server")
+        ("property-reads", po::value<unsigned int>(&options.property_reads)->default_value(0), "property reads per client loop iteration")
+        ("property-cache", po::bool_switch(&options.property_cache), "serve client property reads from the client side cache");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    options.duration = std::chrono::seconds{duration_s};
+
+    auto results = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("media-hub-load-%%%%-%%%%");
+    boost::filesystem::create_directories(results);
+
+    pid_t bus_pid;
+    ::setenv("DBUS_SESSION_BUS_ADDRESS", start_private_session_bus(bus_pid).c_str(), 1);
+    ::setenv("CORE_UBUNTU_MEDIA_SERVICE_AUDIO_SINK_NAME", options.sink.c_str(), 1);
+    ::setenv("CORE_UBUNTU_MEDIA_SERVICE_VIDEO_SINK_NAME", options.sink.c_str(), 1);
+    // The server keeps its state with the results, not with the user's
+    ::setenv("CORE_UBUNTU_MEDIA_SERVICE_SESSION_JOURNAL", (results / "sessions").string().c_str(), 1);
+    ::setenv("CORE_UBUNTU_MEDIA_SERVICE_PLAYLIST_DIR", (results / "playlists").string().c_str(), 1);
+    ::setenv("CORE_UBUNTU_MEDIA_SERVICE_COVER_ART_CACHE_DIR", (results / "art").string().c_str(), 1);
+    if (options.property_cache)
+        ::setenv("CORE_UBUNTU_MEDIA_SERVICE_CLIENT_PROPERTY_CACHE", "1", 1);
+
+    auto server_pid = spawn({options.server});
+    const auto server_start = stats_for(server_pid);
+
+    // The parent never touches the bus, children get a fresh connection
+    std::vector<pid_t> clients;
+    for (unsigned int i = 0; i < options.clients; i++)
+    {
+        auto pid = ::fork();
+        if (pid == 0)
+            ::_exit(run_client(i, options, (results / std::to_string(i)).string()));
+        clients.push_back(pid);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::uint64_t peak_rss_kb = 0;
+    unsigned int failed_clients = 0;
+    std::size_t running = clients.size();
+    while (running > 0)
+    {
+        peak_rss_kb = std::max(peak_rss_kb, stats_for(server_pid).rss_kb);
+
+        int status;
+        pid_t pid;
+        while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0)
+        {
+            if (pid == server_pid || pid == bus_pid)
+                continue;
+            running--;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+                failed_clients++;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{200});
+    }
+
+    const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const auto server_end = stats_for(server_pid);
+
+    report(results, options.clients, wall_s);
+
+    std::printf("\n%u clients (%u failed), %.1f s\n", options.clients, failed_clients, wall_s);
+    std::printf("server: cpu %.1f%%, rss %.1f MiB (peak %.1f MiB)\n",
+                100. * (server_end.cpu_ticks - server_start.cpu_ticks) / ::sysconf(_SC_CLK_TCK) / wall_s,
+                server_end.rss_kb / 1024.,
+                peak_rss_kb / 1024.);
+
+    ::kill(server_pid, SIGTERM);
+    ::waitpid(server_pid, nullptr, 0);
+    ::kill(bus_pid, SIGTERM);
+    ::waitpid(bus_pid, nullptr, 0);
+
+    boost::filesystem::remove_all(results);
+
+    return failed_clients == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
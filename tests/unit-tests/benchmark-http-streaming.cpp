@@ -0,0 +1,348 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <core/posix/fork.h>
+
+#include "core/media/gstreamer/engine.h"
+#include "core/media/metrics.h"
+
+#include "../test_data.h"
+#include "web_server.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace media = core::ubuntu::media;
+namespace metrics = core::ubuntu::media::metrics;
+
+// Measures HTTP playback through gstreamer::Engine against the mongoose test
+// server, emulating network conditions. Not part of the test suite, run with:
+//   benchmark-http-streaming [--bandwidth=<bytes/s>] [--latency=<ms>]
+//                            [--chunk=<bytes>] [--no-range] [--chunked]
+// Without arguments a set of representative network profiles is measured.
+namespace
+{
+struct EnsureFakeSinksAreUsed
+{
+    EnsureFakeSinksAreUsed()
+    {
+        ::setenv("CORE_UBUNTU_MEDIA_SERVICE_AUDIO_SINK_NAME", "fakesink", 1);
+        ::setenv("CORE_UBUNTU_MEDIA_SERVICE_VIDEO_SINK_NAME", "fakesink", 1);
+    }
+} ensure_fake_sinks_are_used;
+
+struct Scenario
+{
+    std::string name;
+    // 0 for unlimited
+    std::size_t bandwidth;
+    // Delay before the first byte of every reply
+    std::chrono::milliseconds latency;
+    // Replies are written in pieces of this size
+    std::size_t chunk_size;
+    bool range_support;
+    // Use Transfer-Encoding: chunked instead of a Content-Length
+    bool chunked;
+};
+
+struct Result
+{
+    bool playing;
+    double time_to_first_audio_ms;
+    unsigned int rebuffers;
+    unsigned int failed_seeks;
+    metrics::Histogram::Summary seek_latency;
+};
+
+std::vector<Scenario> scenarios;
+
+// Serves content paced according to the scenario
+testing::web::server::Configuration configuration_for(const Scenario& scenario, std::uint16_t port, const std::string& content)
+{
+    struct Reply
+    {
+        std::chrono::steady_clock::time_point start;
+        std::size_t offset;
+        std::size_t end;
+        std::size_t sent;
+    };
+
+    // Only ever touched from the server's polling loop
+    auto replies = std::make_shared<std::map<mg_connection*, Reply>>();
+
+    testing::web::server::Configuration configuration;
+    configuration.port = port;
+    configuration.request_handler = [scenario, content, replies](mg_connection* conn)
+    {
+        std::size_t begin = 0, end = content.size();
+        bool partial = false;
+
+        const char* range = mg_get_header(conn, "Range");
+        if (scenario.range_support && range != nullptr)
+        {
+            long long first = 0, last = 0;
+            int n = std::sscanf(range, "bytes=%lld-%lld", &first, &last);
+            if (n >= 1 && first >= 0 && static_cast<std::size_t>(first) < content.size())
+            {
+                begin = first;
+                if (n == 2)
+                    end = std::min<std::size_t>(last + 1, content.size());
+                partial = true;
+            }
+        }
+
+        std::stringstream ss;
+        ss << "HTTP/1.1 " << (partial ? "206 Partial Content" : "200 OK") << "\r\n"
+           << "Content-Type: audio/mpeg\r\n"
+           << "Accept-Ranges: " << (scenario.range_support ? "bytes" : "none") << "\r\n";
+        if (partial)
+            ss << "Content-Range: bytes " << begin << "-" << end - 1 << "/" << content.size() << "\r\n";
+        if (scenario.chunked)
+            ss << "Transfer-Encoding: chunked\r\n";
+        else
+            ss << "Content-Length: " << end - begin << "\r\n";
+        ss << "\r\n";
+
+        const auto head = ss.str();
+        mg_write(conn, head.data(), head.size());
+
+        (*replies)[conn] = Reply{std::chrono::steady_clock::now(), begin, end, 0};
+        return MG_MORE;
+    };
+    configuration.poll_handler = [scenario, content, replies](mg_connection* conn)
+    {
+        auto it = replies->find(conn);
+        if (it == replies->end())
+            return MG_FALSE;
+
+        auto& reply = it->second;
+        const auto elapsed = std::chrono::steady_clock::now() - reply.start;
+        if (elapsed < scenario.latency)
+            return MG_FALSE;
+
+        const std::size_t remaining = reply.end - reply.offset - reply.sent;
+        std::size_t budget = remaining;
+        if (scenario.bandwidth > 0)
+        {
+            const double seconds = std::chrono::duration<double>(elapsed - scenario.latency).count();
+            const std::size_t allowed = static_cast<std::size_t>(seconds * scenario.bandwidth);
+            budget = std::min(remaining, allowed > reply.sent ? allowed - reply.sent : 0);
+        }
+
+        while (budget > 0)
+        {
+            const std::size_t n = std::min(budget, scenario.chunk_size);
+            const char* data = content.data() + reply.offset + reply.sent;
+
+            if (scenario.chunked)
+            {
+                char size[32];
+                int len = std::snprintf(size, sizeof(size), "%zx\r\n", n);
+                mg_write(conn, size, len);
+                mg_write(conn, data, n);
+                mg_write(conn, "\r\n", 2);
+            } else
+            {
+                mg_write(conn, data, n);
+            }
+
+            reply.sent += n;
+            budget -= n;
+        }
+
+        if (reply.offset + reply.sent < reply.end)
+            return MG_FALSE;
+
+        if (scenario.chunked)
+            mg_write(conn, "0\r\n\r\n", 5);
+
+        replies->erase(it);
+        return MG_TRUE;
+    };
+
+    return configuration;
+}
+
+Result measure(const Scenario& scenario, std::uint16_t port)
+{
+    const std::string test_file{"/tmp/test.mp3"};
+    std::remove(test_file.c_str());
+    EXPECT_TRUE(test::copy_test_mp3_file_to(test_file));
+
+    std::ifstream in(test_file, std::ios::binary);
+    const std::string content{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    core::testing::CrossProcessSync cps;
+    auto server = core::posix::fork(
+                std::bind(testing::a_web_server(configuration_for(scenario, port, content)), cps),
+                core::posix::StandardStream::empty);
+    cps.wait_for_signal_ready_for(std::chrono::seconds{2});
+
+    Result result{false, 0., 0, 0, metrics::Histogram::Summary{0, 0., 0, 0, 0, 0}};
+
+    {
+        gstreamer::Engine engine;
+
+        // A rebuffer is the buffer running dry after having been filled once
+        std::atomic<unsigned int> rebuffers{0};
+        std::atomic<bool> filled{false};
+        engine.buffering_signal().connect([&rebuffers, &filled](int percent)
+        {
+            if (percent >= 100)
+                filled = true;
+            else if (filled.exchange(false))
+                rebuffers++;
+        });
+
+        std::mutex guard;
+        std::condition_variable seeked;
+        unsigned int seeks_landed = 0;
+        engine.seeked_to_signal().connect([&guard, &seeked, &seeks_landed](uint64_t)
+        {
+            std::lock_guard<std::mutex> lg(guard);
+            seeks_landed++;
+            seeked.notify_all();
+        });
+
+        const auto start = std::chrono::steady_clock::now();
+        engine.open_resource_for_uri("http://localhost:" + std::to_string(port));
+        result.playing = engine.play();
+
+        // Wait for the first samples to reach the sink
+        const auto give_up = start + std::chrono::seconds{30};
+        while (result.playing && engine.position().get() == 0 && std::chrono::steady_clock::now() < give_up)
+            std::this_thread::sleep_for(std::chrono::milliseconds{2});
+        result.time_to_first_audio_ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count();
+
+        auto& seek_latency = metrics::histogram("benchmark.http." + scenario.name + ".seek_us");
+        const uint64_t duration_us = engine.duration().get() / 1000;
+        for (double fraction : {0.5, 0.1, 0.8, 0.3, 0.6})
+        {
+            std::unique_lock<std::mutex> ul(guard);
+            const unsigned int before = seeks_landed;
+            const auto seek_start = std::chrono::steady_clock::now();
+
+            ul.unlock();
+            engine.seek_to(std::chrono::microseconds{static_cast<uint64_t>(fraction * duration_us)});
+            ul.lock();
+
+            if (seeked.wait_for(ul, std::chrono::seconds{10}, [&]() { return seeks_landed > before; }))
+                seek_latency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                                        std::chrono::steady_clock::now() - seek_start).count());
+            else
+                result.failed_seeks++;
+        }
+
+        engine.stop();
+
+        result.rebuffers = rebuffers;
+        result.seek_latency = seek_latency.summary();
+    }
+
+    server.send_signal_or_throw(core::posix::Signal::sig_term);
+    server.wait_for(core::posix::wait::Flags::untraced);
+
+    return result;
+}
+}
+
+TEST(HttpStreamingBenchmark, measure_playback_under_network_conditions)
+{
+    std::printf("%-12s %12s %10s %10s %12s %10s %12s %12s %10s\n",
+                "scenario", "bandwidth", "latency", "chunk", "range/chunked",
+                "ttfa_ms", "rebuffers", "seek_p50_ms", "seek_fail");
+
+    std::uint16_t port = 5100;
+    for (const auto& scenario : scenarios)
+    {
+        auto result = measure(scenario, port++);
+        EXPECT_TRUE(result.playing) << scenario.name;
+
+        std::printf("%-12s %12zu %10lld %10zu %6s/%-6s %10.1f %12u %12.1f %10u\n",
+                    scenario.name.c_str(),
+                    scenario.bandwidth,
+                    static_cast<long long>(scenario.latency.count()),
+                    scenario.chunk_size,
+                    scenario.range_support ? "yes" : "no",
+                    scenario.chunked ? "yes" : "no",
+                    result.time_to_first_audio_ms,
+                    result.rebuffers,
+                    result.seek_latency.p50 / 1000.,
+                    result.failed_seeks);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    Scenario custom{"custom", 0, std::chrono::milliseconds{0}, 16 * 1024, true, false};
+    bool has_custom = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg{argv[i]};
+        auto value_of = [&arg]() { return std::stoull(arg.substr(arg.find('=') + 1)); };
+
+        has_custom = true;
+        if (arg.compare(0, 12, "--bandwidth=") == 0)
+            custom.bandwidth = value_of();
+        else if (arg.compare(0, 10, "--latency=") == 0)
+            custom.latency = std::chrono::milliseconds{value_of()};
+        else if (arg.compare(0, 8, "--chunk=") == 0)
+            custom.chunk_size = std::max<std::size_t>(1, value_of());
+        else if (arg == "--no-range")
+            custom.range_support = false;
+        else if (arg == "--chunked")
+            custom.chunked = true;
+        else
+        {
+            std::fprintf(stderr, "Unknown argument: %s\n", arg.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (has_custom)
+    {
+        scenarios.push_back(custom);
+    } else
+    {
+        scenarios =
+        {
+            {"loopback", 0, std::chrono::milliseconds{0}, 64 * 1024, true, false},
+            {"wifi", 2500 * 1000, std::chrono::milliseconds{20}, 16 * 1024, true, false},
+            {"3g", 256 * 1000, std::chrono::milliseconds{150}, 4 * 1024, true, false},
+            {"edge", 32 * 1000, std::chrono::milliseconds{400}, 1024, true, false},
+            {"no-range", 1000 * 1000, std::chrono::milliseconds{50}, 16 * 1024, false, false},
+            {"chunked", 1000 * 1000, std::chrono::milliseconds{50}, 16 * 1024, false, true}
+        };
+    }
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TESTING_SCOPED_DIRECTORY_H_
+#define TESTING_SCOPED_DIRECTORY_H_
+
+#include <boost/filesystem.hpp>
+
+#include <string>
+
+namespace testing
+{
+// A unique path in the temporary directory that is removed, with everything
+// below it, when going out of scope. The directory itself is not created.
+struct ScopedDirectory
+{
+    explicit ScopedDirectory(const std::string& prefix = "media-hub")
+        : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path(prefix + "-%%%%-%%%%"))
+    {
+    }
+
+    ScopedDirectory(const ScopedDirectory&) = delete;
+
+    ~ScopedDirectory()
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(path, ec);
+    }
+
+    ScopedDirectory& operator=(const ScopedDirectory&) = delete;
+
+    boost::filesystem::path path;
+};
+}
+
+#endif // TESTING_SCOPED_DIRECTORY_H_
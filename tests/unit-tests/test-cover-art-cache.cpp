@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "core/media/cover_art_cache.h"
+
+#include "scoped_directory.h"
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+
+namespace media = core::ubuntu::media;
+
+namespace
+{
+void touch(const boost::filesystem::path& file)
+{
+    boost::filesystem::create_directories(file.parent_path());
+    std::ofstream out(file.string());
+}
+}
+
+TEST(CoverArtLru, evicts_the_least_recently_used_entry)
+{
+    media::detail::Lru lru(2);
+    lru.put("a", "1");
+    lru.put("b", "2");
+
+    std::string value;
+    EXPECT_TRUE(lru.get("a", value));
+    lru.put("c", "3");
+
+    EXPECT_EQ(2u, lru.size());
+    EXPECT_FALSE(lru.get("b", value));
+    EXPECT_TRUE(lru.get("a", value));
+    EXPECT_EQ("1", value);
+    EXPECT_TRUE(lru.get("c", value));
+    EXPECT_EQ("3", value);
+}
+
+TEST(CoverArtLru, put_replaces_and_refreshes_an_entry)
+{
+    media::detail::Lru lru(2);
+    lru.put("a", "1");
+    lru.put("b", "2");
+    lru.put("a", "10");
+    lru.put("c", "3");
+
+    std::string value;
+    EXPECT_FALSE(lru.get("b", value));
+    EXPECT_TRUE(lru.get("a", value));
+    EXPECT_EQ("10", value);
+}
+
+TEST(CoverArtLru, erase_forgets_an_entry)
+{
+    media::detail::Lru lru(2);
+    lru.put("a", "1");
+    lru.erase("a");
+    lru.erase("unknown");
+
+    std::string value;
+    EXPECT_FALSE(lru.get("a", value));
+    EXPECT_EQ(0u, lru.size());
+}
+
+TEST(CoverArtContentAddress, is_the_fnv1a_hash_as_16_hex_digits)
+{
+    EXPECT_EQ("cbf29ce484222325", media::detail::content_address(""));
+    EXPECT_EQ("af63dc4c8601ec8c", media::detail::content_address("a"));
+    EXPECT_EQ(media::detail::content_address(std::string("\0x", 2)), media::detail::content_address(std::string("\0x", 2)));
+    EXPECT_NE(media::detail::content_address(std::string("\0x", 2)), media::detail::content_address(std::string("\0y", 2)));
+}
+
+TEST(CoverArtFolder, ranks_the_usual_cover_names_regardless_of_case)
+{
+    EXPECT_GT(media::detail::cover_image_rank("cover.jpg"), media::detail::cover_image_rank("folder.jpg"));
+    EXPECT_GT(media::detail::cover_image_rank("folder.png"), media::detail::cover_image_rank("albumart.jpg"));
+    EXPECT_EQ(media::detail::cover_image_rank("cover.jpg"), media::detail::cover_image_rank("Cover.JPG"));
+    EXPECT_EQ(0, media::detail::cover_image_rank("track01.ogg"));
+    EXPECT_EQ(0, media::detail::cover_image_rank("cover.jpg.bak"));
+}
+
+TEST(CoverArtFolder, picks_the_best_ranked_image_of_a_folder)
+{
+    testing::ScopedDirectory dir;
+    touch(dir.path / "01 - Intro.ogg");
+    touch(dir.path / "albumart.jpg");
+    touch(dir.path / "Folder.jpg");
+    touch(dir.path / "notes.txt");
+
+    EXPECT_EQ(dir.path / "Folder.jpg", media::detail::best_cover_image_in(dir.path));
+}
+
+TEST(CoverArtFolder, finds_nothing_in_folders_without_cover_images)
+{
+    testing::ScopedDirectory dir;
+    touch(dir.path / "01 - Intro.ogg");
+
+    EXPECT_TRUE(media::detail::best_cover_image_in(dir.path).empty());
+    EXPECT_TRUE(media::detail::best_cover_image_in(dir.path / "missing").empty());
+}
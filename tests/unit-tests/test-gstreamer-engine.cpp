@@ -24,6 +24,7 @@
 
 #include "core/media/xesam.h"
 #include "core/media/gstreamer/engine.h"
+#include "core/media/gstreamer/playbin.h"
 
 #include "../test_data.h"
 #include "../waitable_state_transition.h"
@@ -32,10 +33,17 @@
 #include <gtest/gtest.h>
 
 #include <cstdio>
+#include <fstream>
+
+#include <sys/resource.h>
+#include <unistd.h>
 
 #include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 namespace media = core::ubuntu::media;
 
@@ -183,7 +191,8 @@ TEST(GStreamerEngine, setting_uri_and_audio_playback_with_http_headers_works)
 
             mg_send_file(conn, test_file.c_str(), 0);
             return MG_MORE;
-        }
+        },
+        {}
     };
 
     auto server = core::posix::fork(
@@ -347,6 +356,296 @@ TEST(GStreamerEngine, get_position_duration_work)
     EXPECT_TRUE(engine.duration() > 10e9);
 }
 
+TEST(GStreamerEngine, rapid_seeks_are_coalesced_and_report_landed_position)
+{
+    const std::string test_file{"/tmp/h264.avi"};
+    const std::string test_file_uri{"file:///tmp/h264.avi"};
+    std::remove(test_file.c_str());
+    ASSERT_TRUE(test::copy_test_avi_file_to(test_file));
+
+    core::testing::WaitableStateTransition<core::ubuntu::media::Engine::State> wst(
+                core::ubuntu::media::Engine::State::ready);
+
+    gstreamer::Engine engine;
+    engine.seek_accuracy().set(core::ubuntu::media::Engine::SeekAccuracy::accurate);
+
+    engine.state().changed().connect(
+                std::bind(
+                    &core::testing::WaitableStateTransition<core::ubuntu::media::Engine::State>::trigger,
+                    std::ref(wst),
+                    std::placeholders::_1));
+
+    std::mutex guard;
+    std::condition_variable cv;
+    std::vector<uint64_t> landed_positions;
+    engine.seeked_to_signal().connect([&](uint64_t value)
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        landed_positions.push_back(value);
+        cv.notify_all();
+    });
+
+    EXPECT_TRUE(engine.open_resource_for_uri(test_file_uri));
+    EXPECT_TRUE(engine.pause());
+    EXPECT_TRUE(wst.wait_for_state_for(
+                    core::ubuntu::media::Engine::State::paused,
+                    std::chrono::milliseconds{4000}));
+
+    // Emulate a client dragging a slider
+    static constexpr int seek_count = 50;
+    for (int i = 1; i <= seek_count; i++)
+        EXPECT_TRUE(engine.seek_to(std::chrono::milliseconds{i * 200}));
+
+    const uint64_t last_target = std::chrono::microseconds{std::chrono::milliseconds{seek_count * 200}}.count();
+
+    std::unique_lock<std::mutex> lk(guard);
+    EXPECT_TRUE(cv.wait_for(lk, std::chrono::seconds{10}, [&]()
+    {
+        return not landed_positions.empty() && landed_positions.back() >= last_target - 500000;
+    }));
+
+    std::cout << "Issued " << seek_count << " seeks, got " << landed_positions.size()
+              << " Seeked notifications" << std::endl;
+
+    // Seeks issued while one is in flight must be dropped in favour of the latest target
+    EXPECT_LT(landed_positions.size(), static_cast<std::size_t>(seek_count));
+}
+
+TEST(GStreamerEngine, changing_playback_rate_advances_position_accordingly)
+{
+    const std::string test_file{"/tmp/h264.avi"};
+    const std::string test_file_uri{"file:///tmp/h264.avi"};
+    std::remove(test_file.c_str());
+    ASSERT_TRUE(test::copy_test_avi_file_to(test_file));
+
+    core::testing::WaitableStateTransition<core::ubuntu::media::Engine::State> wst(
+                core::ubuntu::media::Engine::State::ready);
+
+    gstreamer::Engine engine;
+
+    engine.state().changed().connect(
+                std::bind(
+                    &core::testing::WaitableStateTransition<core::ubuntu::media::Engine::State>::trigger,
+                    std::ref(wst),
+                    std::placeholders::_1));
+
+    EXPECT_TRUE(engine.open_resource_for_uri(test_file_uri));
+    EXPECT_TRUE(engine.play());
+    EXPECT_TRUE(wst.wait_for_state_for(
+                    core::ubuntu::media::Engine::State::playing,
+                    std::chrono::milliseconds{4000}));
+
+    engine.playback_rate().set(2.);
+
+    const uint64_t start = engine.position().get();
+    std::this_thread::sleep_for(std::chrono::seconds{1});
+    const uint64_t end = engine.position().get();
+
+    std::cout << "Advanced by " << (end - start) << " ns in 1s at rate 2.0" << std::endl;
+
+    // Allow for some slack in the rate switch
+    EXPECT_GT(end - start, 1.5e9);
+}
+
+namespace
+{
+// Returns the time it takes to re-open and play the given uri after a stop
+std::chrono::microseconds measure_reopen_to_playing(gstreamer::Engine& engine, const std::string& uri)
+{
+    static constexpr int iterations = 5;
+
+    EXPECT_TRUE(engine.open_resource_for_uri(uri));
+    EXPECT_TRUE(engine.play());
+
+    std::chrono::microseconds total{0};
+    for (int i = 0; i < iterations; i++)
+    {
+        EXPECT_TRUE(engine.stop());
+
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_TRUE(engine.open_resource_for_uri(uri));
+        // play() only returns once the pipeline prerolled, i.e. the first
+        // buffer reached the audio sink
+        EXPECT_TRUE(engine.play());
+        total += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start);
+    }
+
+    return total / iterations;
+}
+}
+
+TEST(GStreamerEngine, reopen_latency_with_and_without_warm_stop)
+{
+    const std::string test_file{"/tmp/test.ogg"};
+    const std::string test_file_uri{"file:///tmp/test.ogg"};
+    std::remove(test_file.c_str());
+    ASSERT_TRUE(test::copy_test_ogg_file_to(test_file));
+
+    std::chrono::microseconds cold{0}, warm{0};
+    {
+        ::unsetenv("CORE_UBUNTU_MEDIA_SERVICE_WARM_STOP");
+        gstreamer::Engine engine;
+        cold = measure_reopen_to_playing(engine, test_file_uri);
+    }
+    {
+        ::setenv("CORE_UBUNTU_MEDIA_SERVICE_WARM_STOP", "1", 1);
+        gstreamer::Engine engine;
+        warm = measure_reopen_to_playing(engine, test_file_uri);
+        ::unsetenv("CORE_UBUNTU_MEDIA_SERVICE_WARM_STOP");
+    }
+
+    std::cout << "open -> playing, cold stop: " << cold.count() << " us, "
+              << "warm stop: " << warm.count() << " us" << std::endl;
+
+    // A warm stopped pipeline is re-opened from READY, skipping the
+    // NULL -> READY state change and thus the sink setup
+    {
+        ::setenv("CORE_UBUNTU_MEDIA_SERVICE_WARM_STOP", "1", 1);
+        gstreamer::Playbin playbin;
+        playbin.set_uri(test_file_uri);
+        EXPECT_EQ(GST_STATE_READY, GST_STATE(playbin.pipeline));
+        ::unsetenv("CORE_UBUNTU_MEDIA_SERVICE_WARM_STOP");
+    }
+    {
+        gstreamer::Playbin playbin;
+        playbin.set_uri(test_file_uri);
+        EXPECT_EQ(GST_STATE_NULL, GST_STATE(playbin.pipeline));
+    }
+}
+
+namespace
+{
+struct ResourceUsage
+{
+    std::chrono::microseconds cpu;
+    long rss_kb;
+};
+
+ResourceUsage measure_audio_playback_with_profile(const char* profile, const std::string& uri)
+{
+    ::setenv("CORE_UBUNTU_MEDIA_SERVICE_PIPELINE_PROFILE", profile, 1);
+
+    struct rusage before, after;
+    ::getrusage(RUSAGE_SELF, &before);
+
+    ResourceUsage usage{std::chrono::microseconds{0}, 0};
+    {
+        gstreamer::Engine engine;
+        EXPECT_TRUE(engine.open_resource_for_uri(uri));
+        EXPECT_TRUE(engine.play());
+        std::this_thread::sleep_for(std::chrono::seconds{2});
+
+        std::ifstream statm("/proc/self/statm");
+        long size = 0, resident = 0;
+        statm >> size >> resident;
+        usage.rss_kb = resident * (::sysconf(_SC_PAGESIZE) / 1024);
+
+        EXPECT_TRUE(engine.stop());
+    }
+
+    ::getrusage(RUSAGE_SELF, &after);
+    usage.cpu = std::chrono::seconds{after.ru_utime.tv_sec + after.ru_stime.tv_sec - before.ru_utime.tv_sec - before.ru_stime.tv_sec} +
+                std::chrono::microseconds{after.ru_utime.tv_usec + after.ru_stime.tv_usec - before.ru_utime.tv_usec - before.ru_stime.tv_usec};
+
+    ::unsetenv("CORE_UBUNTU_MEDIA_SERVICE_PIPELINE_PROFILE");
+    return usage;
+}
+
+gint playbin_flags_with_profile(const char* profile, const std::string& uri)
+{
+    ::setenv("CORE_UBUNTU_MEDIA_SERVICE_PIPELINE_PROFILE", profile, 1);
+
+    gstreamer::Playbin playbin;
+    playbin.set_uri(uri);
+
+    gint flags = 0;
+    g_object_get(playbin.pipeline, "flags", &flags, nullptr);
+
+    ::unsetenv("CORE_UBUNTU_MEDIA_SERVICE_PIPELINE_PROFILE");
+    return flags;
+}
+}
+
+TEST(GStreamerEngine, audio_only_profile_resource_usage)
+{
+    const std::string test_file{"/tmp/test.ogg"};
+    const std::string test_file_uri{"file:///tmp/test.ogg"};
+    std::remove(test_file.c_str());
+    ASSERT_TRUE(test::copy_test_ogg_file_to(test_file));
+    // Make sure a video sink is added to the pipeline
+    const EnsureFakeVideoSinkEnvVarIsSet efs;
+
+    auto video = measure_audio_playback_with_profile("video", test_file_uri);
+    auto audio_only = measure_audio_playback_with_profile("audio-only", test_file_uri);
+
+    std::cout << "video profile: " << video.cpu.count() << " us cpu, " << video.rss_kb << " kB rss" << std::endl;
+    std::cout << "audio-only profile: " << audio_only.cpu.count() << " us cpu, " << audio_only.rss_kb << " kB rss" << std::endl;
+
+    // The savings come from not building the video branches at all
+    const gint video_flags = playbin_flags_with_profile("video", test_file_uri);
+    EXPECT_TRUE(video_flags & gstreamer::Playbin::GST_PLAY_FLAG_VIDEO);
+    EXPECT_TRUE(video_flags & gstreamer::Playbin::GST_PLAY_FLAG_AUDIO);
+
+    const gint audio_only_flags = playbin_flags_with_profile("audio-only", test_file_uri);
+    EXPECT_FALSE(audio_only_flags & gstreamer::Playbin::GST_PLAY_FLAG_VIDEO);
+    EXPECT_FALSE(audio_only_flags & gstreamer::Playbin::GST_PLAY_FLAG_VIS);
+    EXPECT_FALSE(audio_only_flags & gstreamer::Playbin::GST_PLAY_FLAG_TEXT);
+    EXPECT_TRUE(audio_only_flags & gstreamer::Playbin::GST_PLAY_FLAG_AUDIO);
+}
+
+namespace
+{
+long resident_set_size_kb()
+{
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * (::sysconf(_SC_PAGESIZE) / 1024);
+}
+}
+
+TEST(GStreamerEngine, hibernating_idle_engines_releases_memory_and_restores_position)
+{
+    const std::string test_file{"/tmp/test.ogg"};
+    const std::string test_file_uri{"file:///tmp/test.ogg"};
+    std::remove(test_file.c_str());
+    ASSERT_TRUE(test::copy_test_ogg_file_to(test_file));
+
+    static constexpr std::size_t session_count = 100;
+
+    const long rss_baseline = resident_set_size_kb();
+
+    std::vector<std::unique_ptr<gstreamer::Engine>> engines;
+    for (std::size_t i = 0; i < session_count; i++)
+    {
+        engines.emplace_back(new gstreamer::Engine());
+        EXPECT_TRUE(engines.back()->open_resource_for_uri(test_file_uri));
+        EXPECT_TRUE(engines.back()->pause());
+        EXPECT_TRUE(engines.back()->seek_to(std::chrono::seconds{1}));
+    }
+
+    // Let the seeks settle
+    std::this_thread::sleep_for(std::chrono::seconds{1});
+    const long rss_idle = resident_set_size_kb();
+
+    for (auto& engine : engines)
+        EXPECT_TRUE(engine->hibernate());
+
+    const long rss_hibernated = resident_set_size_kb();
+
+    std::cout << session_count << " idle sessions: " << (rss_idle - rss_baseline) << " kB, "
+              << "hibernated: " << (rss_hibernated - rss_baseline) << " kB" << std::endl;
+
+    // Position is still reported while hibernated and restored on play
+    auto& engine = engines.front();
+    EXPECT_TRUE(engine->is_hibernated());
+    EXPECT_GE(engine->position().get(), 9e8);
+    EXPECT_TRUE(engine->play());
+    EXPECT_FALSE(engine->is_hibernated());
+    EXPECT_GE(engine->position().get(), 9e8);
+}
+
 TEST(GStreamerEngine, adjusting_volume_works)
 {
     const std::string test_file{"/tmp/test.mp3"};
@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/metrics.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace metrics = core::ubuntu::media::metrics;
+
+TEST(Metrics, counter_sums_increments_from_all_threads)
+{
+    auto& counter = metrics::counter("test.counter");
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 16; i++)
+        threads.emplace_back([&counter]() { for (int j = 0; j < 1000; j++) counter.increment(); });
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(16000u, counter.value());
+}
+
+TEST(Metrics, histogram_buckets_bound_the_relative_error)
+{
+    for (std::uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 1000ull, 123456ull, 1ull << 39})
+    {
+        const auto bucket = metrics::Histogram::bucket_for(value);
+        ASSERT_LT(bucket, metrics::Histogram::bucket_count);
+
+        const double reported = metrics::Histogram::value_for(bucket);
+        EXPECT_LE(std::abs(reported - value), 0.07 * value) << value;
+    }
+}
+
+TEST(Metrics, histogram_reports_percentiles)
+{
+    auto& histogram = metrics::histogram("test.histogram");
+    for (std::uint64_t i = 1; i <= 1000; i++)
+        histogram.record(i);
+
+    auto summary = histogram.summary();
+    EXPECT_EQ(1000u, summary.count);
+    EXPECT_EQ(1000u, summary.max);
+    EXPECT_NEAR(500, summary.p50, 500 * 0.07);
+    EXPECT_NEAR(990, summary.p99, 990 * 0.07);
+}
+
+TEST(Metrics, snapshot_contains_all_metrics)
+{
+    metrics::counter("test.snapshot.counter").increment(3);
+    metrics::gauge("test.snapshot.gauge").set(-2);
+    metrics::histogram("test.snapshot.histogram").record(42);
+
+    auto snapshot = metrics::Registry::instance().snapshot();
+    EXPECT_EQ(3., snapshot.at("test.snapshot.counter"));
+    EXPECT_EQ(-2., snapshot.at("test.snapshot.gauge"));
+    EXPECT_EQ(1., snapshot.at("test.snapshot.histogram.count"));
+}
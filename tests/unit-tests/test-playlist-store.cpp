@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "core/media/playlist_store.h"
+
+#include "scoped_directory.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace media = core::ubuntu::media;
+
+namespace
+{
+std::vector<std::string> names_of(const std::vector<media::PlaylistStore::Playlist>& playlists)
+{
+    std::vector<std::string> names;
+    for (const auto& p : playlists)
+        names.push_back(p.name);
+    return names;
+}
+}
+
+TEST(PlaylistStore, pages_through_playlists_in_alphabetical_order)
+{
+    testing::ScopedDirectory dir;
+    media::PlaylistStore store{dir.path.string()};
+
+    for (const auto& name : {"delta", "Alpha", "charlie", "bravo", "echo"})
+        store.create(name, {});
+
+    EXPECT_EQ(5u, store.count());
+
+    const auto ordering = media::PlaylistStore::Ordering::alphabetical;
+    EXPECT_EQ((std::vector<std::string>{"Alpha", "bravo"}), names_of(store.playlists(0, 2, ordering, false)));
+    EXPECT_EQ((std::vector<std::string>{"charlie", "delta"}), names_of(store.playlists(2, 2, ordering, false)));
+    EXPECT_EQ((std::vector<std::string>{"echo"}), names_of(store.playlists(4, 2, ordering, false)));
+    EXPECT_TRUE(store.playlists(5, 2, ordering, false).empty());
+    EXPECT_EQ((std::vector<std::string>{"echo", "delta"}), names_of(store.playlists(0, 2, ordering, true)));
+}
+
+TEST(PlaylistStore, renaming_reorders_a_playlist)
+{
+    testing::ScopedDirectory dir;
+    media::PlaylistStore store{dir.path.string()};
+
+    auto a = store.create("a", {});
+    store.create("b", {});
+
+    EXPECT_TRUE(store.rename(a, "c"));
+    EXPECT_EQ((std::vector<std::string>{"b", "c"}),
+              names_of(store.playlists(0, 10, media::PlaylistStore::Ordering::alphabetical, false)));
+    EXPECT_FALSE(store.rename(a + 100, "d"));
+}
+
+TEST(PlaylistStore, playlists_and_tracks_survive_a_reload)
+{
+    testing::ScopedDirectory dir;
+    const std::vector<media::Track::UriType> tracks{"file:///tmp/a.ogg", "file:///tmp/b.ogg"};
+
+    media::PlaylistStore::Id id;
+    {
+        media::PlaylistStore store{dir.path.string()};
+        id = store.create("road trip", tracks, "file:///tmp/icon.png");
+        store.create("removed", tracks);
+        EXPECT_TRUE(store.remove(id + 1));
+        EXPECT_TRUE(store.mark_played(id));
+    }
+
+    media::PlaylistStore store{dir.path.string()};
+    ASSERT_EQ(1u, store.count());
+
+    media::PlaylistStore::Playlist p;
+    ASSERT_TRUE(store.lookup(id, p));
+    EXPECT_EQ("road trip", p.name);
+    EXPECT_EQ("file:///tmp/icon.png", p.icon);
+    EXPECT_EQ(2u, p.track_count);
+    EXPECT_NE(0, p.last_played);
+    EXPECT_EQ(tracks, store.tracks(id));
+    EXPECT_TRUE(store.tracks(id + 1).empty());
+
+    // Ids are never handed out twice
+    EXPECT_GT(store.create("another", {}), id + 1);
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/property_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace media = core::ubuntu::media;
+
+TEST(CachedProperty, serves_reads_from_the_cache_until_it_expires)
+{
+    int fetches = 0;
+    media::CachedProperty<int> cached{[&fetches]() { return ++fetches; }, std::chrono::hours{1}};
+
+    EXPECT_EQ(1, cached.local().get());
+    EXPECT_EQ(1, cached.local().get());
+    EXPECT_EQ(1, fetches);
+
+    cached.invalidate();
+    EXPECT_EQ(2, cached.local().get());
+    EXPECT_EQ(2, fetches);
+}
+
+TEST(CachedProperty, pushed_values_notify_subscribers)
+{
+    media::CachedProperty<int> cached{[]() { return 0; }, media::CachedProperty<int>::pushed_only()};
+
+    std::vector<int> seen;
+    core::ScopedConnection connection
+    {
+        cached.local().changed().connect([&seen](int value) { seen.push_back(value); })
+    };
+
+    cached.update(1);
+    cached.update(1);
+    cached.update(2);
+
+    EXPECT_EQ((std::vector<int>{1, 2}), seen);
+    EXPECT_EQ(2, cached.local().get());
+}
+
+TEST(CachedProperty, fetched_values_notify_subscribers)
+{
+    int remote = 1;
+    media::CachedProperty<int> cached{[&remote]() { return remote; }, std::chrono::hours{1}};
+
+    std::vector<int> seen;
+    core::ScopedConnection connection
+    {
+        cached.local().changed().connect([&seen](int value) { seen.push_back(value); })
+    };
+
+    EXPECT_EQ(1, cached.local().get());
+    remote = 3;
+    cached.invalidate();
+    EXPECT_EQ(3, cached.local().get());
+
+    EXPECT_EQ((std::vector<int>{1, 3}), seen);
+}
+
+TEST(InterpolatedPosition, seeks_notify_subscribers)
+{
+    media::InterpolatedPosition position
+    {
+        media::InterpolatedPosition::Configuration
+        {
+            []() { return std::int64_t{0}; },
+            []() { return false; },
+            []() { return 1.; },
+            []() { return std::int64_t{0}; },
+            std::chrono::hours{1}
+        }
+    };
+
+    std::vector<std::int64_t> seen;
+    core::ScopedConnection connection
+    {
+        position.local().changed().connect([&seen](std::int64_t value) { seen.push_back(value); })
+    };
+
+    position.update(42);
+
+    EXPECT_EQ((std::vector<std::int64_t>{42}), seen);
+    EXPECT_EQ(42, position.local().get());
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/scheduling.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <sched.h>
+
+namespace media = core::ubuntu::media;
+namespace scheduling = core::ubuntu::media::scheduling;
+
+TEST(Scheduling, roles_map_to_their_classes)
+{
+    EXPECT_EQ(scheduling::Class::alarm, scheduling::class_for_role(media::Player::AudioStreamRole::alarm));
+    EXPECT_EQ(scheduling::Class::alert, scheduling::class_for_role(media::Player::AudioStreamRole::alert));
+    EXPECT_EQ(scheduling::Class::multimedia, scheduling::class_for_role(media::Player::AudioStreamRole::multimedia));
+    EXPECT_EQ(scheduling::Class::phone, scheduling::class_for_role(media::Player::AudioStreamRole::phone));
+}
+
+TEST(Scheduling, parsing_overrides_the_given_classes_only)
+{
+    auto table = scheduling::default_table();
+    ASSERT_TRUE(scheduling::parse("phone=fifo:20;multimedia=nice:-5,cpus:0-1,cpus:4;background=idle,nice:10", table));
+
+    EXPECT_EQ(scheduling::Policy::Scheduler::fifo, table[scheduling::Class::phone].scheduler);
+    EXPECT_EQ(20, table[scheduling::Class::phone].rt_priority);
+
+    EXPECT_EQ(scheduling::Policy::Scheduler::other, table[scheduling::Class::multimedia].scheduler);
+    EXPECT_EQ(-5, table[scheduling::Class::multimedia].nice);
+    EXPECT_EQ((std::vector<int>{0, 1, 4}), table[scheduling::Class::multimedia].cpus);
+
+    EXPECT_EQ(scheduling::Policy::Scheduler::idle, table[scheduling::Class::background].scheduler);
+    EXPECT_EQ(10, table[scheduling::Class::background].nice);
+
+    EXPECT_EQ(-10, table[scheduling::Class::alarm].nice);
+}
+
+TEST(Scheduling, malformed_policies_leave_the_table_untouched)
+{
+    const auto defaults = scheduling::default_table();
+
+    for (const auto& spec : {"phone", "unknown=nice:1", "alarm=nice:x", "alarm=cpus:3-1", "alarm=turbo:1", "alarm=nice:-1;alert=fifo"})
+    {
+        auto table = defaults;
+        EXPECT_FALSE(scheduling::parse(spec, table)) << spec;
+        EXPECT_EQ(defaults.at(scheduling::Class::alarm).nice, table.at(scheduling::Class::alarm).nice) << spec;
+        EXPECT_EQ(defaults.at(scheduling::Class::alert).scheduler, table.at(scheduling::Class::alert).scheduler) << spec;
+    }
+}
+
+TEST(Scheduling, background_threads_are_demoted_to_idle)
+{
+    int policy = -1;
+    std::thread t([&policy]()
+    {
+        // Demoting a thread never needs privileges
+        EXPECT_TRUE(scheduling::apply(scheduling::Class::background));
+        policy = sched_getscheduler(0);
+    });
+    t.join();
+
+    EXPECT_EQ(SCHED_IDLE, policy);
+}
+
+TEST(Scheduling, reversibility_matches_resetting_a_thread)
+{
+    bool reset = false;
+    std::thread t([&reset]()
+    {
+        scheduling::apply(scheduling::Class::background);
+        reset = scheduling::reset();
+    });
+    t.join();
+
+    EXPECT_EQ(reset, scheduling::reversible(scheduling::Class::background));
+    // Going back to the nice level of the process never needs privileges
+    EXPECT_TRUE(scheduling::reversible(scheduling::Class::multimedia));
+}
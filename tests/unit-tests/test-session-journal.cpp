@@ -0,0 +1,133 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/session_journal.h"
+#include "core/media/metrics.h"
+
+#include "scoped_directory.h"
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace media = core::ubuntu::media;
+
+namespace
+{
+// Long enough that only explicit flushes write
+constexpr std::chrono::milliseconds never{std::chrono::hours{1}};
+}
+
+TEST(SessionJournal, restores_checkpointed_sessions)
+{
+    testing::ScopedDirectory dir;
+    const auto path = (dir.path / "sessions").string();
+
+    media::SessionJournal::Session session
+    {
+        42,
+        "music",
+        "file:///music/b.ogg",
+        std::chrono::microseconds{123456789},
+        {"file:///music/a.ogg", "file:///music/b.ogg", "file:///music/c.ogg"},
+        media::Player::AudioStreamRole::alarm,
+        0.25
+    };
+
+    {
+        media::SessionJournal journal{path, never};
+        EXPECT_TRUE(journal.sessions().empty());
+        journal.checkpoint(session);
+    }
+
+    media::SessionJournal journal{path, never};
+    auto sessions = journal.sessions();
+    ASSERT_EQ(1u, sessions.size());
+    EXPECT_EQ(session.key, sessions[0].key);
+    EXPECT_EQ(session.name, sessions[0].name);
+    EXPECT_EQ(session.uri, sessions[0].uri);
+    EXPECT_EQ(session.position, sessions[0].position);
+    EXPECT_EQ(session.tracks, sessions[0].tracks);
+    EXPECT_EQ(session.role, sessions[0].role);
+    EXPECT_DOUBLE_EQ(session.volume, sessions[0].volume);
+}
+
+TEST(SessionJournal, coalesces_checkpoints_of_a_session)
+{
+    testing::ScopedDirectory dir;
+    media::SessionJournal journal{(dir.path / "sessions").string(), never};
+
+    auto& writes = media::metrics::counter("journal.writes");
+    const auto writes_before = writes.value();
+
+    media::SessionJournal::Session session{1, "a", "file:///a.ogg", std::chrono::microseconds{0}, {}, media::Player::multimedia, 1.};
+    for (int i = 0; i < 100; i++)
+    {
+        session.position = std::chrono::microseconds{i};
+        journal.checkpoint(session);
+    }
+
+    journal.flush();
+    EXPECT_EQ(writes_before + 1, writes.value());
+
+    journal.flush();
+    EXPECT_EQ(writes_before + 1, writes.value());
+
+    auto sessions = journal.sessions();
+    ASSERT_EQ(1u, sessions.size());
+    EXPECT_EQ(std::chrono::microseconds{99}, sessions[0].position);
+}
+
+TEST(SessionJournal, forgotten_sessions_are_dropped)
+{
+    testing::ScopedDirectory dir;
+    const auto path = (dir.path / "sessions").string();
+
+    {
+        media::SessionJournal journal{path, never};
+        for (media::Player::PlayerKey key = 0; key < 3; key++)
+            journal.checkpoint({key, "", "", std::chrono::microseconds{0}, {}, media::Player::multimedia, 1.});
+        journal.flush();
+
+        journal.forget(0);
+        journal.checkpoint({3, "", "", std::chrono::microseconds{0}, {}, media::Player::multimedia, 1.});
+        journal.forget(3);
+        journal.forget(1);
+    }
+
+    media::SessionJournal journal{path, never};
+    auto sessions = journal.sessions();
+    ASSERT_EQ(1u, sessions.size());
+    EXPECT_EQ(2u, sessions[0].key);
+}
+
+TEST(SessionJournal, ignores_a_corrupt_journal)
+{
+    testing::ScopedDirectory dir;
+    boost::filesystem::create_directories(dir.path);
+    const auto path = (dir.path / "sessions").string();
+    {
+        std::ofstream out(path);
+        out << "not a journal";
+    }
+
+    media::SessionJournal journal{path, never};
+    EXPECT_TRUE(journal.sessions().empty());
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2014 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/trace.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace trace = core::ubuntu::media::trace;
+
+TEST(Trace, disabled_trace_records_nothing)
+{
+    trace::clear();
+    trace::set_enabled(false);
+
+    {
+        trace::Scope scope{"test", "disabled_scope"};
+    }
+
+    EXPECT_EQ(std::string::npos, trace::to_chrome_json().find("disabled_scope"));
+}
+
+TEST(Trace, scopes_of_all_threads_end_up_in_chrome_json)
+{
+    trace::clear();
+    trace::set_enabled(true);
+
+    {
+        trace::Scope scope{"test", "main_thread_scope"};
+    }
+    std::thread([]() { trace::Scope scope{"test", "worker_thread_scope"}; }).join();
+    trace::instant("test", "instant_event");
+
+    trace::set_enabled(false);
+
+    auto json = trace::to_chrome_json();
+    EXPECT_EQ(0u, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"main_thread_scope\",\"cat\":\"test\",\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"worker_thread_scope\",\"cat\":\"test\",\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"instant_event\",\"cat\":\"test\",\"ph\":\"i\""));
+}
+
+TEST(Trace, ring_keeps_the_most_recent_events)
+{
+    trace::clear();
+    trace::set_enabled(true);
+
+    trace::instant("test", "oldest_event");
+    for (std::size_t i = 0; i < trace::ring_capacity; i++)
+        trace::instant("test", "filler");
+
+    trace::set_enabled(false);
+
+    EXPECT_EQ(std::string::npos, trace::to_chrome_json().find("oldest_event"));
+}
+
+TEST(Trace, events_of_exited_threads_are_kept_until_dumped)
+{
+    trace::clear();
+    trace::set_enabled(true);
+
+    std::thread([]() { trace::instant("test", "first_thread_event"); }).join();
+    std::thread([]() { trace::instant("test", "second_thread_event"); }).join();
+
+    trace::set_enabled(false);
+
+    auto json = trace::to_chrome_json();
+    EXPECT_NE(std::string::npos, json.find("first_thread_event"));
+    EXPECT_NE(std::string::npos, json.find("second_thread_event"));
+}
+
+TEST(Trace, only_the_most_recently_exited_threads_are_kept)
+{
+    trace::clear();
+    trace::set_enabled(true);
+
+    std::thread([]() { trace::instant("test", "earliest_thread_event"); }).join();
+    for (std::size_t i = 0; i < trace::max_retired_rings; i++)
+        std::thread([]() { trace::instant("test", "later_thread_event"); }).join();
+    std::thread([]() { trace::instant("test", "latest_thread_event"); }).join();
+
+    trace::set_enabled(false);
+
+    auto json = trace::to_chrome_json();
+    EXPECT_EQ(std::string::npos, json.find("earliest_thread_event"));
+    EXPECT_NE(std::string::npos, json.find("latest_thread_event"));
+}
+
+TEST(Trace, rings_of_exited_threads_are_reused)
+{
+    trace::clear();
+    trace::set_enabled(true);
+
+    std::thread([]() { trace::instant("test", "first_thread_event"); }).join();
+    EXPECT_NE(std::string::npos, trace::to_chrome_json().find("first_thread_event"));
+
+    // Takes over the ring of the first thread
+    std::thread([]() { trace::instant("test", "second_thread_event"); }).join();
+
+    trace::set_enabled(false);
+
+    auto json = trace::to_chrome_json();
+    EXPECT_EQ(std::string::npos, json.find("first_thread_event"));
+    EXPECT_NE(std::string::npos, json.find("second_thread_event"));
+}
@@ -42,6 +42,10 @@ struct Configuration
     std::uint16_t port;
     // Function that is invoked for individual client requests.
     std::function<int(mg_connection*)> request_handler;
+    // Function that is invoked periodically for every connection whose request
+    // handler returned MG_MORE, allows for streaming replies. Return MG_TRUE once
+    // the reply is complete. Might be empty.
+    std::function<int(mg_connection*)> poll_handler;
 };
 }
 }
@@ -72,6 +76,8 @@ inline std::function<core::posix::exit::Status(core::testing::CrossProcessSync&
                 {
                 case MG_REQUEST:
                     return thiz->handle_request(conn);
+                case MG_POLL:
+                    return thiz->handle_poll(conn);
                 case MG_AUTH:
                     return MG_TRUE;
                 default:
@@ -86,6 +92,11 @@ inline std::function<core::posix::exit::Status(core::testing::CrossProcessSync&
                 return configuration.request_handler(conn);
             }
 
+            int handle_poll(mg_connection* conn)
+            {
+                return configuration.poll_handler ? configuration.poll_handler(conn) : MG_FALSE;
+            }
+
             const testing::web::server::Configuration& configuration;
         } context{configuration};
 
@@ -105,7 +116,8 @@ inline std::function<core::posix::exit::Status(core::testing::CrossProcessSync&
         // Start the polling loop
         for (;;)
         {
-            mg_poll_server(server, 200);
+            // Short enough for streaming replies to be paced accurately
+            mg_poll_server(server, 5);
 
             if (terminated)
                 break;